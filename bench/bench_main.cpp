@@ -0,0 +1,887 @@
+/**********************************************************************************************
+*
+*   raylib_ECS_sample * a sample Entity Component System using raylib
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+
+// headless benchmarks for the core entity operations
+//
+// rlECS_bench [--sizes 1000,10000] [--iterations 5] [--out results.json] [--baseline baseline.json] [--threshold 10]
+// rlECS_bench --flythrough [--world 16,2000] [--frames 600] [--out results.json]
+
+#include "entity_manager.h"
+#include "prefab.h"
+#include "profiler.h"
+#include "render_backend.h"
+#include "scene_file.h"
+#include "system_manager.h"
+#include "world_partition.h"
+#include "components/automover_component.h"
+#include "components/camera_component.h"
+#include "components/drawable_component.h"
+#include "components/light_component.h"
+#include "components/prefab_instance_component.h"
+#include "components/transform_component.h"
+#include "components/world_cell_component.h"
+#include "systems/light_clusterer.h"
+#include "systems/lighting_system.h"
+#include "systems/occlusion_culler.h"
+#include "systems/render_system.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <math.h>
+#include <memory>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "raymath.h"
+
+struct BenchResult
+{
+    std::string Name;
+    size_t Size = 0;
+    size_t Iterations = 0;
+    double MinMs = 0;
+    double MedianMs = 0;
+    double NsPerOp = 0;
+
+    // what a case counted in its last run, written out next to the times
+    std::vector<std::pair<std::string, double>> Counters;
+};
+
+struct BenchOptions
+{
+    std::vector<size_t> Sizes = { 1000, 10000, 100000, 1000000 };
+    size_t Iterations = 5;
+    std::string OutputFile;
+    std::string BaselineFile;
+    double Threshold = 10;
+
+    // fly a camera through a streamed world instead of running the cases
+    bool Flythrough = false;
+    size_t WorldCells = 16;         // on each side
+    size_t CellEntities = 2000;
+    size_t Frames = 600;
+};
+
+// a fresh set for every run, setup is not timed
+struct BenchCase
+{
+    const char* Name = nullptr;
+    std::function<void(EntitySet& entities, std::vector<EntityId_t>& ids, size_t count)> Setup;
+    std::function<void(EntitySet& entities, std::vector<EntityId_t>& ids, size_t count)> Run;
+};
+
+// keeps the optimizer from dropping loops that only read
+static volatile float Sink = 0;
+
+// cases that know what their result should be count the runs where it wasn't, any of them fails the run
+static size_t CheckFailures = 0;
+
+static void BenchCheck(bool ok, const char* name, const char* what)
+{
+    if (ok)
+        return;
+
+    fprintf(stderr, "%s: %s\n", name, what);
+    CheckFailures++;
+}
+
+// counters a case reports from its run, they are cleared before every run
+static std::vector<std::pair<std::string, double>> RunCounters;
+
+static void ReportCounter(const char* name, double value)
+{
+    RunCounters.emplace_back(name, value);
+}
+
+static void CreateEntities(EntitySet& entities, std::vector<EntityId_t>& ids, size_t count)
+{
+    ids.resize(count);
+    for (size_t i = 0; i < count; i++)
+        ids[i] = entities.CreateEntity();
+}
+
+static void CreateTransforms(EntitySet& entities, std::vector<EntityId_t>& ids, size_t count)
+{
+    ids.resize(count);
+    for (size_t i = 0; i < count; i++)
+        ids[i] = entities.AddComponent<TransformComponent>()->EntityId;
+}
+
+static void CreateMovers(EntitySet& entities, std::vector<EntityId_t>& ids, size_t count)
+{
+    CreateTransforms(entities, ids, count);
+    for (EntityId_t id : ids)
+        entities.AddComponent<AutoMoverComponent>(id)->AngularSpeed.y = 90;
+}
+
+// a tree with a fan out of 4, every entity after the first is a child of an earlier one
+static void CreateHierarchy(EntitySet& entities, std::vector<EntityId_t>& ids, size_t count)
+{
+    CreateTransforms(entities, ids, count);
+    for (size_t i = 1; i < count; i++)
+        entities.ReparentEntity(ids[i], ids[(i - 1) / 4]);
+}
+
+// a hierarchy of movers, written out so the load case has a file to read
+static const char* SceneBenchFile = "rlECS_bench_scene.rlsc";
+
+static void CreateScene(EntitySet& entities, std::vector<EntityId_t>& ids, size_t count)
+{
+    CreateHierarchy(entities, ids, count);
+    for (EntityId_t id : ids)
+        entities.AddComponent<AutoMoverComponent>(id)->AngularSpeed.y = 90;
+}
+
+// a root with 19 children in two levels, each with a transform and a shape, spawned count / 20 times
+static constexpr size_t PrefabBenchEntities = 20;
+static Prefab BenchPrefab;
+
+static void CreatePrefab(EntitySet& entities, std::vector<EntityId_t>& ids, size_t)
+{
+    EntityId_t root = entities.AddComponent<TransformComponent>()->EntityId;
+    entities.AddComponent<ShapeComponent>(root);
+    ids.push_back(root);
+
+    for (size_t i = 1; i < PrefabBenchEntities; i++)
+    {
+        EntityId_t child = entities.AddChild(ids[(i - 1) / 4]);
+        entities.AddComponent<TransformComponent>(child)->SetPosition(float(i), 0, 0);
+        entities.AddComponent<ShapeComponent>(child)->ObjectSize = Vector3{ float(i), 1, 1 };
+        ids.push_back(child);
+    }
+
+    BenchPrefab.Capture(entities, root);
+}
+
+// a camera looking down -z at a wall across the whole view, half the boxes are in front of it and half behind
+static OcclusionCuller BenchCuller;
+static std::vector<BoundingBox> CullBoxes;
+static size_t CullFrontBoxes = 0;
+
+static Matrix GetBenchViewProjection(int width, int height)
+{
+    Matrix projection = MatrixPerspective(60 * DEG2RAD, double(width) / double(height), 0.1, 500);
+    return MatrixMultiply(MatrixLookAt(Vector3{ 0, 3, 20 }, Vector3{ 0, 3, 0 }, Vector3{ 0, 1, 0 }), projection);
+}
+
+static void CreateCullBoxes(EntitySet&, std::vector<EntityId_t>&, size_t count)
+{
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> unit(0, 1);
+
+    CullBoxes.clear();
+    CullFrontBoxes = count / 2;
+    for (size_t i = 0; i < count; i++)
+    {
+        // in front the boxes stay inside the view, behind they spread past it so some are culled by the frustum
+        Vector3 min = i < CullFrontBoxes
+            ? Vector3{ unit(random) * 8 - 4, unit(random) * 4, 3 + unit(random) * 8 }
+            : Vector3{ unit(random) * 60 - 30, unit(random) * 6, -2 - unit(random) * 50 };
+        CullBoxes.push_back(BoundingBox{ min, Vector3Add(min, Vector3{ 1, 1, 1 }) });
+    }
+}
+
+// a grid of shapes in front of a camera, lit by a few point lights, drawn into a backend that only counts
+static constexpr size_t RenderBenchLights = 16;
+static constexpr int RenderBenchWidth = 1280;
+static constexpr int RenderBenchHeight = 720;
+
+static RecordingRenderBackend BenchBackend;
+static std::unique_ptr<SystemSet> BenchSystems;
+static RenderSnapshot BenchSnapshot;
+static EntityId_t BenchCamera = InvalidEntityId;
+
+static void CreateRenderScene(EntitySet& entities, std::vector<EntityId_t>& ids, size_t count)
+{
+    BenchBackend.KeepCommands = false;
+    BenchBackend.ScreenWidth = RenderBenchWidth;
+    BenchBackend.ScreenHeight = RenderBenchHeight;
+    RenderBackend::Set(&BenchBackend);
+
+    // replaced here so freeing the last ones isn't timed
+    BenchSystems = std::make_unique<SystemSet>(entities);
+    BenchSystems->GetSystem<LightingSystem>()->Setup();
+
+    TransformComponent* camera = entities.AddComponent<TransformComponent>();
+    camera->AddComponent<CameraComponent>();
+    camera->SetPosition(0, 20, -20);
+    BenchCamera = camera->EntityId;
+
+    size_t side = size_t(ceil(sqrt(double(count))));
+    ids.resize(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        TransformComponent* transform = entities.AddComponent<TransformComponent>();
+        transform->SetPosition(float(i % side) - side * 0.5f, 0, float(i / side));
+
+        ShapeComponent* shape = entities.AddComponent<ShapeComponent>(transform->EntityId);
+        shape->ObjectShape = DrawShape(i % 3);
+        shape->ObjectSize = Vector3{ 0.5f, 0.5f, 0.5f };
+        ids[i] = transform->EntityId;
+    }
+
+    for (size_t i = 0; i < RenderBenchLights; i++)
+    {
+        LightComponent* light = entities.AddComponent<LightComponent>();
+        light->Range = 20;
+        light->MustGetComponent<TransformComponent>()->SetPosition(float(i % 4) * 20 - 30, 5, float(i / 4) * side * 0.25f);
+    }
+
+    BenchSnapshot.Clear();
+    BenchBackend.Reset();
+}
+
+// point lights scattered through the view of a fixed camera, the size is the number of lights
+static LightClusterer BenchClusterer;
+static std::vector<RenderLight> BenchLights;
+
+static void CreateBenchLights(EntitySet&, std::vector<EntityId_t>&, size_t count)
+{
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> unit(0, 1);
+
+    BenchLights.resize(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        RenderLight& light = BenchLights[i];
+        light.Slot = int(i);
+        light.Type = int(LightTypes::POINT);
+        light.Position = Vector3{ unit(random) * 120 - 60, unit(random) * 20, unit(random) * 200 };
+        light.Range = 2 + unit(random) * 6;
+    }
+
+    Camera3D camera = { 0 };
+    camera.position = Vector3{ 0, 5, -10 };
+    camera.target = Vector3{ 0, 5, 0 };
+    camera.up = Vector3{ 0, 1, 0 };
+    camera.fovy = 45;
+    BenchClusterer.Setup(camera, float(RenderBenchWidth) / float(RenderBenchHeight), 0.1f, 500);
+}
+
+// the set a scene is loaded into, replaced during setup so freeing the last one isn't timed
+static std::unique_ptr<EntitySet> LoadedScene;
+
+// the main thread time given to a streaming load each frame
+static constexpr double StreamingBudgetMs = 4;
+
+// a saver that has already written the scene once, so the timed save only writes what changed
+static std::unique_ptr<SceneFile::IncrementalSaver> BenchSaver;
+static constexpr size_t IncrementalSaveEdits = 64;
+
+static std::vector<BenchCase> GetCases()
+{
+    std::vector<BenchCase> cases;
+
+    cases.push_back({ "create_entities", nullptr, CreateEntities });
+
+    cases.push_back({ "destroy_entities", CreateTransforms, [](EntitySet& entities, std::vector<EntityId_t>& ids, size_t)
+        {
+            for (EntityId_t id : ids)
+                entities.RemoveEntity(id);
+        } });
+
+    cases.push_back({ "add_components", CreateEntities, [](EntitySet& entities, std::vector<EntityId_t>& ids, size_t)
+        {
+            for (EntityId_t id : ids)
+                entities.AddComponent<TransformComponent>(id);
+        } });
+
+    cases.push_back({ "remove_components", CreateTransforms, [](EntitySet& entities, std::vector<EntityId_t>& ids, size_t)
+        {
+            for (EntityId_t id : ids)
+                entities.RemoveComponents<TransformComponent>(id);
+        } });
+
+    cases.push_back({ "iterate_single", CreateTransforms, [](EntitySet& entities, std::vector<EntityId_t>&, size_t)
+        {
+            float sum = 0;
+            entities.DoForEachEntity<TransformComponent>([&sum](TransformComponent* transform) { sum += transform->GetPosition().x; });
+            Sink = sum;
+        } });
+
+    cases.push_back({ "iterate_multi", CreateMovers, [](EntitySet& entities, std::vector<EntityId_t>&, size_t)
+        {
+            float sum = 0;
+            entities.DoForEachEntity<AutoMoverComponent>([&sum, &entities](AutoMoverComponent* mover)
+                {
+                    TransformComponent* transform = entities.GetComponent<TransformComponent>(mover->EntityId);
+                    sum += transform->GetPosition().x + mover->AngularSpeed.y;
+                });
+            Sink = sum;
+        } });
+
+    cases.push_back({ "reparent", CreateTransforms, [](EntitySet& entities, std::vector<EntityId_t>& ids, size_t count)
+        {
+            // parents always come earlier in the list, so there are no cycles
+            std::mt19937 random(1234);
+            for (size_t i = 1; i < count; i++)
+                entities.ReparentEntity(ids[i], ids[random() % i]);
+        } });
+
+    cases.push_back({ "transform_propagation", CreateHierarchy, [](EntitySet& entities, std::vector<EntityId_t>& ids, size_t)
+        {
+            // moving the root dirties the whole tree, then every world matrix is rebuilt
+            entities.GetComponent<TransformComponent>(ids[0])->SetPosition(1, 2, 3);
+
+            float sum = 0;
+            for (EntityId_t id : ids)
+                sum += entities.GetComponent<TransformComponent>(id)->GetWorldMatrix().m12;
+            Sink = sum;
+        } });
+
+    cases.push_back({ "entityset_update", CreateMovers, [](EntitySet& entities, std::vector<EntityId_t>&, size_t)
+        {
+            entities.Update();
+        } });
+
+    cases.push_back({ "occlusion_cull", CreateCullBoxes, [](EntitySet&, std::vector<EntityId_t>&, size_t)
+        {
+            BenchCuller.Begin(GetBenchViewProjection(BenchCuller.Width, BenchCuller.Height));
+            BenchCuller.AddOccluderBox(MatrixIdentity(), Vector3{ -100, -20, -0.5f }, Vector3{ 100, 60, 0.5f });
+            BenchCuller.Rasterize();
+
+            size_t visible = 0;
+            for (const BoundingBox& box : CullBoxes)
+            {
+                if (BenchCuller.IsVisible(box))
+                    visible++;
+            }
+
+            const OcclusionCuller::Stats& stats = BenchCuller.GetStats();
+            BenchCheck(visible == CullFrontBoxes, "occlusion_cull", "boxes in front of the wall were culled or boxes behind it were not");
+            BenchCheck(stats.FrustumCulled + stats.OcclusionCulled == CullBoxes.size() - CullFrontBoxes, "occlusion_cull", "culled count doesn't match the boxes behind the wall");
+        } });
+
+    cases.push_back({ "render_frame", CreateRenderScene, [](EntitySet&, std::vector<EntityId_t>&, size_t)
+        {
+            // the same steps the scene view takes for a frame, extract then draw from the copy
+            RenderSystem* render = BenchSystems->GetSystem<RenderSystem>();
+            LightingSystem* lighting = BenchSystems->GetSystem<LightingSystem>();
+
+            BenchSnapshot.Clear();
+            render->Extract(BenchCamera, BenchSnapshot, RenderBenchWidth, RenderBenchHeight);
+            lighting->ExtractLights(BenchSnapshot.Lights);
+            lighting->AssignLights(BenchSnapshot);
+
+            render->Begin(BenchSnapshot);
+            lighting->SetView(BenchSnapshot.ViewCam, RenderBenchWidth, RenderBenchHeight);
+            lighting->UploadLights(BenchSnapshot.Lights);
+            render->Draw(BenchSnapshot, [lighting](const RenderLightSet& set) { lighting->UploadLightSet(BenchSnapshot.Lights, set); });
+            render->End();
+
+            const RenderStats& stats = BenchBackend.GetStats();
+            ReportCounter("shapes", double(stats.Shapes));
+            ReportCounter("draw_calls", double(stats.DrawCalls));
+            ReportCounter("state_changes", double(stats.StateChanges));
+            ReportCounter("flushes", double(stats.Flushes));
+            ReportCounter("uniform_uploads", double(stats.UniformUploads));
+        } });
+
+    cases.push_back({ "light_binning", CreateBenchLights, [](EntitySet&, std::vector<EntityId_t>&, size_t)
+        {
+            BenchClusterer.Bin(BenchLights);
+
+            const LightClusterer::Stats& stats = BenchClusterer.GetStats();
+            ReportCounter("assignments", double(stats.Assignments));
+            ReportCounter("used_clusters", double(stats.UsedClusters));
+            ReportCounter("dropped", double(stats.Dropped));
+        } });
+
+    cases.push_back({ "scene_save", CreateScene, [](EntitySet& entities, std::vector<EntityId_t>&, size_t)
+        {
+            SceneFile::Save(entities, SceneBenchFile);
+        } });
+
+    // the setup scene stays alive, so the load gets memory the process hasn't used yet, as opening a second scene would
+    cases.push_back({ "scene_load", [](EntitySet& entities, std::vector<EntityId_t>& ids, size_t count)
+        {
+            CreateScene(entities, ids, count);
+            SceneFile::Save(entities, SceneBenchFile);
+            LoadedScene = std::make_unique<EntitySet>();
+        },
+        [](EntitySet&, std::vector<EntityId_t>&, size_t)
+        {
+            SceneFile::Load(*LoadedScene, SceneBenchFile);
+        } });
+
+    // the whole load run in frame sized slices, as the editor would over a number of frames
+    cases.push_back({ "scene_load_streamed", [](EntitySet& entities, std::vector<EntityId_t>& ids, size_t count)
+        {
+            CreateScene(entities, ids, count);
+            SceneFile::Save(entities, SceneBenchFile);
+            LoadedScene = std::make_unique<EntitySet>();
+        },
+        [](EntitySet&, std::vector<EntityId_t>&, size_t)
+        {
+            SceneFile::StreamingLoader loader;
+            loader.Begin(*LoadedScene, SceneBenchFile);
+            while (loader.Update(StreamingBudgetMs))
+                continue;
+        } });
+
+    cases.push_back({ "scene_save_incremental", [](EntitySet& entities, std::vector<EntityId_t>& ids, size_t count)
+        {
+            CreateScene(entities, ids, count);
+            BenchSaver = std::make_unique<SceneFile::IncrementalSaver>(SceneBenchFile);
+            BenchSaver->Save(entities);
+
+            // a selection of entities moved somewhere in the scene, as the editor would between autosaves
+            std::mt19937 random(1234);
+            size_t first = random() % (count - std::min(count, IncrementalSaveEdits) + 1);
+            for (size_t i = first; i < std::min(count, first + IncrementalSaveEdits); i++)
+            {
+                TransformComponent* transform = entities.GetComponent<TransformComponent>(ids[i]);
+                transform->SetPosition(float(i), 0, 0);
+                entities.MarkComponentChanged(transform);
+            }
+        },
+        [](EntitySet& entities, std::vector<EntityId_t>&, size_t)
+        {
+            BenchSaver->Save(entities);
+        } });
+
+    cases.push_back({ "prefab_spawn", CreatePrefab, [](EntitySet& entities, std::vector<EntityId_t>&, size_t count)
+        {
+            BenchPrefab.InstantiateBatch(entities, std::max<size_t>(count / PrefabBenchEntities, 1));
+        } });
+
+    return cases;
+}
+
+static BenchResult RunCase(const BenchCase& benchCase, size_t size, size_t iterations)
+{
+    // keep the big sizes from taking forever
+    iterations = std::max<size_t>(std::min<size_t>(iterations, 1000000 / size), 1);
+
+    std::vector<double> times;
+    for (size_t i = 0; i < iterations; i++)
+    {
+        EntitySet entities;
+        std::vector<EntityId_t> ids;
+        if (benchCase.Setup != nullptr)
+            benchCase.Setup(entities, ids, size);
+
+        RunCounters.clear();
+        auto start = std::chrono::high_resolution_clock::now();
+        benchCase.Run(entities, ids, size);
+        times.push_back(Profiler::MillisecondsSince(start));
+    }
+
+    std::sort(times.begin(), times.end());
+
+    BenchResult result;
+    result.Name = benchCase.Name;
+    result.Size = size;
+    result.Iterations = iterations;
+    result.MinMs = times.front();
+    result.MedianMs = times[times.size() / 2];
+    result.NsPerOp = result.MedianMs * 1000000.0 / size;
+    result.Counters = RunCounters;
+    return result;
+}
+
+// a grid of cells, each with hierarchies like the prefab case spread over it, made and written a cell at a time
+static const char* FlythroughWorld = "rlECS_bench_world";
+static constexpr float FlythroughCellSize = 100;
+
+static bool BuildFlythroughWorld(const BenchOptions& options, std::vector<std::string>& files)
+{
+    WorldPartition::Builder builder(FlythroughWorld, FlythroughCellSize);
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> offset(0, FlythroughCellSize);
+
+    EntityId_t nextId = 0;
+    for (size_t x = 0; x < options.WorldCells; x++)
+    {
+        for (size_t z = 0; z < options.WorldCells; z++)
+        {
+            EntitySet cellEntities;
+            cellEntities.ReserveEntityIds(nextId);
+
+            std::vector<EntityId_t> ids;
+            for (size_t i = 0; i < options.CellEntities; i++)
+            {
+                size_t local = i % PrefabBenchEntities;
+                EntityId_t id = local == 0 ? cellEntities.CreateEntity() : cellEntities.AddChild(ids[ids.size() - local + (local - 1) / 4]);
+                ids.push_back(id);
+
+                TransformComponent* transform = cellEntities.AddComponent<TransformComponent>(id);
+                if (local == 0)
+                    transform->SetPosition(x * FlythroughCellSize + offset(random), 0, z * FlythroughCellSize + offset(random));
+                else
+                    transform->SetPosition(float(local), 0, 0);
+                cellEntities.AddComponent<ShapeComponent>(id)->ObjectSize = Vector3{ 1, 1, 1 };
+            }
+
+            WorldPartition::WorldCell cell{ int32_t(x), int32_t(z) };
+            files.push_back(WorldPartition::GetCellFileName(FlythroughWorld, cell));
+            if (!builder.AddCell(cell, cellEntities))
+                return false;
+
+            nextId = cellEntities.ReserveEntityIds(0);
+        }
+    }
+
+    files.push_back(WorldPartition::GetIndexFileName(FlythroughWorld));
+    return builder.Finish();
+}
+
+static double GetPercentile(std::vector<double> values, double percentile)
+{
+    if (values.empty())
+        return 0;
+
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, size_t(percentile / 100.0 * double(values.size())))];
+}
+
+// one lap of a circle around the middle of the world, every update is a frame
+static int RunFlythrough(const BenchOptions& options)
+{
+    std::vector<std::string> files;
+    if (!BuildFlythroughWorld(options, files))
+    {
+        fprintf(stderr, "unable to write the world\n");
+        return 2;
+    }
+
+    EntitySet world;
+    WorldPartition::Streamer streamer(world);
+    streamer.LoadRadius = FlythroughCellSize * 2;
+    streamer.UnloadRadius = FlythroughCellSize * 3;
+    if (!streamer.Open(FlythroughWorld))
+    {
+        fprintf(stderr, "unable to read the world index\n");
+        return 2;
+    }
+
+    EntityId_t camera = world.AddComponent<CameraComponent>()->EntityId;
+    TransformComponent* cameraTransform = world.AddComponent<TransformComponent>(camera);
+
+    float center = options.WorldCells * FlythroughCellSize * 0.5f;
+    float radius = center * 0.6f;
+
+    std::vector<double> frameMs;
+    size_t hitches = 0;
+    size_t peakEntities = 0;
+    for (size_t frame = 0; frame < options.Frames; frame++)
+    {
+        float angle = float(frame) / float(options.Frames) * 2 * PI;
+        cameraTransform->SetPosition(center + cosf(angle) * radius, 10, center + sinf(angle) * radius);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        streamer.Update(StreamingBudgetMs);
+        frameMs.push_back(Profiler::MillisecondsSince(start));
+
+        if (frameMs.back() > StreamingBudgetMs * 2)
+            hitches++;
+        peakEntities = std::max(peakEntities, world.GetEntityCount());
+    }
+
+    WorldPartition::Streamer::Stats stats = streamer.GetStats();
+    streamer.Close();
+    size_t leftover = world.GetEntityCount() - 1;
+
+    for (const std::string& file : files)
+        remove(file.c_str());
+
+    FILE* fp = stdout;
+    if (!options.OutputFile.empty())
+    {
+        fp = fopen(options.OutputFile.c_str(), "w");
+        if (fp == nullptr)
+        {
+            fprintf(stderr, "unable to write %s\n", options.OutputFile.c_str());
+            return 2;
+        }
+    }
+
+    fprintf(fp, "{\n  \"benchmark\":\"rlECS_flythrough\",\n  \"cells\":%zu,\n  \"cell_entities\":%zu,\n  \"frames\":%zu,\n  \"budget_ms\":%.2f,\n",
+        options.WorldCells * options.WorldCells, options.CellEntities, options.Frames, StreamingBudgetMs);
+    fprintf(fp, "  \"update_ms\":{\"median\":%.4f,\"p99\":%.4f,\"max\":%.4f},\n  \"hitches\":%zu,\n",
+        GetPercentile(frameMs, 50), GetPercentile(frameMs, 99), GetPercentile(frameMs, 100), hitches);
+    fprintf(fp, "  \"peak_estimated_bytes\":%zu,\n  \"peak_entities\":%zu,\n  \"cells_loaded\":%zu,\n  \"cells_unloaded\":%zu,\n  \"failed_cells\":%zu,\n  \"leftover_entities\":%zu\n}\n",
+        stats.PeakEstimatedBytes, peakEntities, stats.CellsLoaded, stats.CellsUnloaded, stats.FailedCells, leftover);
+
+    if (fp != stdout)
+        fclose(fp);
+
+    return leftover > 0 || stats.FailedCells > 0 ? 1 : 0;
+}
+
+// just enough JSON reading for files this program wrote
+static bool ReadNumber(const std::string& text, size_t start, size_t end, const char* key, double& value)
+{
+    std::string search = std::string("\"") + key + "\":";
+    size_t pos = text.find(search, start);
+    if (pos == std::string::npos || pos >= end)
+        return false;
+
+    value = atof(text.c_str() + pos + search.size());
+    return true;
+}
+
+static bool ReadString(const std::string& text, size_t start, size_t end, const char* key, std::string& value)
+{
+    std::string search = std::string("\"") + key + "\":\"";
+    size_t pos = text.find(search, start);
+    if (pos == std::string::npos || pos >= end)
+        return false;
+
+    pos += search.size();
+    size_t close = text.find('"', pos);
+    if (close == std::string::npos)
+        return false;
+
+    value = text.substr(pos, close - pos);
+    return true;
+}
+
+static bool LoadResults(const char* fileName, std::vector<BenchResult>& results)
+{
+    FILE* fp = fopen(fileName, "rb");
+    if (fp == nullptr)
+        return false;
+
+    std::string text;
+    char buffer[4096];
+    size_t read = 0;
+    while ((read = fread(buffer, 1, sizeof(buffer), fp)) > 0)
+        text.append(buffer, read);
+    fclose(fp);
+
+    size_t pos = text.find("\"results\"");
+    while (pos != std::string::npos)
+    {
+        size_t start = text.find('{', pos);
+        if (start == std::string::npos)
+            break;
+
+        size_t end = text.find('}', start);
+        if (end == std::string::npos)
+            break;
+
+        BenchResult result;
+        double size = 0;
+        if (ReadString(text, start, end, "name", result.Name) && ReadNumber(text, start, end, "size", size) && ReadNumber(text, start, end, "median_ms", result.MedianMs))
+        {
+            result.Size = (size_t)size;
+            results.push_back(result);
+        }
+        pos = end;
+    }
+
+    return true;
+}
+
+static void WriteResults(FILE* fp, const BenchOptions& options, const std::vector<BenchResult>& results, const std::vector<BenchResult>& baseline, size_t& regressions)
+{
+    fprintf(fp, "{\n  \"benchmark\":\"rlECS\",\n  \"iterations\":%zu,\n  \"results\":[\n", options.Iterations);
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const BenchResult& result = results[i];
+        fprintf(fp, "    {\"name\":\"%s\",\"size\":%zu,\"iterations\":%zu,\"min_ms\":%.4f,\"median_ms\":%.4f,\"ns_per_op\":%.2f",
+            result.Name.c_str(), result.Size, result.Iterations, result.MinMs, result.MedianMs, result.NsPerOp);
+
+        if (!result.Counters.empty())
+        {
+            fprintf(fp, ",\"counters\":{");
+            for (size_t c = 0; c < result.Counters.size(); c++)
+                fprintf(fp, "%s\"%s\":%.6g", c > 0 ? "," : "", result.Counters[c].first.c_str(), result.Counters[c].second);
+            fprintf(fp, "}");
+        }
+        fprintf(fp, "}%s\n", i + 1 < results.size() ? "," : "");
+    }
+    fprintf(fp, "  ]");
+
+    regressions = 0;
+    if (!options.BaselineFile.empty())
+    {
+        fprintf(fp, ",\n  \"baseline\":\"%s\",\n  \"threshold_pct\":%.1f,\n  \"comparison\":[\n", options.BaselineFile.c_str(), options.Threshold);
+
+        bool first = true;
+        for (const BenchResult& result : results)
+        {
+            auto itr = std::find_if(baseline.begin(), baseline.end(), [&result](const BenchResult& old) { return old.Name == result.Name && old.Size == result.Size; });
+            if (itr == baseline.end() || itr->MedianMs <= 0)
+                continue;
+
+            double change = (result.MedianMs - itr->MedianMs) / itr->MedianMs * 100.0;
+            bool regression = change > options.Threshold;
+            if (regression)
+                regressions++;
+
+            fprintf(fp, "%s    {\"name\":\"%s\",\"size\":%zu,\"baseline_ms\":%.4f,\"median_ms\":%.4f,\"change_pct\":%.1f,\"regression\":%s}",
+                first ? "" : ",\n", result.Name.c_str(), result.Size, itr->MedianMs, result.MedianMs, change, regression ? "true" : "false");
+            first = false;
+        }
+        fprintf(fp, "\n  ],\n  \"regressions\":%zu", regressions);
+    }
+    fprintf(fp, ",\n  \"check_failures\":%zu\n}\n", CheckFailures);
+}
+
+static bool ParseArgs(int argc, char* argv[], BenchOptions& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+        if (strcmp(arg, "--sizes") == 0 && value != nullptr)
+        {
+            options.Sizes.clear();
+            for (const char* p = value; *p != '\0';)
+            {
+                size_t size = strtoull(p, const_cast<char**>(&p), 10);
+                if (size > 0)
+                    options.Sizes.push_back(size);
+                if (*p == ',')
+                    p++;
+                else if (*p != '\0')
+                    return false;
+            }
+            i++;
+        }
+        else if (strcmp(arg, "--iterations") == 0 && value != nullptr)
+        {
+            options.Iterations = std::max<size_t>(strtoull(value, nullptr, 10), 1);
+            i++;
+        }
+        else if (strcmp(arg, "--out") == 0 && value != nullptr)
+        {
+            options.OutputFile = value;
+            i++;
+        }
+        else if (strcmp(arg, "--baseline") == 0 && value != nullptr)
+        {
+            options.BaselineFile = value;
+            i++;
+        }
+        else if (strcmp(arg, "--threshold") == 0 && value != nullptr)
+        {
+            options.Threshold = atof(value);
+            i++;
+        }
+        else if (strcmp(arg, "--flythrough") == 0)
+        {
+            options.Flythrough = true;
+        }
+        else if (strcmp(arg, "--world") == 0 && value != nullptr)
+        {
+            char* end = nullptr;
+            options.WorldCells = strtoull(value, &end, 10);
+            if (*end != ',')
+                return false;
+            options.CellEntities = strtoull(end + 1, nullptr, 10);
+            if (options.WorldCells == 0 || options.CellEntities == 0)
+                return false;
+            i++;
+        }
+        else if (strcmp(arg, "--frames") == 0 && value != nullptr)
+        {
+            options.Frames = std::max<size_t>(strtoull(value, nullptr, 10), 1);
+            i++;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return !options.Sizes.empty();
+}
+
+int main(int argc, char* argv[])
+{
+    BenchOptions options;
+    if (!ParseArgs(argc, argv, options))
+    {
+        fprintf(stderr, "usage: rlECS_bench [--sizes 1000,10000] [--iterations 5] [--out file.json] [--baseline file.json] [--threshold percent]\n");
+        fprintf(stderr, "       rlECS_bench --flythrough [--world cells,entities] [--frames 600] [--out file.json]\n");
+        return 2;
+    }
+
+    // these are only ever made by their factories, so Create<T> never gets the chance to register them
+    ComponentManager::Register<PrefabInstanceComponent>();
+    ComponentManager::Register<WorldCellComponent>();
+
+    if (options.Flythrough)
+        return RunFlythrough(options);
+
+    std::vector<BenchResult> baseline;
+    if (!options.BaselineFile.empty() && !LoadResults(options.BaselineFile.c_str(), baseline))
+    {
+        fprintf(stderr, "unable to read baseline %s\n", options.BaselineFile.c_str());
+        return 2;
+    }
+
+    std::vector<BenchResult> results;
+    for (const BenchCase& benchCase : GetCases())
+    {
+        for (size_t size : options.Sizes)
+        {
+            results.push_back(RunCase(benchCase, size, options.Iterations));
+            fprintf(stderr, "%-24s %8zu %10.3fms %8.1fns/op\n", results.back().Name.c_str(), size, results.back().MedianMs, results.back().NsPerOp);
+        }
+    }
+
+    LoadedScene.reset();
+    BenchSystems.reset();
+    RenderBackend::Set(nullptr);
+    remove(SceneBenchFile);
+
+    FILE* fp = stdout;
+    if (!options.OutputFile.empty())
+    {
+        fp = fopen(options.OutputFile.c_str(), "w");
+        if (fp == nullptr)
+        {
+            fprintf(stderr, "unable to write %s\n", options.OutputFile.c_str());
+            return 2;
+        }
+    }
+
+    size_t regressions = 0;
+    WriteResults(fp, options, results, baseline, regressions);
+
+    if (fp != stdout)
+        fclose(fp);
+
+    if (regressions > 0)
+        fprintf(stderr, "%zu regressions over %.1f%%\n", regressions, options.Threshold);
+    if (CheckFailures > 0)
+        fprintf(stderr, "%zu failed checks\n", CheckFailures);
+
+    return regressions > 0 || CheckFailures > 0 ? 1 : 0;
+}
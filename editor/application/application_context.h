@@ -31,6 +31,9 @@
 #pragma once
 
 #include "application/application_ui.h"
+#include "application/log_sink.h"
+
+#include "input_recording.h"
 
 #include "RLAssets.h"
 #include "imgui.h"
@@ -115,6 +118,14 @@ struct ApplicationContext
     bool TakeScreenshot = false;
     bool CopyScreenshot = false;
 
+    // when nothing is happening, sleep until the next window event instead of redrawing every frame
+    bool IdleMode = true;
+    double IdleTimeout = 0.5;
+
+    // captures or plays back the time and input the scene sees, so runs can be repeated exactly
+    InputRecorder Recorder;
+    InputReplayer Replayer;
+
     static void Screenshot();
 
     void ChangeView(MainView* newView);
@@ -125,33 +136,4 @@ struct ApplicationContext
 extern ApplicationContext GlobalContext;
 
 #define REGISTER_VIEW(viewType) \
-static viewType View;
-
-namespace LogSink
-{
-    struct LogItem
-    {
-        int Level = 0;
-        std::string Prefix;
-        std::string Text;
-        ImVec4 Color = { 1,1,1,1 };
-    };
-
-    void Setup();
-    bool PopLogLine(LogItem& line);
-    void Flush();
-
-    inline const char* GetLogLevelName(int logLevel)
-    {
-        switch (logLevel)
-        {
-        default:            return "All";
-        case LOG_TRACE:     return "Trace";
-        case LOG_DEBUG:     return "DEBUG";
-        case LOG_INFO:      return "Info";
-        case LOG_WARNING:   return "Warning";
-        case LOG_ERROR:     return "ERROR";
-        case LOG_FATAL:     return "FATAL";
-        }
-    }
-}
\ No newline at end of file
+static viewType View;
\ No newline at end of file
@@ -35,6 +35,7 @@
 #include "outliner/scene_outliner.h"
 #include "application/platform_tools.h"
 #include "application/ui_window.h"
+#include "profiler/profiler_window.h"
 #include "view/main_view.h"
 #include "view/scene_view.h"
 
@@ -56,6 +57,10 @@ void UIManager::Startup()
     ImGui::GetStyle().Colors[ImGuiCol_ModalWindowDimBg] = ImVec4(0, 0, 0, 0.75f);
 
     AddWindow(std::make_shared<LogWindow>());
+
+#ifdef RLECS_PROFILER
+    AddWindow(std::make_shared<ProfilerWindow>());
+#endif
 }
 
 void UIManager::Shutdown()
@@ -81,6 +86,8 @@ void UIManager::Resized()
 
 void UIManager::Show(MainView* view)
 {
+    PROFILE_SCOPE("UIManager::Show");
+
     ImVec2 screenSize((float)GetScreenWidth(), (float)GetScreenHeight());
 
     ImGui::SetNextWindowSize(screenSize, ImGuiCond_Always);
@@ -241,6 +248,54 @@ void UIManager::ShowMenu()
 
                 ImGui::EndMenu();
             }
+            if (ImGui::BeginMenu("Input Recording"))
+            {
+                InputRecorder& recorder = GlobalContext.Recorder;
+                InputReplayer& replayer = GlobalContext.Replayer;
+
+                if (recorder.IsRecording())
+                {
+                    if (ImGui::MenuItem("Stop Recording"))
+                    {
+                        recorder.Stop();
+                        TraceLog(LOG_INFO, "Recorded %d frames of input", (int)recorder.GetFrames().size());
+                    }
+                }
+                else if (ImGui::MenuItem("Start Recording", nullptr, false, !replayer.IsPlaying()))
+                {
+                    recorder.Start();
+                }
+
+                if (ImGui::MenuItem("Save Recording...", nullptr, false, !recorder.IsRecording() && !recorder.GetFrames().empty()))
+                {
+                    std::string path = PlatformTools::ShowSaveFileDialog("input.rlir", { { "Input Recording", "rlir" } });
+                    if (path.size() > 0 && !recorder.Save(path.c_str()))
+                        TraceLog(LOG_ERROR, "Unable to save input recording %s", path.c_str());
+                }
+
+                ImGui::Separator();
+                if (replayer.IsPlaying())
+                {
+                    if (ImGui::MenuItem("Stop Replay"))
+                        replayer.Stop();
+                }
+                else if (ImGui::MenuItem("Replay Recording...", nullptr, false, !recorder.IsRecording()))
+                {
+                    std::string path = PlatformTools::ShowOpenFileDialog("input.rlir", { { "Input Recording", "rlir" } });
+                    if (path.size() > 0)
+                    {
+                        if (replayer.Load(path.c_str()))
+                            replayer.Start();
+                        else
+                            TraceLog(LOG_ERROR, "Unable to load input recording %s", path.c_str());
+                    }
+                }
+
+                ImGui::EndMenu();
+            }
+
+            ImGui::MenuItem("Idle When Inactive", nullptr, &GlobalContext.IdleMode);
+
             if (GlobalContext.View != nullptr)
                 GlobalContext.View->OnToolsMenu();
             ImGui::EndMenu();
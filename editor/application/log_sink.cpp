@@ -0,0 +1,281 @@
+/**********************************************************************************************
+*
+*   raylibExtras * Utilities and Shared Components for Raylib
+*
+*   rlECS- a simple ECS in raylib with editor
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+#include "application/log_sink.h"
+
+#include "RLAssets.h"
+#include "rlImGui.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <thread>
+
+namespace LogSink
+{
+    static_assert((Capacity & (Capacity - 1)) == 0, "LogSink::Capacity must be a power of two");
+
+    LogRecord Records[Capacity];
+    std::atomic<uint64_t> WriteIndex = { 0 };
+    std::atomic<uint64_t> FirstVisible = { 0 };
+
+    std::atomic<size_t> Dropped = { 0 };
+    std::atomic<size_t> Truncated = { 0 };
+
+    std::thread FileThread;
+    std::mutex FileLock;
+    std::condition_variable FileWake;
+    bool Running = false;
+
+    std::string FileName;
+    FILE* File = nullptr;
+    size_t FileSize = 0;
+
+    inline uint64_t WritingState(uint64_t sequence) { return sequence * 2 + 1; }
+    inline uint64_t DoneState(uint64_t sequence) { return sequence * 2 + 2; }
+
+    void TraceLog(int logLevel, const char* text, va_list args)
+    {
+        uint64_t sequence = WriteIndex.fetch_add(1, std::memory_order_relaxed);
+        LogRecord& record = Records[sequence & (Capacity - 1)];
+
+        // a writer a whole ring behind could still be filling this slot
+        uint64_t state = record.State.load(std::memory_order_relaxed);
+        while ((state & 1) != 0 || !record.State.compare_exchange_weak(state, WritingState(sequence), std::memory_order_acquire))
+        {
+            if ((state & 1) != 0)
+            {
+                std::this_thread::yield();
+                state = record.State.load(std::memory_order_relaxed);
+            }
+        }
+
+        int length = vsnprintf(record.Text, InlineTextSize, text, args);
+        if (length < 0)
+            length = 0;
+
+        if ((size_t)length >= InlineTextSize)
+        {
+            length = InlineTextSize - 1;
+            Truncated.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        record.Level = logLevel;
+        record.Length = (uint32_t)length;
+        record.State.store(DoneState(sequence), std::memory_order_release);
+
+        // get the file thread going before the ring laps it
+        if ((sequence & (Capacity / 2 - 1)) == 0)
+            FileWake.notify_one();
+    }
+
+    uint64_t GetWriteIndex()
+    {
+        return WriteIndex.load(std::memory_order_acquire);
+    }
+
+    uint64_t GetFirstVisible()
+    {
+        return FirstVisible.load(std::memory_order_relaxed);
+    }
+
+    const LogRecord* GetRecord(uint64_t sequence)
+    {
+        const LogRecord& record = Records[sequence & (Capacity - 1)];
+        if (record.State.load(std::memory_order_acquire) != DoneState(sequence))
+            return nullptr;
+
+        return &record;
+    }
+
+    bool IsRecordValid(const LogRecord* record, uint64_t sequence)
+    {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return record->State.load(std::memory_order_relaxed) == DoneState(sequence);
+    }
+
+    size_t GetDroppedCount()
+    {
+        return Dropped.load(std::memory_order_relaxed);
+    }
+
+    size_t GetTruncatedCount()
+    {
+        return Truncated.load(std::memory_order_relaxed);
+    }
+
+    void Flush()
+    {
+        FirstVisible.store(GetWriteIndex(), std::memory_order_relaxed);
+    }
+
+    ImVec4 GetLogLevelColor(int logLevel)
+    {
+        switch (logLevel)
+        {
+        default:            return ImGuiColors::Convert(WHITE);
+        case LOG_TRACE:     return ImGuiColors::Convert(GRAY);
+        case LOG_DEBUG:     return ImGuiColors::Convert(SKYBLUE);
+        case LOG_INFO:      return ImGuiColors::Convert(GREEN);
+        case LOG_WARNING:   return ImGuiColors::Convert(YELLOW);
+        case LOG_ERROR:     return ImGuiColors::Convert(ORANGE);
+        case LOG_FATAL:     return ImGuiColors::Convert(RED);
+        }
+    }
+
+    // file sink
+
+    std::string GetRotatedName(int index)
+    {
+        if (index == 0)
+            return FileName;
+
+        return FileName + "." + std::to_string(index);
+    }
+
+    void RotateFile()
+    {
+        if (File != nullptr)
+            fclose(File);
+
+        remove(GetRotatedName(MaxFiles - 1).c_str());
+        for (int i = MaxFiles - 1; i > 0; i--)
+            rename(GetRotatedName(i - 1).c_str(), GetRotatedName(i).c_str());
+
+        File = fopen(FileName.c_str(), "w");
+        FileSize = 0;
+    }
+
+    void WriteRecords(uint64_t& cursor)
+    {
+        uint64_t end = GetWriteIndex();
+        char line[InlineTextSize];
+
+        while (cursor < end)
+        {
+            if (end - cursor > Capacity)
+            {
+                Dropped.fetch_add(size_t(end - Capacity - cursor), std::memory_order_relaxed);
+                cursor = end - Capacity;
+            }
+
+            const LogRecord& record = Records[cursor & (Capacity - 1)];
+            uint64_t state = record.State.load(std::memory_order_acquire);
+
+            // still being written, pick it up next time
+            if (state < DoneState(cursor))
+                break;
+
+            if (state == DoneState(cursor))
+            {
+                int level = record.Level;
+                uint32_t length = std::min<uint32_t>(record.Length, InlineTextSize - 1);
+                memcpy(line, record.Text, length);
+
+                if (IsRecordValid(&record, cursor))
+                {
+                    if (File == nullptr || FileSize >= MaxFileSize)
+                        RotateFile();
+
+                    if (File != nullptr)
+                    {
+                        int prefix = fprintf(File, "%s: ", GetLogLevelName(level));
+                        fwrite(line, 1, length, File);
+                        fputc('\n', File);
+                        FileSize += (prefix > 0 ? prefix : 0) + length + 1;
+                    }
+                }
+                else
+                {
+                    Dropped.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            else
+            {
+                Dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            cursor++;
+        }
+
+        if (File != nullptr)
+            fflush(File);
+    }
+
+    void FileThreadMain()
+    {
+        uint64_t cursor = 0;
+
+        std::unique_lock<std::mutex> lock(FileLock);
+        while (Running)
+        {
+            FileWake.wait_for(lock, std::chrono::milliseconds(100));
+
+            lock.unlock();
+            WriteRecords(cursor);
+            lock.lock();
+        }
+
+        lock.unlock();
+        WriteRecords(cursor);
+    }
+
+    void Setup()
+    {
+        SetTraceLogCallback(TraceLog);
+
+        FileName = rlas_GetApplicationBasePath();
+        FileName += "rlECS_log.txt";
+
+        Running = true;
+        FileThread = std::thread(FileThreadMain);
+    }
+
+    void Shutdown()
+    {
+        {
+            std::lock_guard<std::mutex> lock(FileLock);
+            Running = false;
+        }
+        FileWake.notify_one();
+
+        if (FileThread.joinable())
+            FileThread.join();
+
+        if (File != nullptr)
+            fclose(File);
+        File = nullptr;
+    }
+}
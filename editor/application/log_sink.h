@@ -0,0 +1,95 @@
+/**********************************************************************************************
+*
+*   raylibExtras * Utilities and Shared Components for Raylib
+*
+*   rlECS- a simple ECS in raylib with editor
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+#pragma once
+
+#include "raylib.h"
+#include "imgui.h"
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+// raylib's log goes into a fixed ring that any thread can write to, the log window reads
+// the ring in place and a background thread copies it out to a rotating file
+namespace LogSink
+{
+    constexpr size_t Capacity = 1024;           // must be a power of two
+    constexpr size_t InlineTextSize = 244;      // longer lines are cut off
+    constexpr size_t MaxFileSize = 4 * 1024 * 1024;
+    constexpr int MaxFiles = 3;
+
+    struct LogRecord
+    {
+        // twice the record's sequence number plus one while it's being written, plus two once it's done
+        std::atomic<uint64_t> State = { 0 };
+        int Level = 0;
+        uint32_t Length = 0;
+        char Text[InlineTextSize] = { 0 };
+    };
+
+    void Setup();
+    void Shutdown();
+
+    // hides everything logged so far from the log window
+    void Flush();
+
+    // the sequence number the next record will get
+    uint64_t GetWriteIndex();
+
+    // the first record the log window should show
+    uint64_t GetFirstVisible();
+
+    // the finished record with this sequence number, nullptr if it's not done or has been overwritten
+    const LogRecord* GetRecord(uint64_t sequence);
+
+    // true if a record read in place was not overwritten while it was being used
+    bool IsRecordValid(const LogRecord* record, uint64_t sequence);
+
+    // records the writer lapped before the file thread got to them, and lines that were cut off
+    size_t GetDroppedCount();
+    size_t GetTruncatedCount();
+
+    ImVec4 GetLogLevelColor(int logLevel);
+
+    inline const char* GetLogLevelName(int logLevel)
+    {
+        switch (logLevel)
+        {
+        default:            return "All";
+        case LOG_TRACE:     return "Trace";
+        case LOG_DEBUG:     return "DEBUG";
+        case LOG_INFO:      return "Info";
+        case LOG_WARNING:   return "Warning";
+        case LOG_ERROR:     return "ERROR";
+        case LOG_FATAL:     return "FATAL";
+        }
+    }
+}
@@ -3,6 +3,9 @@
 
 #include "../clip/clip.h"
 
+#define GLFW_INCLUDE_NONE
+#include "GLFW/glfw3.h"
+
 std::string OpenFileDialog(const char* filename, std::vector<std::pair<std::string, std::string>> filterValues);
 std::string SaveFileDialog(const char* filename, std::vector<std::pair<std::string, std::string>> filterValues);
 
@@ -48,4 +51,16 @@ namespace PlatformTools
         std::vector<std::pair<std::string, std::string>> filterValues;
         return SaveFileDialog(filename, filterValues);
     }
+
+    bool WaitForEvents(double timeout)
+    {
+        double start = glfwGetTime();
+        glfwWaitEventsTimeout(timeout);
+        return glfwGetTime() - start < timeout;
+    }
+
+    void WakeEventWait()
+    {
+        glfwPostEmptyEvent();
+    }
 }
\ No newline at end of file
@@ -51,4 +51,10 @@ namespace PlatformTools
     std::string ShowSaveFileDialog(const char* filename);
 
     void SetWindowHandle(void* handle);
+
+    // block until a window event arrives or the timeout (in seconds) runs out, returns true if an event woke it
+    bool WaitForEvents(double timeout);
+
+    // wake up a thread blocked in WaitForEvents, can be called from any thread
+    void WakeEventWait();
 }
\ No newline at end of file
@@ -95,47 +95,61 @@ void LogWindow::OnShow(MainView*)
 
     ImGui::SameLine();
     if (ImGui::Button("Clear"))
-    {
         LogSink::Flush();
-        LogLines.clear();
+
+    size_t dropped = LogSink::GetDroppedCount();
+    size_t truncated = LogSink::GetTruncatedCount();
+    if (dropped > 0 || truncated > 0)
+    {
+        ImGui::SameLine();
+        ImGui::TextDisabled("%d dropped, %d truncated", int(dropped), int(truncated));
     }
 
     if (ImGui::BeginChild("###LogChild", ImGui::GetContentRegionAvail()))
     {
-        bool scroollBottom = false;
+        // the window reads the ring where it is, so only what's still in it can be shown
+        uint64_t end = LogSink::GetWriteIndex();
+        uint64_t start = LogSink::GetFirstVisible();
+        if (end - start > LogSink::Capacity)
+            start = end - LogSink::Capacity;
 
-        int count = 0;
-        LogSink::LogItem item;
-        while (LogSink::PopLogLine(item)/* && count <= 10*/)
-        {
-            LogLines.emplace_back(std::move(item));
-
-            while (LogLines.size() > 50)
-                LogLines.pop_front();
-
-            scroollBottom = true;
-            count++;
-        }
+        bool scroollBottom = end != LastWriteIndex;
+        LastWriteIndex = end;
 
         std::string copyBuffer;
 
-        for (auto& line : LogLines)
+        for (uint64_t sequence = start; sequence < end; sequence++)
         {
-            if (ShowLevel != 0 && ShowLevel != line.Level)
+            const LogSink::LogRecord* record = LogSink::GetRecord(sequence);
+            if (record == nullptr)
                 continue;
 
+            if (ShowLevel != 0 && ShowLevel != record->Level)
+                continue;
+
+            const char* text = record->Text;
+            const char* textEnd = record->Text + record->Length;
+
             if (FilterText[0] != '\0')
             {
-                if (StringUtils::stristr(line.Text.c_str(), FilterText) == nullptr)
+                if (StringUtils::stristr(text, FilterText) == nullptr)
                     continue;
             }
 
-            ImGui::TextColored(line.Color, "%s", line.Prefix.c_str());
-            ImGui::SameLine();
-            ImGui::TextUnformatted(line.Text.c_str());
+            if (record->Level > LOG_ALL && record->Level < LOG_NONE)
+            {
+                ImGui::TextColored(LogSink::GetLogLevelColor(record->Level), "%s: ", LogSink::GetLogLevelName(record->Level));
+                ImGui::SameLine();
+            }
+            ImGui::TextUnformatted(text, textEnd);
 
-            if (copy)
-                copyBuffer += line.Prefix + line.Text + "\r\n";
+            if (copy && LogSink::IsRecordValid(record, sequence))
+            {
+                if (record->Level > LOG_ALL && record->Level < LOG_NONE)
+                    copyBuffer += std::string(LogSink::GetLogLevelName(record->Level)) + ": ";
+                copyBuffer.append(text, textEnd);
+                copyBuffer += "\r\n";
+            }
         }
 
         if (copy)
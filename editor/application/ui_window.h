@@ -32,7 +32,7 @@
 
 #include <memory>
 #include <string>
-#include <deque>
+#include <stdint.h>
 
 #include "application/application_context.h"
 
@@ -73,7 +73,7 @@ public:
     void OnShow(MainView* view) override;
 
 private:
-    std::deque<LogSink::LogItem> LogLines;
+    uint64_t LastWriteIndex = 0;
 
     int ShowLevel = 0;
 
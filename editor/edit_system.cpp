@@ -0,0 +1,589 @@
+
+#include "edit_system.h"
+
+#include <algorithm>
+#include <string.h>
+#include <string>
+
+// one step in the history
+class EditEntry
+{
+public:
+    virtual ~EditEntry() = default;
+
+    virtual void Undo(EntitySet& entities) = 0;
+    virtual void Redo(EntitySet& entities) = 0;
+
+    // bytes held by the entry, counted against the journal budget
+    virtual size_t GetSize() const = 0;
+
+    // fold the entry that follows this one into it, true if it was taken
+    virtual bool Merge(EditEntry* next) { return false; }
+};
+
+static size_t GetComponentIndex(EntitySet& entities, Component* component)
+{
+    size_t index = 0;
+    for (Component* other : entities.GetComponents(component->Id(), component->EntityId))
+    {
+        if (other == component)
+            break;
+
+        if (other->TypeId() == component->TypeId())
+            index++;
+    }
+    return index;
+}
+
+static Component* CreateComponent(EntitySet& entities, ComponentKey_t key, EntityId_t entityId, bool active, const uint8_t* data)
+{
+    const ComponentInfo* info = ComponentManager::FindComponentInfo(key);
+    if (info == nullptr || entities.GetEntity(entityId) == nullptr)
+        return nullptr;
+
+    Component* component = info->Factory(entityId, entities);
+    component->Active = active;
+    if (data != nullptr)
+        component->LoadData(data);
+
+    return entities.StoreComponent(component->Id(), component);
+}
+
+static void RestoreEntity(EntitySet& entities, EntityId_t id, EntityId_t parent, const std::string& name)
+{
+    if (entities.LoadEntity(id, InvalidEntityId, nullptr, 0) == nullptr)
+        return;
+
+    if (parent != InvalidEntityId)
+        entities.ReparentEntity(id, parent);
+
+    if (!name.empty())
+        entities.SetEntityName(id, name.c_str());
+}
+
+class CreateEntityEntry : public EditEntry
+{
+public:
+    EntityId_t Id = InvalidEntityId;
+    EntityId_t Parent = InvalidEntityId;
+    std::string Name;
+
+    void Undo(EntitySet& entities) override { entities.RemoveEntity(Id); }
+    void Redo(EntitySet& entities) override { RestoreEntity(entities, Id, Parent, Name); }
+    size_t GetSize() const override { return sizeof(*this) + Name.capacity(); }
+};
+
+// a removed entity and everything under it, with all of their component data
+class RemoveEntityEntry : public EditEntry
+{
+public:
+    struct SavedEntity
+    {
+        EntityId_t Id = InvalidEntityId;
+        EntityId_t Parent = InvalidEntityId;
+        std::string Name;
+    };
+
+    struct SavedComponent
+    {
+        EntityId_t Entity = InvalidEntityId;
+        ComponentKey_t Key = 0;
+        bool Active = true;
+        size_t DataOffset = 0;
+        size_t DataSize = 0;
+    };
+
+    // parents come before their children
+    std::vector<SavedEntity> SavedEntities;
+    std::vector<SavedComponent> SavedComponents;
+    std::vector<uint8_t> Data;
+
+    void Capture(EntitySet& entities, EntityId_t root)
+    {
+        std::vector<EntityId_t> stack = { root };
+        while (!stack.empty())
+        {
+            EntityId_t id = stack.back();
+            stack.pop_back();
+
+            Entity* entity = entities.GetEntity(id);
+            if (entity == nullptr)
+                continue;
+
+            SavedEntities.push_back(SavedEntity{ id, entity->Parent, entities.GetEntityName(id) });
+            stack.insert(stack.end(), entity->Children.rbegin(), entity->Children.rend());
+
+            entities.DoForEachComponentInEntity(id, [this, id](Component* component)
+                {
+                    SavedComponent saved;
+                    saved.Entity = id;
+                    saved.Key = HashComponentName(component->ComponentName());
+                    saved.Active = component->Active;
+                    saved.DataOffset = Data.size();
+                    saved.DataSize = component->GetDataSize();
+
+                    Data.resize(Data.size() + saved.DataSize);
+                    if (saved.DataSize > 0)
+                        component->SaveData(Data.data() + saved.DataOffset);
+
+                    SavedComponents.push_back(saved);
+                });
+        }
+    }
+
+    void Undo(EntitySet& entities) override
+    {
+        for (const SavedEntity& saved : SavedEntities)
+            RestoreEntity(entities, saved.Id, saved.Parent, saved.Name);
+
+        for (const SavedComponent& saved : SavedComponents)
+            CreateComponent(entities, saved.Key, saved.Entity, saved.Active, saved.DataSize > 0 ? Data.data() + saved.DataOffset : nullptr);
+    }
+
+    void Redo(EntitySet& entities) override
+    {
+        if (!SavedEntities.empty())
+            entities.RemoveEntity(SavedEntities.front().Id);
+    }
+
+    size_t GetSize() const override
+    {
+        size_t size = sizeof(*this) + SavedEntities.capacity() * sizeof(SavedEntity) + SavedComponents.capacity() * sizeof(SavedComponent) + Data.capacity();
+        for (const SavedEntity& saved : SavedEntities)
+            size += saved.Name.capacity();
+        return size;
+    }
+};
+
+class ReparentEntry : public EditEntry
+{
+public:
+    EntityId_t Id = InvalidEntityId;
+    EntityId_t OldParent = InvalidEntityId;
+    EntityId_t NewParent = InvalidEntityId;
+
+    void Undo(EntitySet& entities) override { entities.ReparentEntity(Id, OldParent); }
+    void Redo(EntitySet& entities) override { entities.ReparentEntity(Id, NewParent); }
+    size_t GetSize() const override { return sizeof(*this); }
+};
+
+class RenameEntry : public EditEntry
+{
+public:
+    EntityId_t Id = InvalidEntityId;
+    std::string OldName;
+    std::string NewName;
+
+    void Undo(EntitySet& entities) override { entities.SetEntityName(Id, OldName.c_str()); }
+    void Redo(EntitySet& entities) override { entities.SetEntityName(Id, NewName.c_str()); }
+    size_t GetSize() const override { return sizeof(*this) + OldName.capacity() + NewName.capacity(); }
+
+    // typing into the name field is one rename
+    bool Merge(EditEntry* next) override
+    {
+        RenameEntry* rename = dynamic_cast<RenameEntry*>(next);
+        if (rename == nullptr || rename->Id != Id)
+            return false;
+
+        NewName = rename->NewName;
+        return true;
+    }
+};
+
+class ComponentEntry : public EditEntry
+{
+public:
+    EntityId_t Entity = InvalidEntityId;
+    size_t ComponentId = 0;
+    size_t TypeId = 0;
+    ComponentKey_t Key = 0;
+    size_t Index = 0;
+
+    bool Active = true;
+    std::vector<uint8_t> Data;
+
+    // true if the entry is for an added component, false if for a removed one
+    bool Added = true;
+
+    void Add(EntitySet& entities)
+    {
+        Component* component = CreateComponent(entities, Key, Entity, Active, Data.empty() ? nullptr : Data.data());
+        if (component != nullptr)
+            Index = GetComponentIndex(entities, component);
+    }
+
+    void Remove(EntitySet& entities)
+    {
+        Component* component = Reflection::FindComponent(entities, ComponentId, TypeId, Entity, Index);
+        if (component == nullptr)
+            return;
+
+        // keep what it held, so putting it back brings back any edits made since it was added
+        Active = component->Active;
+        Data.resize(component->GetDataSize());
+        if (!Data.empty())
+            component->SaveData(Data.data());
+
+        entities.RemoveComponent(component);
+    }
+
+    void Undo(EntitySet& entities) override
+    {
+        if (Added)
+            Remove(entities);
+        else
+            Add(entities);
+    }
+
+    void Redo(EntitySet& entities) override
+    {
+        if (Added)
+            Add(entities);
+        else
+            Remove(entities);
+    }
+
+    size_t GetSize() const override { return sizeof(*this) + Data.capacity(); }
+};
+
+// the changed fields of any number of components, each target holds the old values then the new ones
+class FieldEditEntry : public EditEntry
+{
+public:
+    struct Target
+    {
+        EntityId_t Entity = InvalidEntityId;
+        size_t ComponentId = 0;
+        size_t TypeId = 0;
+        size_t Index = 0;
+        uint64_t Mask = 0;
+        size_t DataOffset = 0;
+        size_t DataSize = 0;        // of one set of values, old and new are the same size
+    };
+
+    std::vector<Target> Targets;
+    std::vector<uint8_t> Data;
+
+    void Apply(EntitySet& entities, bool oldValues)
+    {
+        for (const Target& target : Targets)
+        {
+            Component* component = Reflection::FindComponent(entities, target.ComponentId, target.TypeId, target.Entity, target.Index);
+            if (component == nullptr)
+                continue;
+
+            const FieldTable* table = component->GetFieldTable();
+            if (table == nullptr)
+                continue;
+
+            const uint8_t* values = Data.data() + target.DataOffset + (oldValues ? 0 : target.DataSize);
+            uint8_t* object = reinterpret_cast<uint8_t*>(component);
+            for (size_t i = 0; i < table->Count; i++)
+            {
+                if (!Reflection::IsFieldInMask(target.Mask, i))
+                    continue;
+
+                memcpy(object + table->Fields[i].Offset, values, table->Fields[i].Size);
+                values += table->Fields[i].Size;
+            }
+
+            component->OnFieldsChanged();
+            entities.MarkComponentChanged(component);
+        }
+
+        entities.MarkChanged();
+    }
+
+    void Undo(EntitySet& entities) override { Apply(entities, true); }
+    void Redo(EntitySet& entities) override { Apply(entities, false); }
+    size_t GetSize() const override { return sizeof(*this) + Targets.capacity() * sizeof(Target) + Data.capacity(); }
+
+    // a drag keeps the values from before it started and takes the latest new ones
+    bool Merge(EditEntry* next) override
+    {
+        FieldEditEntry* edit = dynamic_cast<FieldEditEntry*>(next);
+        if (edit == nullptr || edit->Targets.size() != Targets.size())
+            return false;
+
+        for (size_t i = 0; i < Targets.size(); i++)
+        {
+            const Target& a = Targets[i];
+            const Target& b = edit->Targets[i];
+            if (a.Entity != b.Entity || a.ComponentId != b.ComponentId || a.TypeId != b.TypeId || a.Index != b.Index || a.Mask != b.Mask)
+                return false;
+        }
+
+        for (size_t i = 0; i < Targets.size(); i++)
+        {
+            const Target& a = Targets[i];
+            const Target& b = edit->Targets[i];
+            memcpy(Data.data() + a.DataOffset + a.DataSize, edit->Data.data() + b.DataOffset + b.DataSize, a.DataSize);
+        }
+        return true;
+    }
+};
+
+EditJournal::EditJournal(EntitySet& entities)
+    : Entities(entities)
+{
+}
+
+EditJournal::~EditJournal()
+{
+}
+
+void EditJournal::Record(EditEntry* entry)
+{
+    // a new edit replaces anything that was undone
+    while (History.size() > Position)
+    {
+        BytesUsed -= History.back()->GetSize();
+        History.pop_back();
+    }
+
+    BytesUsed += entry->GetSize();
+    History.emplace_back(entry);
+    Position = History.size();
+
+    while (BytesUsed > ByteBudget && History.size() > 1)
+    {
+        BytesUsed -= History.front()->GetSize();
+        History.pop_front();
+        Position--;
+    }
+
+    InteractionOpen = false;
+}
+
+EntityId_t EditJournal::CreateEntity(EntityId_t parent, const char* name)
+{
+    EntityId_t id = Entities.CreateEntity();
+    if (parent != InvalidEntityId)
+        Entities.ReparentEntity(id, parent);
+    if (name != nullptr)
+        Entities.SetEntityName(id, name);
+
+    CreateEntityEntry* entry = new CreateEntityEntry();
+    entry->Id = id;
+    entry->Parent = parent;
+    entry->Name = Entities.GetEntityName(id);
+    Record(entry);
+
+    return id;
+}
+
+void EditJournal::RemoveEntity(EntityId_t id)
+{
+    if (Entities.GetEntity(id) == nullptr)
+        return;
+
+    RemoveEntityEntry* entry = new RemoveEntityEntry();
+    entry->Capture(Entities, id);
+    Record(entry);
+
+    Entities.RemoveEntity(id);
+}
+
+void EditJournal::ReparentEntity(EntityId_t id, EntityId_t newParent)
+{
+    Entity* entity = Entities.GetEntity(id);
+    if (entity == nullptr || entity->Parent == newParent)
+        return;
+
+    ReparentEntry* entry = new ReparentEntry();
+    entry->Id = id;
+    entry->OldParent = entity->Parent;
+    entry->NewParent = newParent;
+    Record(entry);
+
+    Entities.ReparentEntity(id, newParent);
+}
+
+void EditJournal::RenameEntity(EntityId_t id, const char* name)
+{
+    if (Entities.GetEntity(id) == nullptr || strcmp(Entities.GetEntityName(id), name) == 0)
+        return;
+
+    RenameEntry* entry = new RenameEntry();
+    entry->Id = id;
+    entry->OldName = Entities.GetEntityName(id);
+    entry->NewName = name;
+
+    Entities.SetEntityName(id, name);
+
+    if (InteractionOpen && Position == History.size() && Position > 0 && History.back()->Merge(entry))
+    {
+        delete entry;
+        return;
+    }
+
+    Record(entry);
+    InteractionOpen = true;
+}
+
+Component* EditJournal::AddComponent(size_t typeId, EntityId_t id)
+{
+    Component* component = ComponentManager::Create(typeId, id, Entities);
+    if (component == nullptr)
+        return nullptr;
+
+    ComponentEntry* entry = new ComponentEntry();
+    entry->Entity = id;
+    entry->ComponentId = component->Id();
+    entry->TypeId = component->TypeId();
+    entry->Key = HashComponentName(component->ComponentName());
+    entry->Index = GetComponentIndex(Entities, component);
+    entry->Added = true;
+    Record(entry);
+
+    return component;
+}
+
+void EditJournal::RemoveComponent(Component* component)
+{
+    if (component == nullptr)
+        return;
+
+    ComponentEntry* entry = new ComponentEntry();
+    entry->Entity = component->EntityId;
+    entry->ComponentId = component->Id();
+    entry->TypeId = component->TypeId();
+    entry->Key = HashComponentName(component->ComponentName());
+    entry->Index = GetComponentIndex(Entities, component);
+    entry->Added = false;
+    entry->Remove(Entities);
+    Record(entry);
+}
+
+void EditJournal::BeginFieldEdit(Component* component)
+{
+    const FieldTable* table = component->GetFieldTable();
+    if (table == nullptr || table->Count == 0)
+        return;
+
+    PendingEdit pending;
+    pending.Target = component;
+    pending.DataOffset = PendingData.size();
+
+    PendingData.resize(PendingData.size() + table->DataSize);
+    Reflection::SaveFields(*table, component, PendingData.data() + pending.DataOffset);
+
+    PendingEdits.push_back(pending);
+}
+
+bool EditJournal::EndFieldEdits()
+{
+    if (PendingEdits.empty())
+        return false;
+
+    FieldEditEntry* entry = nullptr;
+
+    for (const PendingEdit& pending : PendingEdits)
+    {
+        Component* component = pending.Target;
+        const FieldTable& table = *component->GetFieldTable();
+        const uint8_t* before = PendingData.data() + pending.DataOffset;
+        const uint8_t* object = reinterpret_cast<const uint8_t*>(component);
+
+        uint64_t mask = Reflection::DiffRecord(table, before, component);
+        if (mask == 0)
+            continue;
+
+        Entities.MarkComponentChanged(component);
+
+        size_t changedSize = 0;
+        for (size_t i = 0; i < table.Count; i++)
+        {
+            if (Reflection::IsFieldInMask(mask, i))
+                changedSize += table.Fields[i].Size;
+        }
+
+        if (entry == nullptr)
+            entry = new FieldEditEntry();
+
+        FieldEditEntry::Target target;
+        target.Entity = component->EntityId;
+        target.ComponentId = component->Id();
+        target.TypeId = component->TypeId();
+        target.Index = GetComponentIndex(Entities, component);
+        target.Mask = mask;
+        target.DataOffset = entry->Data.size();
+        target.DataSize = changedSize;
+
+        entry->Data.resize(entry->Data.size() + changedSize * 2);
+        uint8_t* oldValues = entry->Data.data() + target.DataOffset;
+        uint8_t* newValues = oldValues + changedSize;
+
+        const uint8_t* value = before;
+        for (size_t i = 0; i < table.Count; i++)
+        {
+            const FieldInfo& field = table.Fields[i];
+            if (Reflection::IsFieldInMask(mask, i))
+            {
+                memcpy(oldValues, value, field.Size);
+                memcpy(newValues, object + field.Offset, field.Size);
+                oldValues += field.Size;
+                newValues += field.Size;
+            }
+            value += field.Size;
+        }
+
+        entry->Targets.push_back(target);
+    }
+
+    PendingEdits.clear();
+    PendingData.clear();
+
+    if (entry == nullptr)
+        return false;
+
+    entry->Targets.shrink_to_fit();
+    entry->Data.shrink_to_fit();
+
+    if (InteractionOpen && Position == History.size() && Position > 0 && History.back()->Merge(entry))
+    {
+        delete entry;
+        return true;
+    }
+
+    Record(entry);
+    InteractionOpen = true;
+    return true;
+}
+
+void EditJournal::EndInteraction()
+{
+    InteractionOpen = false;
+}
+
+bool EditJournal::Undo()
+{
+    if (!CanUndo())
+        return false;
+
+    EndInteraction();
+    Position--;
+    History[Position]->Undo(Entities);
+    return true;
+}
+
+bool EditJournal::Redo()
+{
+    if (!CanRedo())
+        return false;
+
+    EndInteraction();
+    History[Position]->Redo(Entities);
+    Position++;
+    return true;
+}
+
+void EditJournal::Clear()
+{
+    History.clear();
+    Position = 0;
+    BytesUsed = 0;
+    InteractionOpen = false;
+    PendingEdits.clear();
+    PendingData.clear();
+}
@@ -2,4 +2,78 @@
 
 #include "entity_manager.h"
 
-// TODO, undo/redo here
\ No newline at end of file
+#include <deque>
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+class EditEntry;
+
+// the undo/redo history for a scene
+// structural changes are made through the journal, property edits are recorded after the inspectors
+// write them, as deltas of just the fields that changed (found with the reflection tables)
+class EditJournal
+{
+public:
+    EditJournal(EntitySet& entities);
+    ~EditJournal();
+
+    // the oldest entries are dropped to keep the history under this many bytes
+    size_t ByteBudget = 16 * 1024 * 1024;
+
+    EntityId_t CreateEntity(EntityId_t parent, const char* name);
+    void RemoveEntity(EntityId_t id);
+    void ReparentEntity(EntityId_t id, EntityId_t newParent);
+    void RenameEntity(EntityId_t id, const char* name);
+
+    // typeId is the key of ComponentManager::GetComponentList
+    Component* AddComponent(size_t typeId, EntityId_t id);
+    void RemoveComponent(Component* component);
+
+    /// <summary>
+    /// Note the fields of a component before something edits it in place
+    /// Any number of components can be noted, EndFieldEdits records all of their changes as one entry
+    /// </summary>
+    void BeginFieldEdit(Component* component);
+
+    /// <summary>
+    /// Record what changed since BeginFieldEdit, nothing is recorded if no field did
+    /// While an interaction is open, edits to the same fields of the same components merge into the last entry
+    /// </summary>
+    /// <returns>True if anything changed</returns>
+    bool EndFieldEdits();
+
+    // a drag or a text edit finished, the next edit starts a new entry
+    void EndInteraction();
+
+    bool Undo();
+    bool Redo();
+    void Clear();
+
+    inline bool CanUndo() const { return Position > 0; }
+    inline bool CanRedo() const { return Position < History.size(); }
+
+    inline size_t GetEntryCount() const { return History.size(); }
+    inline size_t GetBytesUsed() const { return BytesUsed; }
+
+private:
+    void Record(EditEntry* entry);
+
+    EntitySet& Entities;
+
+    std::deque<std::unique_ptr<EditEntry>> History;
+    size_t Position = 0;            // entries before this are done, the rest can be redone
+    size_t BytesUsed = 0;
+
+    // the last entry can still take merged edits
+    bool InteractionOpen = false;
+
+    struct PendingEdit
+    {
+        Component* Target = nullptr;
+        size_t DataOffset = 0;
+    };
+    std::vector<PendingEdit> PendingEdits;
+    std::vector<uint8_t> PendingData;
+};
@@ -29,7 +29,7 @@
 **********************************************************************************************/
 
 #include "graphics/shader_manager.h"
-
+#include "profiler.h"
 
 std::vector<std::string> GetFileLines(const char* fileName)
 {
@@ -159,6 +159,8 @@ ShaderInstance& ShaderManager::GetShader(int materialIndex)
 
 ShaderInstance& ShaderManager::LoadShader(int materialIndex, const char* vertextShaderPath, const char* fragmentShaderPath)
 {
+    PROFILE_SCOPE("ShaderManager::LoadShader");
+
     ShaderInstance newInstance;
     if (vertextShaderPath == nullptr)
     {
@@ -14,17 +14,26 @@ public:
 
     const char* DisplayName(Component*) override { return "Transform"; }
 
-    void ShowContent(Component* component) override
+    bool ShowContent(Component* component) override
     {
         TransformComponent* transform = static_cast<TransformComponent*>(component);
+        bool edited = false;
 
         Vector3 pos = transform->GetPosition();
         if (ImGui::DragFloat3("Position", &pos.x, 0.1f))
+        {
             transform->SetPosition(pos);
+            edited = true;
+        }
 
         Vector3 rot = QuaternionToEuler(transform->GetOrientation());
         if (ImGui::DragFloat3("Rotation", &rot.x, 0.25f, -180.0f, 180.0f))
+        {
             transform->SetOrientation(rot);
+            edited = true;
+        }
+
+        return edited;
     }
 };
 
@@ -58,30 +67,34 @@ public:
         return "Shape";
     }
 
-    void ShowContent(Component* component) override
+    bool ShowContent(Component* component) override
     {
         ShapeComponent* shape = static_cast<ShapeComponent*>(component);
+        bool edited = false;
 
         if (ImGui::BeginCombo("Shape", GetShapeName(shape->ObjectShape), ImGuiComboFlags_PopupAlignLeft))
         {
-            if (ImGui::Selectable(GetShapeName(DrawShape::Box), shape->ObjectShape == DrawShape::Box))
-                shape->ObjectShape = DrawShape::Box;
-
-            if (ImGui::Selectable(GetShapeName(DrawShape::Sphere), shape->ObjectShape == DrawShape::Sphere))
-                shape->ObjectShape = DrawShape::Sphere;
-
-            if (ImGui::Selectable(GetShapeName(DrawShape::Cylinder), shape->ObjectShape == DrawShape::Cylinder))
-                shape->ObjectShape = DrawShape::Cylinder;
-
-            if (ImGui::Selectable(GetShapeName(DrawShape::Plane), shape->ObjectShape == DrawShape::Plane))
-                shape->ObjectShape = DrawShape::Plane;
+            for (DrawShape option : { DrawShape::Box, DrawShape::Sphere, DrawShape::Cylinder, DrawShape::Plane })
+            {
+                if (ImGui::Selectable(GetShapeName(option), shape->ObjectShape == option))
+                {
+                    shape->ObjectShape = option;
+                    edited = true;
+                }
+            }
 
             ImGui::EndCombo();
         }
 
-        ImGui::DragFloat3("Position", &shape->ObjectOrigin.x, 0.1f);
-        ImGui::DragFloat3("Rotation", &shape->ObjectOrientationShift.x, 0.25f, -180.0f, 180.0f);
-        ImGui::DragFloat3("Size", &shape->ObjectSize.x, 0.1f);
+        // the widgets go first so every one of them is drawn
+        edited = ImGui::DragFloat3("Position", &shape->ObjectOrigin.x, 0.1f) || edited;
+        edited = ImGui::DragFloat3("Rotation", &shape->ObjectOrientationShift.x, 0.25f, -180.0f, 180.0f) || edited;
+        edited = ImGui::DragFloat3("Size", &shape->ObjectSize.x, 0.1f) || edited;
+
+        if (shape->ObjectShape == DrawShape::Box || shape->ObjectShape == DrawShape::Plane)
+            edited = ImGui::Checkbox("Occluder", &shape->Occluder) || edited;
+
+        return edited;
     }
 };
 
@@ -5,14 +5,16 @@
 #include <map>
 
 
-void ComponentInspector::Inspect(Component* component)
+bool ComponentInspector::Inspect(Component* component)
 {
+    bool edited = false;
     if (Header(component, DisplayName(component)))
     {
         BeginContent(component);
-        ShowContent(component);
+        edited = ShowContent(component);
         EndContent();
     }
+    return edited;
 }
 
 bool ComponentInspector::Header(Component* component, const char* name)
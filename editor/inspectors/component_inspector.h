@@ -5,9 +5,10 @@
 class ComponentInspector
 {
 public:
-    virtual void Inspect(Component* component);
+    // true if anything in the component was edited
+    virtual bool Inspect(Component* component);
     virtual const char* DisplayName(Component* component) { return component->ComponentName(); }
-    virtual void ShowContent(Component* component) {}
+    virtual bool ShowContent(Component* component) { return false; }
 
     virtual size_t ComponentTypeId() { return 0; }
 
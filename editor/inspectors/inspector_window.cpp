@@ -36,6 +36,11 @@
 #include "ui/imgui_buttons.h"
 #include "ui/imgui_dialogs.h"
 
+#include "application/platform_tools.h"
+#include "frame_stats.h"
+
+#include <algorithm>
+
 namespace Inspectors
 {
     void ShowTextureInspector(const Texture& texture, float width)
@@ -112,10 +117,11 @@ namespace Inspectors
 }
 
 
-InspectorWindow::InspectorWindow(SceneData& scene, EntitySelection& selection)
+InspectorWindow::InspectorWindow(SceneData& scene, EntitySelection& selection, EditJournal& journal)
     : UIWindow()
     , Scene(scene)
     , Selection(selection)
+    , Journal(journal)
 {
     Shown = true;
 }
@@ -145,6 +151,95 @@ void InspectorWindow::ShowCommonData(MainView* view) const
     ImGui::Text("Mouse X%.0f Y%.0f", mouse.x, mouse.y);
 }
 
+void InspectorWindow::ShowFrameStats() const
+{
+    if (!ImGui::CollapsingHeader("Frame Times"))
+        return;
+
+    if (ImGui::BeginTable("###FrameTimes", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders))
+    {
+        ImGui::TableSetupColumn("ms");
+        ImGui::TableSetupColumn("p50");
+        ImGui::TableSetupColumn("p95");
+        ImGui::TableSetupColumn("p99");
+        ImGui::TableSetupColumn("max");
+        ImGui::TableHeadersRow();
+
+        for (size_t i = 0; i < FrameStats::PhaseCount; i++)
+        {
+            FrameStats::Percentiles stats = FrameStats::GetPercentiles((FrameStats::FramePhase)i);
+
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(FrameStats::GetPhaseName((FrameStats::FramePhase)i));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f", stats.P50);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f", stats.P95);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f", stats.P99);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f", stats.Max);
+        }
+        ImGui::EndTable();
+    }
+
+    float threshold = (float)FrameStats::GetHitchThreshold();
+    ImGui::SetNextItemWidth(100);
+    if (ImGui::DragFloat("Hitch ms", &threshold, 0.5f, 1, 1000, "%.1f"))
+        FrameStats::SetHitchThreshold(threshold);
+
+    ImGui::SameLine();
+    if (ImGui::Button("Save CSV..."))
+    {
+        std::string path = PlatformTools::ShowSaveFileDialog("frame_times.csv", { { "CSV", "csv" } });
+        if (!path.empty())
+        {
+            FrameStats::WriteSummaryCSV(path.c_str());
+
+            std::string framesPath = path.substr(0, path.find_last_of('.')) + "_frames.csv";
+            FrameStats::WriteFramesCSV(framesPath.c_str());
+            TraceLog(LOG_INFO, "Wrote frame times to %s", path.c_str());
+        }
+    }
+
+    const std::deque<FrameStats::Hitch>& hitches = FrameStats::GetHitches();
+    if (hitches.empty())
+        return;
+
+    if (!ImGui::TreeNode("###Hitches", "Hitches (%zu)", hitches.size()))
+        return;
+
+    if (ImGui::SmallButton("Clear"))
+        FrameStats::ClearHitches();
+
+    // newest first, with the slowest zones for each
+    for (auto itr = hitches.rbegin(); itr != hitches.rend(); ++itr)
+    {
+        const FrameStats::Hitch& hitch = *itr;
+        if (ImGui::TreeNode((void*)(uintptr_t)hitch.FrameNumber, "Frame %llu %.1fms", (unsigned long long)hitch.FrameNumber, hitch.PhaseMs[(size_t)FrameStats::FramePhase::Frame]))
+        {
+            for (size_t i = 1; i < FrameStats::PhaseCount; i++)
+                ImGui::Text("%s %.2fms", FrameStats::GetPhaseName((FrameStats::FramePhase)i), hitch.PhaseMs[i]);
+
+            std::vector<const Profiler::Event*> zones;
+            for (const Profiler::Event& event : hitch.Zones)
+            {
+                if (event.Type == Profiler::EventType::Zone)
+                    zones.push_back(&event);
+            }
+            std::sort(zones.begin(), zones.end(), [](const Profiler::Event* a, const Profiler::Event* b) { return a->GetMilliseconds() > b->GetMilliseconds(); });
+
+            ImGui::Separator();
+            for (size_t i = 0; i < zones.size() && i < 10; i++)
+                ImGui::BulletText("%s %.2fms", zones[i]->Name, zones[i]->GetMilliseconds());
+
+            ImGui::TreePop();
+        }
+    }
+    ImGui::TreePop();
+}
+
 void InspectorWindow::ShowComponentPicker()
 {
     ComponentToAdd = 0;
@@ -166,7 +261,13 @@ void InspectorWindow::ShowComponentPicker()
     auto result = [this](ImGui::DialogResult result, ImGui::CallbackDialog*)
     { 
         if (result == ImGui::DialogResult::Accept)
-            ComponentManager::Create(ComponentToAdd, CurrentSelection, Scene.Entities);
+        {
+            // changes made while playing are thrown away on stop, so they are not recorded
+            if (Scene.Run)
+                ComponentManager::Create(ComponentToAdd, CurrentSelection, Scene.Entities);
+            else
+                Journal.AddComponent(ComponentToAdd, CurrentSelection);
+        }
     };
 
     ImGui::CallbackDialog::Show("Component List", ICON_FA_PUZZLE_PIECE, show, result)->InitalSize = ImVec2(300,200);
@@ -175,31 +276,53 @@ void InspectorWindow::ShowComponentPicker()
 void InspectorWindow::OnShow(MainView* view)
 {
     ShowCommonData(view);
+    ShowFrameStats();
     ImGui::Separator();
-    if (CurrentSelection == InvalidEntityId)
+    // an undo can remove the selected entity
+    if (CurrentSelection == InvalidEntityId || Scene.Entities.GetEntity(CurrentSelection) == nullptr)
     {
         ImGui::TextUnformatted(ICON_FA_BAN "  No Selection");
         return;
     }
 
-    Entity* entity = Scene.Entities.GetEntity(CurrentSelection);
-
     if (ImGui::Button(ICON_FA_PLUS))
         ShowComponentPicker();
     
     char buffer[512];
-    strcpy(buffer, entity->Name.c_str());
+    strncpy(buffer, Scene.Entities.GetEntityName(CurrentSelection), 511);
+    buffer[511] = '\0';
     if (ImGui::InputText("Name", buffer, 512))
     {
-        Scene.Entities.GetEntity(CurrentSelection)->Name = buffer;
+        if (Scene.Run)
+            Scene.Entities.SetEntityName(CurrentSelection, buffer);
+        else
+            Journal.RenameEntity(CurrentSelection, buffer);
     }
- 
-    Scene.Entities.DoForEachComponentInEntity(CurrentSelection, [this](Component* component)
+
+    // note the fields before the inspectors run, EndFieldEdits records what they changed
+    if (!Scene.Run)
+        Scene.Entities.DoForEachComponentInEntity(CurrentSelection, [this](Component* component) { Journal.BeginFieldEdit(component); });
+
+    // the inspectors write straight into the components, so let the views know when one of them edited something
+    bool edited = false;
+    Scene.Entities.DoForEachComponentInEntity(CurrentSelection, [&edited](Component* component)
         {
             ComponentInspector* inspector = ComponentInspectorRegistry::Get(component->TypeId());
             if (inspector != nullptr)
-                inspector->Inspect(component);
+                edited = inspector->Inspect(component) || edited;
         });
+
+    if (edited)
+        Scene.Entities.MarkChanged();
+
+    if (!Scene.Run)
+    {
+        Journal.EndFieldEdits();
+
+        // a drag or text edit is one undo step, it ends when the widget is let go
+        if (!ImGui::IsAnyItemActive())
+            Journal.EndInteraction();
+    }
 }
 
 void InspectorWindow::Update()
@@ -215,6 +338,6 @@ void InspectorWindow::Update()
         return;
 
     CurrentSelection = id;
-    Name = Scene.Entities.GetEntity(id)->Name;
+    Name = Scene.Entities.GetEntityName(id);
 }
 
@@ -34,6 +34,7 @@
 #include "outliner/scene_outliner.h"
 
 #include "scene.h"
+#include "edit_system.h"
 
 #include "raylib.h"
 #include "rlImGui.h"
@@ -58,10 +59,11 @@ constexpr char InspectorWindowName[] = " Inspector###RaylibInspectorWindow";
 class InspectorWindow : public UIWindow
 {
 public:
-    InspectorWindow(SceneData& scene, EntitySelection& selection);
+    InspectorWindow(SceneData& scene, EntitySelection& selection, EditJournal& journal);
     void GetName(std::string& name, MainView* view) const override;
     const char* GetMenuName() const override;
     void ShowCommonData(MainView* view) const;
+    void ShowFrameStats() const;
     void OnShow(MainView* view) override;
 
     void Update() override;
@@ -72,6 +74,7 @@ protected:
     void ShowComponentPicker();
 
     EntitySelection& Selection;
+    EditJournal& Journal;
     std::string Name;
 
 private:
@@ -37,6 +37,8 @@
 #include "components/flight_data_component.h"
 #include "components/light_component.h"
 #include "components/look_at_component.h"
+#include "components/prefab_instance_component.h"
+#include "components/world_cell_component.h"
 #include "inspectors/common_inspectors.h"
 #include "view/main_view.h"
 #include "view/scene_view.h"
@@ -48,8 +50,10 @@
 #include "RLAssets.h"
 
 #include "game_components.h"
-
-#include <deque>
+#include "frame_stats.h"
+#include "job_system.h"
+#include "platform_services.h"
+#include "profiler.h"
 
 ApplicationContext GlobalContext;
 
@@ -138,6 +142,30 @@ void DrawOverlay()
     }
 }
 
+// frames to keep drawing after the last event, so ImGui can settle hover and focus changes
+constexpr int ActiveFramesAfterEvent = 3;
+
+bool WantsContinuousUpdate()
+{
+    if (GlobalContext.View != nullptr && GlobalContext.View->WantsContinuousUpdate())
+        return true;
+
+    if (JobSystem::GetPendingTaskCount() > 0)
+        return true;
+
+    if (GlobalContext.ScreenshotView || GlobalContext.TakeScreenshot || GlobalContext.CopyScreenshot)
+        return true;
+
+    if (GlobalContext.Recorder.IsRecording() || GlobalContext.Replayer.IsPlaying())
+        return true;
+
+    // drags and held buttons don't always generate events
+    if (IsMouseButtonDown(0) || IsMouseButtonDown(1) || IsMouseButtonDown(2))
+        return true;
+
+    return ImGui::IsAnyItemActive();
+}
+
 void RegisterComponents()
 {
     ComponentManager::Register<AutoMoverComponent>();
@@ -147,6 +175,8 @@ void RegisterComponents()
     ComponentManager::Register<FlightDataComponent>();
     ComponentManager::Register<LookAtComponent>();
     ComponentManager::Register<LightComponent>();
+    ComponentManager::Register<PrefabInstanceComponent>();
+    ComponentManager::Register<WorldCellComponent>();
 }
 
 #ifdef _WIN32
@@ -155,6 +185,7 @@ int wWinMain(void* hInstance, void* hPrevInstance, char* cmdLine, int show)
 int main(int argc, char* argv[])
 #endif
 {
+    PROFILE_THREAD("Main");
     LogSink::Setup();
 
     GlobalContext.Prefs.Setup();
@@ -185,9 +216,41 @@ int main(int argc, char* argv[])
     GlobalContext.ChangeView(new SceneView());
     GlobalContext.UI.Startup();
 
+    // background jobs finishing may have something new to show
+    JobSystem::SetTaskCompleteCallback(PlatformTools::WakeEventWait);
+
+    int activeFrames = ActiveFramesAfterEvent;
+
     // Main game loop
     while (!GlobalContext.Quit && !WindowShouldClose())    // Detect window close button or ESC key
     {
+        if (GlobalContext.IdleMode && activeFrames <= 0)
+        {
+            if (PlatformTools::WaitForEvents(GlobalContext.IdleTimeout))
+                activeFrames = ActiveFramesAfterEvent;
+
+            // raylib counts the wait as frame time, anything moving by speed * delta would jump by all of it
+            RaylibTimeSource::GetDefault().SkipWait();
+        }
+        else if (activeFrames > 0)
+        {
+            activeFrames--;
+        }
+
+        RaylibTimeSource::GetDefault().BeginFrame();
+        FrameStats::BeginFrame();
+
+        // recorded input is sampled once per frame, before anything reads it
+        if (GlobalContext.Recorder.IsRecording())
+        {
+            GlobalContext.Recorder.NextFrame();
+        }
+        else if (GlobalContext.Replayer.IsPlaying() && !GlobalContext.Replayer.NextFrame())
+        {
+            GlobalContext.Replayer.Stop();
+            TraceLog(LOG_INFO, "Input replay finished");
+        }
+
         if (IsWindowResized())
             GlobalContext.UI.Resized();
 
@@ -202,29 +265,56 @@ int main(int argc, char* argv[])
             }
         }
 
-        GlobalContext.UI.Update();
+        {
+            PROFILE_SCOPE("Update");
+            FrameStats::ScopedPhase phase(FrameStats::FramePhase::Update);
+            GlobalContext.UI.Update();
 
-        if (GlobalContext.View != nullptr)
-            GlobalContext.View->Update();
+            if (GlobalContext.View != nullptr)
+                GlobalContext.View->Update();
+        }
 
         BeginDrawing();
         ClearBackground(DARKGRAY);
 
         if (GlobalContext.View != nullptr)
+        {
+            PROFILE_SCOPE("Render");
+            FrameStats::ScopedPhase phase(FrameStats::FramePhase::Render);
             GlobalContext.View->Show(GlobalContext.View->LastContentArea);
+        }
 
-        BeginRLImGui();
-        GlobalContext.UI.Show(GlobalContext.View);
-        DrawOverlay();
-        ImGui::UpdateDialogs();
-        EndRLImGui();
+        {
+            PROFILE_SCOPE("UI");
+            FrameStats::ScopedPhase phase(FrameStats::FramePhase::UI);
+            BeginRLImGui();
+            GlobalContext.UI.Show(GlobalContext.View);
+            DrawOverlay();
+            ImGui::UpdateDialogs();
+            EndRLImGui();
+        }
 
-        EndDrawing();
+        {
+            PROFILE_SCOPE("Present");
+            FrameStats::ScopedPhase phase(FrameStats::FramePhase::Present);
+            EndDrawing();
+        }
 
         if (!GlobalContext.ScreenshotView)
             ApplicationContext::Screenshot();
+
+        if (WantsContinuousUpdate())
+            activeFrames = ActiveFramesAfterEvent;
+
+        PROFILE_FRAME_MARK();
+        FrameStats::EndFrame();
     }
 
+    JobSystem::SetTaskCompleteCallback(nullptr);
+
+    GlobalContext.Recorder.Stop();
+    GlobalContext.Replayer.Stop();
+
     GlobalContext.Prefs.Save();
 
     GlobalContext.ChangeView(nullptr);
@@ -234,6 +324,8 @@ int main(int argc, char* argv[])
 
     ShutdownRLImGui();
     CloseWindow();
+
+    LogSink::Shutdown();
 }
 
 void ApplicationStartup()
@@ -254,57 +346,4 @@ void ApplicationStartup()
 void ApplicationShutdown()
 {
     rlas_Cleanup();
-    LogSink::Flush();
-}
-
-namespace LogSink
-{
-    std::deque<LogItem> LogLines;
-
-    void GetLogLevelPrefix(int logLevel, LogItem& item)
-    {
-        item.Prefix = GetLogLevelName(logLevel);
-        item.Prefix += ": ";
-        switch (logLevel)
-        {
-        default:            item.Prefix.clear(); item.Color = ImGuiColors::Convert(WHITE); break;
-        case LOG_TRACE:     item.Color = ImGuiColors::Convert(GRAY); break;
-        case LOG_DEBUG:     item.Color = ImGuiColors::Convert(SKYBLUE); break;
-        case LOG_INFO:      item.Color = ImGuiColors::Convert(GREEN); break;
-        case LOG_WARNING:   item.Color = ImGuiColors::Convert(YELLOW); break;
-        case LOG_ERROR:     item.Color = ImGuiColors::Convert(ORANGE); break;
-        case LOG_FATAL:     item.Color = ImGuiColors::Convert(RED); break;
-        }
-    }
-
-    void TraceLog(int logLevel, const char* text, va_list args)
-    {
-        static char logText[2048] = { 0 };
-        LogItem item;
-        item.Level = logLevel;
-        GetLogLevelPrefix(logLevel, item);
-        vsprintf(logText, text, args);
-        item.Text += logText;
-        LogLines.push_back(item);
-    }
-
-    void Setup()
-    {
-        SetTraceLogCallback(TraceLog);
-    }
-
-    bool PopLogLine(LogItem& line)
-    {
-        if (LogLines.size() == 0)
-            return false;
-
-        line = LogLines.front();
-        LogLines.pop_front();
-        return true;
-    }
-
-    void Flush()
-    {
-        LogLines.clear();
-    }
 }
\ No newline at end of file
@@ -40,6 +40,9 @@
 #include "rlImGui.h"
 #include "raylib.h"
 
+#include <algorithm>
+#include <stdio.h>
+
 bool EntitySelection::IsSelected(EntityId_t id)
 {
     return Selection.find(id) != Selection.end();
@@ -47,6 +50,7 @@ bool EntitySelection::IsSelected(EntityId_t id)
 
 void EntitySelection::Select(EntityId_t id, bool selected, bool add)
 {
+    Generation++;
     if (!add)
         Selection.clear();
 
@@ -61,6 +65,7 @@ void EntitySelection::Select(EntityId_t id, bool selected, bool add)
 
 void EntitySelection::Clear()
 {
+    Generation++;
     Selection.clear();
 }
 
@@ -95,42 +100,233 @@ const char* SceneOutliner::GetMenuName() const
     return "Outline";
 }
 
-void SceneOutliner::ShowEntityNode(EntityId_t entityId)
+void SceneOutliner::AddRows(std::vector<OutlinerRow>& rows, EntityId_t entityId, int depth)
+{
+    // walk with a stack, deep scenes would run out of call stack
+    std::vector<std::pair<EntityId_t, int>> stack;
+    stack.emplace_back(entityId, depth);
+
+    while (!stack.empty())
+    {
+        EntityId_t id = stack.back().first;
+        int rowDepth = stack.back().second;
+        stack.pop_back();
+
+        if (id == InvalidEntityId || Entities.HasComponent<EditorHiddenComponent>(id))
+            continue;
+
+        auto* entity = Entities.GetEntity(id);
+        if (entity == nullptr)
+            continue;
+
+        rows.push_back(OutlinerRow{ id, rowDepth, !entity->Children.empty() });
+
+        if (Collapsed.find(id) != Collapsed.end())
+            continue;
+
+        for (auto child = entity->Children.rbegin(); child != entity->Children.rend(); ++child)
+            stack.emplace_back(*child, rowDepth + 1);
+    }
+}
+
+void SceneOutliner::RebuildRows()
+{
+    Rows.clear();
+    Entities.DoForEachRootEntity([this](EntityId_t id) { AddRows(Rows, id, 0); });
+
+    LastHierarchyGeneration = Entities.GetHierarchyGeneration();
+}
+
+void SceneOutliner::UpdateRows()
+{
+    if (LastHierarchyGeneration == Entities.GetHierarchyGeneration())
+        return;
+
+    // patching costs a pass over the rows per changed entity, past a point one rebuild is cheaper
+    // asking on the first frame as well starts the set keeping track of changes
+    if (!Entities.GetHierarchyChanges(LastHierarchyGeneration, ChangedEntities)
+        || ChangedEntities.size() > Rows.size() / 8 + 16)
+    {
+        RebuildRows();
+        return;
+    }
+
+    PatchRows(ChangedEntities);
+    LastHierarchyGeneration = Entities.GetHierarchyGeneration();
+}
+
+void SceneOutliner::PatchRows(const std::vector<EntityId_t>& changed)
+{
+    auto isChanged = [&changed](EntityId_t id) { return std::binary_search(changed.begin(), changed.end(), id); };
+
+    // take out the changed entities with the rows under them, in one pass so the rows only move once
+    // the open row at each depth is kept so a parent that lost a child can be checked again
+    std::vector<size_t> openRows;
+    std::vector<size_t> recheck;
+    size_t write = 0;
+    for (size_t read = 0; read < Rows.size();)
+    {
+        const OutlinerRow& row = Rows[read];
+        if (isChanged(row.Id))
+        {
+            if (row.Depth > 0 && size_t(row.Depth) <= openRows.size())
+                recheck.push_back(openRows[row.Depth - 1]);
+
+            int depth = row.Depth;
+            read++;
+            while (read < Rows.size() && Rows[read].Depth > depth)
+                read++;
+            continue;
+        }
+
+        // the children of a closed row have no rows, so there is nothing to say one of them went away
+        if (row.HasChildren && Collapsed.find(row.Id) != Collapsed.end())
+            recheck.push_back(write);
+
+        openRows.resize(size_t(row.Depth));
+        openRows.push_back(write);
+        Rows[write++] = Rows[read++];
+    }
+    Rows.resize(write);
+
+    for (size_t row : recheck)
+    {
+        auto* entity = Entities.GetEntity(Rows[row].Id);
+        Rows[row].HasChildren = entity != nullptr && !entity->Children.empty();
+    }
+
+    // put back the ones that still exist, parents first so each child finds its parent's row
+    std::vector<std::pair<size_t, EntityId_t>> added;
+    for (EntityId_t id : changed)
+    {
+        if (Entities.GetEntity(id) != nullptr)
+            added.emplace_back(Entities.GetParentCount(id), id);
+    }
+    std::sort(added.begin(), added.end());
+
+    for (const auto& entity : added)
+        InsertRows(entity.second);
+}
+
+void SceneOutliner::InsertRows(EntityId_t entityId)
 {
-    if (entityId == InvalidEntityId || Entities.HasComponent<EditorHiddenComponent>(entityId))
+    auto* entity = Entities.GetEntity(entityId);
+
+    // an entity that came in under one already put back is in its rows
+    auto inRows = [this](EntityId_t id) { return std::find_if(Rows.begin(), Rows.end(), [id](const OutlinerRow& row) { return row.Id == id; }); };
+
+    size_t row = 0;
+    int depth = 0;
+    const std::vector<EntityId_t>* siblings = nullptr;
+    if (entity->Parent != InvalidEntityId)
+    {
+        auto parentRow = inRows(entity->Parent);
+        if (parentRow == Rows.end())
+            return;
+
+        // a closed parent only has to show that it has something in it
+        parentRow->HasChildren = true;
+        if (Collapsed.find(entity->Parent) != Collapsed.end())
+            return;
+
+        auto* parent = Entities.GetEntity(entity->Parent);
+        siblings = &parent->Children;
+        depth = parentRow->Depth + 1;
+        row = size_t(parentRow - Rows.begin()) + 1;
+    }
+
+    if (inRows(entityId) != Rows.end())
         return;
 
+    // skip the rows of the siblings that come first, roots are in id order and children in the order the parent has them
+    // the sibling rows are in that same order, so one walk down the list keeps up with the rows
+    size_t place = siblings != nullptr ? size_t(std::find(siblings->begin(), siblings->end(), entityId) - siblings->begin()) : 0;
+    size_t sibling = 0;
+    while (row < Rows.size() && Rows[row].Depth >= depth)
+    {
+        if (Rows[row].Depth == depth)
+        {
+            bool before = Rows[row].Id < entityId;
+            if (siblings != nullptr)
+            {
+                while (sibling < place && (*siblings)[sibling] != Rows[row].Id)
+                    sibling++;
+                before = sibling < place;
+            }
+            if (!before)
+                break;
+        }
+        row++;
+    }
+
+    std::vector<OutlinerRow> rows;
+    AddRows(rows, entityId, depth);
+    Rows.insert(Rows.begin() + row, rows.begin(), rows.end());
+}
+
+void SceneOutliner::ToggleRow(size_t row)
+{
+    OutlinerRow& toggled = Rows[row];
+
+    // opening and closing only touches the rows under the node
+    if (Collapsed.erase(toggled.Id) == 0)
+    {
+        Collapsed.insert(toggled.Id);
+
+        size_t end = row + 1;
+        while (end < Rows.size() && Rows[end].Depth > toggled.Depth)
+            end++;
+
+        Rows.erase(Rows.begin() + row + 1, Rows.begin() + end);
+    }
+    else
+    {
+        std::vector<OutlinerRow> children;
+        AddRows(children, toggled.Id, toggled.Depth);
+        if (children.size() > 1)
+            Rows.insert(Rows.begin() + row + 1, children.begin() + 1, children.end());
+    }
+}
+
+void SceneOutliner::ShowEntityRow(size_t row)
+{
+    EntityId_t entityId = Rows[row].Id;
+
     auto* entity = Entities.GetEntity(entityId);
     if (entity == nullptr)
         return;
 
-    std::string displayName = entity->Name;
-    if (displayName.empty())
-        displayName = TextFormat("Entity-%ul", entityId);
+    const char* displayName = Entities.GetNameTable().Get(entity->NameId);
+    char defaultName[32];
+    if (entity->NameId == EmptyName)
+    {
+        snprintf(defaultName, sizeof(defaultName), "Entity-%llu", (unsigned long long)entityId);
+        displayName = defaultName;
+    }
 
     bool selected = Selection.IsSelected(entityId);
 
-    float x = ImGui::GetCursorPosX();
-
     bool toggle = ImGui::IsKeyDown(KEY_LEFT_CONTROL) || ImGui::IsKeyDown(KEY_RIGHT_CONTROL);
 
-    bool open = false;
-    if (!entity->Children.empty())
+    ImGui::PushID((int)entityId);
+    ImGui::SetCursorPosX(ImGui::GetCursorPosX() + (Rows[row].Depth + 1) * ImGui::GetStyle().IndentSpacing);
+
+    bool toggleOpen = false;
+    if (Rows[row].HasChildren)
     {
-        open = ImGui::TreeNodeExV(&entityId, ImGuiTreeNodeFlags_DefaultOpen, "", 0);
+        bool wasOpen = Collapsed.find(entityId) == Collapsed.end();
+        ImGui::SetNextItemOpen(wasOpen);
+        toggleOpen = ImGui::TreeNodeEx("##Node", ImGuiTreeNodeFlags_NoTreePushOnOpen) != wasOpen;
         ImGui::SameLine();
     }
 
-    if (ImGui::Selectable(displayName.c_str(), &selected, ImGuiSelectableFlags_None))
+    if (ImGui::Selectable(displayName, &selected, ImGuiSelectableFlags_None))
         Selection.Select(entityId, selected | !toggle, toggle);
 
-    if (open)
-    {
-        for (EntityId_t child : Entities.GetEntity(entityId)->Children)
-            ShowEntityNode(child);
+    ImGui::PopID();
 
-        ImGui::TreePop();
-    }
+    if (toggleOpen)
+        ToggleRow(row);
 }
 
 void SceneOutliner::OnShow(MainView * view)
@@ -147,6 +343,8 @@ void SceneOutliner::OnShow(MainView * view)
             CreateEntityCallback(GetRootmostEntity());
     }
 
+    UpdateRows();
+
     if (ImGui::BeginChild("Root", ImVec2(ImGui::GetContentRegionAvailWidth(), ImGui::GetContentRegionAvail().y - 30), true))
     {
         bool selected = false;
@@ -158,10 +356,14 @@ void SceneOutliner::OnShow(MainView * view)
                 Selection.Clear();
         }
 
-        ImGui::TreePush();
-        Entities.DoForEachRootEntity([this](EntityId_t id) {ShowEntityNode(id); });
-
-        ImGui::TreePop();
+        // only the rows that are on screen get drawn
+        ImGuiListClipper clipper;
+        clipper.Begin((int)Rows.size());
+        while (clipper.Step())
+        {
+            for (int row = clipper.DisplayStart; row < clipper.DisplayEnd && row < (int)Rows.size(); row++)
+                ShowEntityRow(size_t(row));
+        }
  
         ImGui::EndChild();
     }
@@ -37,6 +37,7 @@
 
 #include <functional>
 #include <set>
+#include <vector>
 
 constexpr char SceneOutlinerWindowName[] = ICON_FA_LIST_ALT " Scene Outline###rlECSSceneOutlinerWindow";
 
@@ -44,6 +45,7 @@ class EntitySelection
 {
 private:
     std::set<EntityId_t> Selection;
+    uint64_t Generation = 0;
 
 public:
     bool IsSelected(EntityId_t id);
@@ -53,6 +55,9 @@ public:
 
     inline EntityId_t Begin() { return IsEmpty() ? InvalidEntityId : *Selection.begin(); }
 
+    // bumped whenever the selection changes
+    inline uint64_t GetGeneration() const { return Generation; }
+
     const std::set<EntityId_t> GetSelection();
 
     void DoForEach(std::function<void(EntityId_t)>func);
@@ -64,7 +69,7 @@ public:
     SceneOutliner(EntitySet& entities);
     void GetName(std::string& name, MainView* view) const override;
     const char* GetMenuName() const override;
-    void ShowEntityNode(EntityId_t entityId);
+    void ShowEntityRow(size_t row);
     void OnShow(MainView* view) override;
 
     EntitySelection Selection;
@@ -75,6 +80,26 @@ protected:
     EntityId_t GetRootmostParent();
     EntityId_t GetRootmostEntity();
 
+    // the tree flattened into the rows that are open, patched for the entities that changed and only rebuilt when the whole scene does
+    struct OutlinerRow
+    {
+        EntityId_t Id = InvalidEntityId;
+        int Depth = 0;
+        bool HasChildren = false;
+    };
+
+    void RebuildRows();
+    void UpdateRows();
+    void PatchRows(const std::vector<EntityId_t>& changed);
+    void InsertRows(EntityId_t entityId);
+    void AddRows(std::vector<OutlinerRow>& rows, EntityId_t entityId, int depth);
+    void ToggleRow(size_t row);
+
 protected:
     EntitySet& Entities;
+
+    std::vector<OutlinerRow> Rows;
+    std::set<EntityId_t> Collapsed;
+    uint64_t LastHierarchyGeneration = uint64_t(-1);
+    std::vector<EntityId_t> ChangedEntities;
 };
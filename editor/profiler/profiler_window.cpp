@@ -0,0 +1,298 @@
+/**********************************************************************************************
+*
+*   raylib_ECS_sample * a sample Entity Component System using raylib
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+
+#include "profiler/profiler_window.h"
+
+#include "application/platform_tools.h"
+
+#include "raylib.h"
+#include "imgui.h"
+
+#include <algorithm>
+#include <map>
+
+ProfilerWindow::ProfilerWindow() : UIWindow()
+{
+    Shown = false;
+}
+
+static ImU32 GetZoneColor(const char* name)
+{
+    // stable color per zone name
+    uint32_t hash = 2166136261u;
+    for (const char* c = name; *c != '\0'; c++)
+        hash = (hash ^ (uint8_t)*c) * 16777619u;
+
+    return IM_COL32(80 + (hash & 0x7f), 80 + ((hash >> 8) & 0x7f), 80 + ((hash >> 16) & 0x7f), 255);
+}
+
+// frames marked while paused are not stored, so ids have gaps and can't be used as indexes
+static size_t FindFrameIndex(const std::deque<Profiler::FrameRecord>& frames, uint64_t frameId)
+{
+    auto itr = std::lower_bound(frames.begin(), frames.end(), frameId,
+        [](const Profiler::FrameRecord& frame, uint64_t id) { return frame.FrameId < id; });
+    return size_t(itr - frames.begin());
+}
+
+const Profiler::FrameRecord* ProfilerWindow::GetSelectedFrame(const std::deque<Profiler::FrameRecord>& frames)
+{
+    if (frames.empty())
+        return nullptr;
+
+    size_t index = FindFrameIndex(frames, SelectedFrameId);
+    if (FollowLatest || index == frames.size())
+        index = frames.size() - 1;
+
+    // a selection that fell in a gap moves to the next stored frame
+    SelectedFrameId = frames[index].FrameId;
+    return &frames[index];
+}
+
+void ProfilerWindow::OnShow(MainView*)
+{
+    ShowToolbar();
+
+#ifndef RLECS_PROFILER
+    ImGui::TextUnformatted("Profiling is not enabled in this build (define RLECS_PROFILER)");
+#endif
+
+    const std::deque<Profiler::FrameRecord>& frames = Profiler::GetFrames();
+    const Profiler::FrameRecord* frame = GetSelectedFrame(frames);
+    if (frame == nullptr)
+        return;
+
+    ShowFrameGraph(frames);
+    ShowTimeline(*frame);
+    ShowZoneStats(frames, *frame);
+}
+
+void ProfilerWindow::ShowToolbar()
+{
+    bool paused = Profiler::IsPaused();
+    if (ImGui::Checkbox("Pause", &paused))
+        Profiler::SetPaused(paused);
+
+    ImGui::SameLine();
+    ImGui::Checkbox("Follow", &FollowLatest);
+
+    ImGui::SameLine();
+    if (ImGui::Button("Export Trace..."))
+    {
+        std::string path = PlatformTools::ShowSaveFileDialog("trace.json", { { "Chrome Trace", "json" } });
+        if (!path.empty())
+        {
+            if (Profiler::ExportChromeTrace(path.c_str()))
+                TraceLog(LOG_INFO, "Wrote profiler trace to %s", path.c_str());
+            else
+                TraceLog(LOG_WARNING, "Unable to write profiler trace to %s", path.c_str());
+        }
+    }
+
+    size_t dropped = Profiler::GetDroppedEvents();
+    if (dropped > 0)
+    {
+        ImGui::SameLine();
+        ImGui::TextColored(ImVec4(1, 1, 0, 1), "%zu events dropped", dropped);
+    }
+}
+
+void ProfilerWindow::ShowFrameGraph(const std::deque<Profiler::FrameRecord>& frames)
+{
+    FrameTimes.clear();
+    float maxTime = 0;
+    for (const Profiler::FrameRecord& frame : frames)
+    {
+        FrameTimes.push_back((float)frame.GetMilliseconds());
+        maxTime = std::max(maxTime, FrameTimes.back());
+    }
+
+    size_t selectedIndex = std::min(FindFrameIndex(frames, SelectedFrameId), FrameTimes.size() - 1);
+    ImGui::PlotHistogram("###FrameTimes", FrameTimes.data(), (int)FrameTimes.size(), 0, TextFormat("Frame %llu %.2fms", (unsigned long long)SelectedFrameId, FrameTimes[selectedIndex]), 0, std::max(maxTime, 16.6f), ImVec2(ImGui::GetContentRegionAvail().x, 60));
+
+    // clicking a bar stops following and shows that frame
+    if (ImGui::IsItemHovered() && ImGui::IsMouseClicked(ImGuiMouseButton_Left))
+    {
+        float t = (ImGui::GetMousePos().x - ImGui::GetItemRectMin().x) / std::max(ImGui::GetItemRectSize().x, 1.0f);
+        size_t index = std::min((size_t)(std::max(t, 0.0f) * FrameTimes.size()), FrameTimes.size() - 1);
+        SelectedFrameId = frames[index].FrameId;
+        FollowLatest = false;
+    }
+}
+
+void ProfilerWindow::ShowTimeline(const Profiler::FrameRecord& frame)
+{
+    Threads = Profiler::GetThreads();
+
+    // one lane per zone depth, per thread
+    std::vector<int> threadDepths(Threads.size(), 0);
+    for (const Profiler::Event& event : frame.Events)
+    {
+        if (event.Type == Profiler::EventType::Zone && event.Thread < threadDepths.size())
+            threadDepths[event.Thread] = std::max(threadDepths[event.Thread], event.Depth + 1);
+    }
+
+    float laneHeight = ImGui::GetTextLineHeightWithSpacing();
+    float labelWidth = 90;
+    float height = 0;
+    for (int depth : threadDepths)
+        height += std::max(depth, 1) * laneHeight + 4;
+
+    if (!ImGui::BeginChild("###Timeline", ImVec2(0, std::min(height + 4, 300.0f)), true))
+    {
+        ImGui::EndChild();
+        return;
+    }
+
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    ImVec2 origin = ImGui::GetCursorScreenPos();
+    float width = std::max(ImGui::GetContentRegionAvail().x - labelWidth, 1.0f);
+    double duration = (double)std::max<uint64_t>(frame.End - frame.Start, 1);
+
+    std::vector<float> threadY(Threads.size(), 0);
+    float y = origin.y;
+    for (size_t i = 0; i < Threads.size(); i++)
+    {
+        threadY[i] = y;
+        drawList->AddText(ImVec2(origin.x, y), ImGui::GetColorU32(ImGuiCol_Text), Threads[i].Name.c_str());
+        y += std::max(threadDepths[i], 1) * laneHeight + 4;
+        drawList->AddLine(ImVec2(origin.x, y - 2), ImVec2(origin.x + labelWidth + width, y - 2), ImGui::GetColorU32(ImGuiCol_Separator));
+    }
+
+    const Profiler::Event* hovered = nullptr;
+    ImVec2 mouse = ImGui::GetMousePos();
+
+    for (const Profiler::Event& event : frame.Events)
+    {
+        if (event.Type != Profiler::EventType::Zone || event.Thread >= Threads.size())
+            continue;
+
+        // zones can start in the frame before, clamp them to the visible range
+        double start = std::max(0.0, (double)((int64_t)(event.Start - frame.Start)) / duration);
+        double end = std::min(1.0, (double)((int64_t)(event.End - frame.Start)) / duration);
+        if (end < start)
+            continue;
+
+        ImVec2 min(origin.x + labelWidth + (float)(start * width), threadY[event.Thread] + event.Depth * laneHeight);
+        ImVec2 max(std::max(origin.x + labelWidth + (float)(end * width), min.x + 1), min.y + laneHeight - 1);
+
+        drawList->AddRectFilled(min, max, GetZoneColor(event.Name));
+        if (max.x - min.x > 30)
+        {
+            drawList->PushClipRect(min, max, true);
+            drawList->AddText(ImVec2(min.x + 2, min.y), IM_COL32_WHITE, event.Name);
+            drawList->PopClipRect();
+        }
+
+        if (mouse.x >= min.x && mouse.x < max.x && mouse.y >= min.y && mouse.y < max.y)
+            hovered = &event;
+    }
+
+    ImGui::Dummy(ImVec2(labelWidth + width, y - origin.y));
+
+    if (hovered != nullptr && ImGui::IsWindowHovered())
+        ImGui::SetTooltip("%s\n%.3fms", hovered->Name, hovered->GetMilliseconds());
+
+    ImGui::EndChild();
+}
+
+void ProfilerWindow::ShowZoneStats(const std::deque<Profiler::FrameRecord>& frames, const Profiler::FrameRecord& frame)
+{
+    struct ZoneStats
+    {
+        size_t Calls = 0;
+        double TotalMs = 0;
+        double MaxMs = 0;
+        double HistoryMs = 0;
+    };
+
+    // zones from different files can have the same name in different strings, so key on the text
+    std::map<std::string, ZoneStats> zones;
+    std::map<std::string, double> counters;
+
+    for (const Profiler::Event& event : frame.Events)
+    {
+        if (event.Type == Profiler::EventType::Counter)
+        {
+            counters[event.Name] = event.Value;
+            continue;
+        }
+
+        ZoneStats& stats = zones[event.Name];
+        double ms = event.GetMilliseconds();
+        stats.Calls++;
+        stats.TotalMs += ms;
+        stats.MaxMs = std::max(stats.MaxMs, ms);
+    }
+
+    for (const Profiler::FrameRecord& historyFrame : frames)
+    {
+        for (const Profiler::Event& event : historyFrame.Events)
+        {
+            if (event.Type != Profiler::EventType::Zone)
+                continue;
+
+            auto itr = zones.find(event.Name);
+            if (itr != zones.end())
+                itr->second.HistoryMs += event.GetMilliseconds();
+        }
+    }
+
+    std::vector<std::pair<std::string, ZoneStats>> sorted(zones.begin(), zones.end());
+    std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return a.second.TotalMs > b.second.TotalMs; });
+
+    if (ImGui::BeginTable("###ZoneStats", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders | ImGuiTableFlags_Resizable | ImGuiTableFlags_ScrollY, ImVec2(0, ImGui::GetContentRegionAvail().y * 0.75f)))
+    {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Zone");
+        ImGui::TableSetupColumn("Calls");
+        ImGui::TableSetupColumn("Total ms");
+        ImGui::TableSetupColumn("Max ms");
+        ImGui::TableSetupColumn("Avg ms/frame");
+        ImGui::TableHeadersRow();
+
+        for (auto& zone : sorted)
+        {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(zone.first.c_str());
+            ImGui::TableNextColumn();
+            ImGui::Text("%zu", zone.second.Calls);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", zone.second.TotalMs);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", zone.second.MaxMs);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", zone.second.HistoryMs / frames.size());
+        }
+        ImGui::EndTable();
+    }
+
+    for (auto& counter : counters)
+        ImGui::Text("%s: %g", counter.first.c_str(), counter.second);
+}
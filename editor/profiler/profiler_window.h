@@ -0,0 +1,63 @@
+/**********************************************************************************************
+*
+*   raylib_ECS_sample * a sample Entity Component System using raylib
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+
+#pragma once
+
+#include "application/ui_window.h"
+
+#include "profiler.h"
+
+#include <string>
+#include <vector>
+
+constexpr char ProfilerWindowName[] = ICON_FA_STOPWATCH " Profiler###ProfilerWindow";
+
+class ProfilerWindow : public UIWindow
+{
+public:
+    ProfilerWindow();
+    inline void GetName(std::string& name, MainView* view) const override { name = ProfilerWindowName; }
+    inline const char* GetMenuName() const override { return "Profiler"; }
+    void OnShow(MainView* view) override;
+
+protected:
+    void ShowToolbar();
+    void ShowFrameGraph(const std::deque<Profiler::FrameRecord>& frames);
+    void ShowTimeline(const Profiler::FrameRecord& frame);
+    void ShowZoneStats(const std::deque<Profiler::FrameRecord>& frames, const Profiler::FrameRecord& frame);
+
+    const Profiler::FrameRecord* GetSelectedFrame(const std::deque<Profiler::FrameRecord>& frames);
+
+private:
+    bool FollowLatest = true;
+    uint64_t SelectedFrameId = 0;
+
+    std::vector<float> FrameTimes;
+    std::vector<Profiler::ThreadInfo> Threads;
+};
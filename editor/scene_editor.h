@@ -1,6 +1,7 @@
 #pragma once
 
 #include "scene.h"
+#include "edit_system.h"
 #include "outliner/scene_outliner.h"
 
 #include <memory>
@@ -13,6 +14,9 @@ public:
 
     void CreateEntity(EntityId_t parentId);
 
+    // edits made outside of play mode
+    EditJournal Journal;
+
 protected:
     SceneData& Scene;
     std::shared_ptr<SceneOutliner> Outliner = nullptr;
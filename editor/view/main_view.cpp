@@ -32,6 +32,7 @@
 #include "graphics/drawing_utils.h"
 #include "inspectors/inspector_window.h"
 #include "application/platform_tools.h"
+#include "profiler.h"
 
 #include "raylib.h"
 #include "rlgl.h"
@@ -133,21 +134,26 @@ void ThreeDView::Show(const Rectangle& contentArea)
     if (SceneTexture.texture.id == 0)
         return;
 
-    BeginTextureMode(SceneTexture);
-    if (GlobalContext.ScreenshotView)
+    if (ForceRedraw || GlobalContext.ScreenshotView || NeedsRedraw())
     {
-        ApplicationContext::Screenshot();
-        GlobalContext.ScreenshotView = false;
-    }
+        ForceRedraw = false;
 
-    ClearBackground(BLACK);
-    OnStartFrameCamera(contentArea);
+        BeginTextureMode(SceneTexture);
+        if (GlobalContext.ScreenshotView)
+        {
+            ApplicationContext::Screenshot();
+            GlobalContext.ScreenshotView = false;
+        }
 
-    DrawDefaultScene();
-    OnShow(contentArea);
+        ClearBackground(BLACK);
+        OnStartFrameCamera(contentArea);
 
-    OnEndFrameCamera();
-    EndTextureMode();
+        DrawDefaultScene();
+        OnShow(contentArea);
+
+        OnEndFrameCamera();
+        EndTextureMode();
+    }
 
     DrawTexturePro(SceneTexture.texture,
         Rectangle{ 0, 0, (float)SceneTexture.texture.width, (float)-SceneTexture.texture.height },
@@ -169,6 +175,7 @@ void ThreeDView::ResizeContentArea(const Rectangle& contentArea)
     BeginTextureMode(SceneTexture);
     ClearBackground(BLACK);
     EndTextureMode();
+    ForceRedraw = true;
 }
 
 void ThreeDView::ShowInspectorContents(const InspectorWindow& window)
@@ -224,6 +231,8 @@ void ThreeDView::DrawGizmo(float scale)
 
 void ThreeDView::SetupSkybox()
 {
+    PROFILE_SCOPE("ThreeDView::SetupSkybox");
+
     if (!ShowSkybox)
         return;
 
@@ -454,6 +463,8 @@ void SetModelMaterialTexture(Model* model, int materialIndex, int maptype, Textu
 
 RLAPI Shader LoadShaderSet(const char* resourcePath, const char* name)
 {
+    PROFILE_SCOPE("LoadShaderSet");
+
     static char vsTemp[512];
     static char fsTemp[512];
 
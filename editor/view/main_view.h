@@ -58,6 +58,9 @@ public:
 
     virtual void ShowInspectorContents(const InspectorWindow& window) {}
 
+    // views with something animating return true to keep the editor from going idle
+    inline virtual bool WantsContinuousUpdate() { return false; }
+
     // menu functions
     inline virtual void OnFileMenu() {}
     inline virtual void OnMenuBar() {}
@@ -112,10 +115,16 @@ protected:
     bool ShowGround = true;
     bool ShowOrigin = true;
 
+    // set when the SceneTexture contents are stale and must be drawn regardless of NeedsRedraw
+    bool ForceRedraw = true;
+
     virtual void OnSetup() {}
     virtual void OnShutdown() {}
     virtual void OnShowInspector(const InspectorWindow& window) {}
     inline virtual void OnUpdate() {};
+
+    // views that can tell nothing changed since the last frame return false to reuse the last SceneTexture
+    inline virtual bool NeedsRedraw() { return true; }
 public:
     void Setup() override;
     void Shutdown() override;
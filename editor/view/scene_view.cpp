@@ -43,19 +43,28 @@
 
 #include "inspectors/inspector_window.h"
 
+#include "frame_stats.h"
+#include "job_system.h"
+#include "platform_services.h"
+#include "profiler.h"
+
 #include "systems/free_flight_controller.h"
 #include "systems/lighting_system.h"
 #include "systems/render_system.h"
 
 #include "raylib.h"
+#include "rlgl.h"
 #include "IconsForkAwesome.h"
 
+#include <chrono>
+#include <stdio.h>
+
 void SceneView::OnSetup()
 {
     Outliner = std::make_shared<SceneOutliner>(Scene.Entities);
     GlobalContext.UI.AddWindow(Outliner);
 
-    GlobalContext.UI.AddWindow(std::make_shared<InspectorWindow>(Scene, Outliner->Selection));
+    GlobalContext.UI.AddWindow(std::make_shared<InspectorWindow>(Scene, Outliner->Selection, Editor.Journal));
 
     ShowGround = false;
 
@@ -66,14 +75,14 @@ void SceneView::OnSetup()
 
     Scene.Entities.DoForEachEntity<EditorCameraComponent>([this](EditorCameraComponent* camera) {EditorCamera = camera->EntityId; });
 
-    Scene.Systems.GetSystem<FreeFlightController>()->AllowMovement = []() { return IsMouseButtonDown(1); };
+    Scene.Systems.GetSystem<FreeFlightController>()->AllowMovement = []() { return InputSource::Get().IsMouseButtonDown(1); };
 
     Scene.Run = false;
 }
 
 void SceneView::OnStartFrameCamera(const Rectangle& contentArea)
 {
-    Scene.Systems.GetSystem<RenderSystem>()->Begin(EditorCamera);
+    Scene.Systems.GetSystem<RenderSystem>()->Begin(Snapshots.GetPublished());
 }
 
 void SceneView::OnEndFrameCamera()
@@ -83,41 +92,173 @@ void SceneView::OnEndFrameCamera()
 
 void SceneView::OnUpdate()
 {
-    if (Scene.Run)
+    Scene.Systems.GetSystem<FreeFlightController>()->Update(Scene.Entities.GetComponent<TransformComponent>(EditorCamera));
+
+    // camera moves, simulation and edits all bump the scene generation, if nothing did the last frame is still good
+    RedrawState state = GetRedrawState();
+    SceneChanged = !(state == LastDrawnState);
+    if (SceneChanged)
+    {
+        auto extractStart = std::chrono::high_resolution_clock::now();
+
+        RenderSnapshot& snapshot = Snapshots.BeginWrite();
+        Scene.Systems.GetSystem<RenderSystem>()->Extract(EditorCamera, snapshot, (int)LastContentArea.width, (int)LastContentArea.height);
+        Scene.Systems.GetSystem<LightingSystem>()->ExtractLights(snapshot.Lights);
+        Scene.Systems.GetSystem<LightingSystem>()->AssignLights(snapshot);
+
+        // the gizmos go in the snapshot too, so they match the frame they are drawn with
+        for (EntityId_t id : Outliner->Selection.GetSelection())
+        {
+            TransformComponent* transform = Scene.Entities.GetComponent<TransformComponent>(id);
+            if (transform != nullptr)
+                snapshot.Gizmos.push_back(transform->GetGLWorldMatrix());
+        }
+
+        Snapshots.Publish();
+        Timings.ExtractMs = Profiler::MillisecondsSince(extractStart);
+
+        // extraction can add missing components, so take the state after it is done
+        LastDrawnState = GetRedrawState();
+    }
+    else
     {
-        Scene.Entities.Update();
+        SkippedFrames++;
+        Timings.ExtractMs = 0;
     }
 
-    Scene.Systems.GetSystem<LightingSystem>()->UpdateLights();
-    Scene.Systems.GetSystem<FreeFlightController>()->Update(Scene.Entities.GetComponent<TransformComponent>(EditorCamera));
-    Scene.Systems.GetSystem<LightingSystem>()->Update(EditorCamera);
+    if (!Scene.Run)
+        return;
+
+    // anything drawn from the live components has to wait until drawing is done
+    if (OverlapSimulation && Snapshots.GetPublished().LiveDrawables.empty())
+        SimulationJob = JobSystem::Submit([this]() { RunSimulation(); });
+    else
+        SimulationPending = true;
+}
+
+SceneView::RedrawState SceneView::GetRedrawState()
+{
+    RedrawState state;
+    state.SceneGeneration = Scene.Entities.GetChangeGeneration();
+    state.SelectionGeneration = Outliner->Selection.GetGeneration();
+    state.Width = (int)LastContentArea.width;
+    state.Height = (int)LastContentArea.height;
+    state.OcclusionCulling = Scene.Systems.GetSystem<RenderSystem>()->UseOcclusionCulling;
+    state.ClusteredLighting = Scene.Systems.GetSystem<LightingSystem>()->UseClusteredLighting;
+    return state;
+}
+
+void SceneView::RunSimulation()
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    Scene.Entities.Update();
+    Timings.SimulationMs = Profiler::MillisecondsSince(start);
+}
+
+void SceneView::FinishSimulation()
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    if (SimulationJob.valid())
+        SimulationJob.get();
+
+    Timings.WaitMs = Profiler::MillisecondsSince(start);
+
+    if (SimulationPending)
+    {
+        SimulationPending = false;
+        RunSimulation();
+    }
+}
+
+void SceneView::Show(const Rectangle& contentArea)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    ThreeDView::Show(contentArea);
+    Timings.DrawMs = Profiler::MillisecondsSince(start);
+
+    // the UI edits entities, so the update has to be done before it runs
+    FinishSimulation();
+
+    if (Loader.IsLoading() && !Loader.Update(LoadBudgetMs))
+    {
+        // the set matches the file apart from the editor's own entities, so the saver can start from it
+        if (Loader.GetLastResult() && !Loader.WasEdited())
+            Saver.Attach(Scene.Entities);
+    }
+
+    if (TogglePlayRequested)
+    {
+        TogglePlayRequested = false;
+
+        // a snapshot taken part way through a load would throw away what loads while playing
+        if (Scene.Run)
+            Scene.Stop();
+        else if (!Loader.IsLoading())
+            Scene.Play();
+    }
+
+    if (Autosave && !Scene.Run && !Loader.IsLoading())
+        UpdateAutosave();
+
+    FrameStats::AddPhaseTime(FrameStats::FramePhase::Systems, Timings.ExtractMs + (Scene.Run ? Timings.SimulationMs : 0));
+}
+
+void SceneView::UpdateAutosave()
+{
+    if (Saver.IsSaving() || GetTime() - LastAutosaveTime < AutosaveInterval)
+        return;
+
+    LastAutosaveTime = GetTime();
+    if (!Saver.IsUpToDate(Scene.Entities))
+        Saver.BeginSave(Scene.Entities);
+}
+
+void SceneView::OpenScene()
+{
+    FinishSimulation();
+    Scene.Stop();
+    Saver.FinishSave();
+    Loader.Cancel();
+
+    // the editor camera and anything else the editor owns stays, the ids in the file that match them are skipped
+    Outliner->Selection.Clear();
+    Editor.Journal.Clear();
+    Scene.Entities.RemoveEntities([this](EntityId_t id) { return !Scene.Entities.HasComponent<EditorHiddenComponent>(id); });
+
+    Loader.Begin(Scene.Entities, Saver.GetFileName().c_str());
 }
 
 void SceneView::OnShutdown()
 {
+    FinishSimulation();
+    Loader.Cancel();
+    Saver.FinishSave();
     GlobalContext.UI.RemoveWindow(Outliner);
 }
 
 void SceneView::OnShow(const Rectangle& contentArea)
 {
-    Scene.Systems.GetSystem<RenderSystem>()->Draw();
+    const RenderSnapshot& snapshot = Snapshots.GetPublished();
+
+    LightingSystem* lighting = Scene.Systems.GetSystem<LightingSystem>();
+    lighting->SetView(snapshot.ViewCam, (int)contentArea.width, (int)contentArea.height);
+    lighting->UploadLights(snapshot.Lights);
+
+    Scene.Systems.GetSystem<RenderSystem>()->Draw(snapshot, [lighting, &snapshot](const RenderLightSet& set) { lighting->UploadLightSet(snapshot.Lights, set); });
 
     rlDisableDepthMask();
     rlDisableDepthTest();
 
     // selection gizmoes
-    for (EntityId_t id : Outliner->Selection.GetSelection())
+    rlSetLineWidth(3);
+    for (const Matrix& glMatrix : snapshot.Gizmos)
     {
-        TransformComponent* transform = Scene.Entities.GetComponent<TransformComponent>(id);
-        if (transform != nullptr)
-        {
-            transform->PushMatrix();
+        rlPushMatrix();
+        rlMultMatrixf((float*)(&glMatrix.m0));
 
-            rlSetLineWidth(3);
-            DrawGizmo(0.25f);
+        DrawGizmo(0.25f);
 
-            transform->PopMatrix();
-        }
+        rlPopMatrix();
     }
     rlDrawRenderBatchActive();
     rlSetLineWidth(1);
@@ -126,6 +267,65 @@ void SceneView::OnShow(const Rectangle& contentArea)
     rlEnableDepthMask();
 }
 
+void SceneView::OnMenuBar()
+{
+    // nothing done while playing is kept, so there is nothing to undo
+    bool canEdit = !Scene.Run;
+
+    if (canEdit && !ImGui::GetIO().WantTextInput && (ImGui::IsKeyDown(KEY_LEFT_CONTROL) || ImGui::IsKeyDown(KEY_RIGHT_CONTROL)))
+    {
+        if (ImGui::IsKeyPressed(KEY_Z))
+            Editor.Journal.Undo();
+        else if (ImGui::IsKeyPressed(KEY_Y))
+            Editor.Journal.Redo();
+    }
+
+    if (ImGui::BeginMenu("File"))
+    {
+        if (ImGui::MenuItem(ICON_FA_FOLDER_OPEN " Open Scene", nullptr, nullptr, FileExists(Saver.GetFileName().c_str())))
+            OpenScene();
+
+        // the saver copies the scene out before returning, so saving doesn't wait on the last save to finish writing
+        if (ImGui::MenuItem(ICON_FA_FLOPPY_O " Save Scene", nullptr, nullptr, canEdit && !Saver.IsSaving() && !Loader.IsLoading()))
+        {
+            Saver.BeginSave(Scene.Entities);
+            LastAutosaveTime = GetTime();
+        }
+
+        ImGui::MenuItem("Autosave", nullptr, &Autosave);
+
+        ImGui::Separator();
+        const SceneFile::IncrementalSaver::Stats& stats = Saver.GetStats();
+        if (!Saver.GetLastResult())
+            ImGui::TextDisabled("Saving %s failed", Saver.GetFileName().c_str());
+        else if (stats.FileBytes > 0)
+            ImGui::TextDisabled("%s %.1fKB, last save wrote %zu chunks (%.1fKB)%s\nCopy %.2fms, write %.2fms",
+                Saver.GetFileName().c_str(), stats.FileBytes / 1024.0, stats.ChunksWritten, stats.BytesWritten / 1024.0,
+                stats.Compacted ? ", rewritten" : "", stats.CaptureMs, stats.WriteMs);
+        else
+            ImGui::TextDisabled("%s not saved yet", Saver.GetFileName().c_str());
+
+        ImGui::EndMenu();
+    }
+
+    if (ImGui::BeginMenu("Edit"))
+    {
+        if (ImGui::MenuItem(ICON_FA_UNDO " Undo", "Ctrl+Z", nullptr, canEdit && Editor.Journal.CanUndo()))
+            Editor.Journal.Undo();
+
+        if (ImGui::MenuItem(ICON_FA_REPEAT " Redo", "Ctrl+Y", nullptr, canEdit && Editor.Journal.CanRedo()))
+            Editor.Journal.Redo();
+
+        ImGui::Separator();
+        ImGui::TextDisabled("History %zu steps, %.1fKB", Editor.Journal.GetEntryCount(), Editor.Journal.GetBytesUsed() / 1024.0);
+
+        if (ImGui::MenuItem("Clear History", nullptr, nullptr, Editor.Journal.GetEntryCount() > 0))
+            Editor.Journal.Clear();
+
+        ImGui::EndMenu();
+    }
+}
+
 void SceneView::OnShowOverlay(const Rectangle& contentArea)
 {
     ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, ImVec2(2, 2));
@@ -137,17 +337,67 @@ void SceneView::OnShowOverlay(const Rectangle& contentArea)
     {
         ImGui::SetCursorPosY(style.FramePadding.y);
 
+        // the simulation may still be running on a worker, so the switch happens once it is done
+        if (ImGui::Button(Scene.Run ? ICON_FA_STOP " Stop" : ICON_FA_PLAY " Play"))
+            TogglePlayRequested = true;
+
+        if (ImGui::IsItemHovered() && Scene.PlaySnapshot.IsValid())
+        {
+            const WorldSnapshot::Stats& stats = Scene.PlaySnapshot.GetStats();
+            ImGui::SetTooltip("Snapshot of %zu entities, %zu components\nCapture %.2fms, restore %.2fms%s\nMemory %.2fMB, peak %.2fMB",
+                stats.Entities, stats.Components, stats.CaptureMs, stats.RestoreMs, stats.RebuiltOnRestore ? " (rebuilt)" : "",
+                stats.MemoryBytes / (1024.0 * 1024.0), stats.PeakMemoryBytes / (1024.0 * 1024.0));
+        }
+
+        if (Loader.IsLoading())
+        {
+            const SceneFile::StreamingLoader::Progress& progress = Loader.GetProgress();
+            char label[64];
+            snprintf(label, sizeof(label), "%zu / %zu chunks", progress.ChunksLoaded, progress.TotalChunks);
+
+            ImGui::SameLine();
+            ImGui::ProgressBar(progress.GetFraction(), ImVec2(200, 0), label);
+            if (ImGui::IsItemHovered())
+                ImGui::SetTooltip("Loading %s\n%zu entities, %zu components\n%.2fms last frame, %.1fms so far",
+                    Loader.GetFileName().c_str(), progress.Entities, progress.Components, progress.LastUpdateMs, progress.TotalMs);
+
+            ImGui::SameLine();
+            if (ImGui::Button(ICON_FA_TIMES " Cancel"))
+                Loader.Cancel();
+        }
+
+        ImGui::SameLine();
+        ImGui::Checkbox("Threaded", &OverlapSimulation);
+        ImGui::SameLine();
+        ImGui::TextUnformatted(SceneChanged ? ICON_FA_REFRESH : ICON_FA_PAUSE);
+        if (ImGui::IsItemHovered())
+            ImGui::SetTooltip("%s, %zu unchanged frames reused", SceneChanged ? "Redrawn" : "Reused last frame", SkippedFrames);
         if (Scene.Run)
         {
-            if (ImGui::Button(ICON_FA_STOP " Stop"))
-                Scene.Run = false;
+            ImGui::SameLine();
+            ImGui::Text("Extract:%.2fms Sim:%.2fms Draw:%.2fms Wait:%.2fms", Timings.ExtractMs, Timings.SimulationMs, Timings.DrawMs, Timings.WaitMs);
         }
-        else
+
+        RenderSystem* renderer = Scene.Systems.GetSystem<RenderSystem>();
+        ImGui::SameLine();
+        ImGui::Checkbox("Occlusion", &renderer->UseOcclusionCulling);
+        if (renderer->UseOcclusionCulling)
         {
-            if (ImGui::Button(ICON_FA_PLAY " Play"))
-                Scene.Run = true;
+            const OcclusionCuller::Stats& stats = renderer->GetOcclusionCuller().GetStats();
+            ImGui::SameLine();
+            ImGui::Text("Tris:%zu Tested:%zu Frustum:%zu Occluded:%zu", stats.OccluderTriangles, stats.Tested, stats.FrustumCulled, stats.OcclusionCulled);
         }
-        
+
+        LightingSystem* lighting = Scene.Systems.GetSystem<LightingSystem>();
+        ImGui::SameLine();
+        ImGui::Checkbox("Clustered", &lighting->UseClusteredLighting);
+        if (lighting->UseClusteredLighting)
+        {
+            const LightClusterer::Stats& stats = lighting->GetClusterer().GetStats();
+            ImGui::SameLine();
+            ImGui::Text("Lights:%zu Clusters:%zu Assigned:%zu Dropped:%zu", stats.Lights, stats.UsedClusters, stats.Assignments, stats.Dropped);
+        }
+
         ImGui::EndChild();
     }
 
@@ -34,8 +34,12 @@
 #include "outliner/scene_outliner.h"
 #include "scene.h"
 #include "scene_editor.h"
+#include "scene_file.h"
+#include "systems/render_snapshot.h"
 
+#include <future>
 #include <memory>
+#include <vector>
 
 class SceneView : public ThreeDView
 {
@@ -53,6 +57,22 @@ public:
     void OnShutdown() override;
     void OnShow(const Rectangle& contentArea) override;
     void OnShowOverlay(const Rectangle& contentArea) override;
+    void OnMenuBar() override;
+
+    void Show(const Rectangle& contentArea) override;
+
+    inline bool WantsContinuousUpdate() override { return Scene.Run || SceneChanged || Loader.IsLoading(); }
+
+    // CPU times for the last frame, in milliseconds
+    struct FrameTimings
+    {
+        double ExtractMs = 0;
+        double SimulationMs = 0;
+        double DrawMs = 0;
+        double WaitMs = 0;
+    };
+
+    inline const FrameTimings& GetFrameTimings() const { return Timings; }
 
 protected:
     uint64_t EditorCamera = 0;
@@ -62,7 +82,63 @@ protected:
 
     std::shared_ptr<SceneOutliner> Outliner;
 
+    // the scene is copied out each frame and drawn from the copy
+    RenderSnapshotBuffer Snapshots;
+
+    // update the entities on a worker thread while the copy is drawn
+    bool OverlapSimulation = true;
+    bool SimulationPending = false;
+    std::future<void> SimulationJob;
+
+    // play and stop are applied after the simulation finishes
+    bool TogglePlayRequested = false;
+
+    // the scene is saved in the background every so often while editing, only what changed is written
+    SceneFile::IncrementalSaver Saver { "scene.rlsc" };
+    bool Autosave = true;
+    double AutosaveInterval = 30;
+    double LastAutosaveTime = 0;
+
+    // scenes are opened a piece at a time, with this much of each frame spent putting entities in
+    SceneFile::StreamingLoader Loader;
+    double LoadBudgetMs = 4;
+
+    FrameTimings Timings;
+
+    // what the last drawn frame was built from, the view is only redrawn when this changes
+    struct RedrawState
+    {
+        uint64_t SceneGeneration = 0;
+        uint64_t SelectionGeneration = 0;
+        int Width = 0;
+        int Height = 0;
+        bool OcclusionCulling = false;
+        bool ClusteredLighting = false;
+
+        inline bool operator == (const RedrawState& other) const
+        {
+            return SceneGeneration == other.SceneGeneration
+                && SelectionGeneration == other.SelectionGeneration
+                && Width == other.Width
+                && Height == other.Height
+                && OcclusionCulling == other.OcclusionCulling
+                && ClusteredLighting == other.ClusteredLighting;
+        }
+    };
+
+    RedrawState LastDrawnState;
+    bool SceneChanged = true;
+    size_t SkippedFrames = 0;
+
 protected:
+    void RunSimulation();
+    void FinishSimulation();
+    void UpdateAutosave();
+    void OpenScene();
+
+    RedrawState GetRedrawState();
+    inline bool NeedsRedraw() override { return SceneChanged; }
+
     void OnStartFrameCamera(const Rectangle& contentArea) override;
     void OnEndFrameCamera() override;
 };
\ No newline at end of file
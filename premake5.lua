@@ -1,13 +1,19 @@
+newoption
+{
+	trigger = "profiler",
+	description = "Build the CPU profiler instrumentation into release configurations"
+}
+
 workspace "rlECS"
 	configurations { "Debug","Debug.DLL", "Release", "Release.DLL" }
 	platforms { "x64"}
 
 	filter "configurations:Debug"
-		defines { "DEBUG" }
+		defines { "DEBUG", "RLECS_PROFILER" }
 		symbols "On"
 		
 	filter "configurations:Debug.DLL"
-		defines { "DEBUG" }
+		defines { "DEBUG", "RLECS_PROFILER" }
 		symbols "On"
 
 	filter "configurations:Release"
@@ -17,6 +23,9 @@ workspace "rlECS"
 	filter "configurations:Release.DLL"
 		defines { "NDEBUG" }
 		optimize "On"	
+
+	filter "options:profiler"
+		defines { "RLECS_PROFILER" }
 		
 	filter { "platforms:x64" }
 		architecture "x86_64"
@@ -28,7 +37,8 @@ workspace "rlECS"
 project "raylib"
 		filter "configurations:Debug.DLL OR Release.DLL"
 			kind "SharedLib"
-			defines {"BUILD_LIBTYPE_SHARED"}
+			-- the editor calls into GLFW directly, so the DLL has to export it along with raylib
+			defines {"BUILD_LIBTYPE_SHARED", "_GLFW_BUILD_DLL"}
 			
 		filter "configurations:Debug OR Release"
 			kind "StaticLib"
@@ -79,6 +89,33 @@ project "rlECS"
 		"rlECS/systems/*.h",
 	}
 
+project "rlECS_headless"
+	kind "StaticLib"
+	location "build/rlECS_headless"
+	language "C++"
+	targetdir "bin/%{cfg.buildcfg}"
+	cppdialect "C++17"
+	
+	-- same sources with no window, GPU or input, only raylib's headers are used
+	defines {"RLECS_HEADLESS", "RAYMATH_HEADER_ONLY"}
+	
+	includedirs {"raylib/src","rlECS"}
+	vpaths 
+	{
+		["Header Files"] = { "*.h"},
+		["Source Files"] = {"*.c", "*.cpp"},
+	}
+	files 
+	{
+		"rlECS/**.c",
+		"rlECS/**.cpp",
+		"rlECS/**.h",
+		"rlECS/components/*.cpp",
+		"rlECS/components/*.h",
+		"rlECS/systems/*.cpp",
+		"rlECS/systems/*.h",
+	}
+
 project "gameCommon"
 	kind "StaticLib"
 	location "build/gameCommon"
@@ -218,6 +255,7 @@ project "editor"
 	{
 		"editor",
 		"raylib/src", 
+		"raylib/src/external/glfw/include",
 		"raylibExtras/rlExtrasCPP",
 		"raylibExtras/rlImGui",
 		"raylibExtras/imgui", 
@@ -228,6 +266,9 @@ project "editor"
     
 	defines{"PLATFORM_DESKTOP", "GRAPHICS_API_OPENGL_33"}
 	
+	filter "configurations:Debug.DLL OR Release.DLL"
+		defines{"GLFW_DLL"}
+	
 	filter "action:vs*"
 		defines{"_WINSOCK_DEPRECATED_NO_WARNINGS", "_CRT_SECURE_NO_WARNINGS", "_WIN32"}
 		dependson {"raylib"}
@@ -237,4 +278,44 @@ project "editor"
 		
 	filter "action:gmake*"
 		links {"pthread", "GL", "m", "dl", "rt", "X11"}
-	
\ No newline at end of file
+	
+project "rlECS_bench"
+	kind "ConsoleApp"
+	location "build/rlECS_bench"
+	language "C++"
+	targetdir "bin/%{cfg.buildcfg}"
+	cppdialect "C++17"
+	
+	vpaths 
+	{
+		["Header Files"] = { "*.h"},
+		["Source Files"] = {"*.c", "*.cpp"},
+	}
+	
+	files 
+	{
+		"bench/**.cpp",
+		"bench/**.h",
+	}
+	
+	links 
+	{
+		"rlECS_headless",
+	}
+	
+	includedirs 
+	{
+		"bench",
+		"raylib/src", 
+		"rlECS",
+	}
+    
+	defines{"RLECS_HEADLESS", "RAYMATH_HEADER_ONLY"}
+	
+	filter "action:vs*"
+		defines{"_WINSOCK_DEPRECATED_NO_WARNINGS", "_CRT_SECURE_NO_WARNINGS", "_WIN32"}
+		links {"kernel32"}
+		libdirs {"bin/%{cfg.buildcfg}"}
+		
+	filter "action:gmake*"
+		links {"pthread", "m"}
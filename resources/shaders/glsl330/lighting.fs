@@ -25,16 +25,9 @@ struct MaterialProperty {
     sampler2D sampler;
 };
 
-struct Light {
-    int enabled;
-    int type;
-    vec3 position;
-    vec3 target;
-    vec4 color;
-};
-
 // Input lighting values
-uniform Light lights[MAX_LIGHTS];
+// three vec4s per light: position and type, target and enabled, color
+uniform vec4 lights[MAX_LIGHTS*3];
 uniform vec4 ambient;
 uniform vec3 viewPos;
 
@@ -51,22 +44,27 @@ void main()
 
     for (int i = 0; i < MAX_LIGHTS; i++)
     {
-        if (lights[i].enabled == 1)
+        vec4 lightPosition = lights[i*3];
+        vec4 lightTarget = lights[i*3 + 1];
+        vec4 lightColor = lights[i*3 + 2];
+
+        if (lightTarget.w > 0.5)
         {
             vec3 light = vec3(0.0);
+            int type = int(lightPosition.w + 0.5);
             
-            if (lights[i].type == LIGHT_DIRECTIONAL) 
+            if (type == LIGHT_DIRECTIONAL) 
             {
-                light = -normalize(lights[i].target - lights[i].position);
+                light = -normalize(lightTarget.xyz - lightPosition.xyz);
             }
             
-            if (lights[i].type == LIGHT_POINT) 
+            if (type == LIGHT_POINT) 
             {
-                light = normalize(lights[i].position - fragPosition);
+                light = normalize(lightPosition.xyz - fragPosition);
             }
             
             float NdotL = max(dot(normal, light), 0.0);
-            lightDot += lights[i].color.rgb*NdotL;
+            lightDot += lightColor.rgb*NdotL;
 
             float specCo = 0.0;
             if (NdotL > 0.0) specCo = pow(max(0.0, dot(viewD, reflect(-(light), normal))), 16.0); // 16 refers to shine
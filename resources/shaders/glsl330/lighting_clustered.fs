@@ -0,0 +1,102 @@
+#version 330
+
+// Input vertex attributes (from vertex shader)
+in vec3 fragPosition;
+in vec2 fragTexCoord;
+in vec4 fragColor;
+in vec3 fragNormal;
+
+// Input uniform values
+uniform sampler2D texture0;
+uniform vec4 colDiffuse;
+
+// Output fragment color
+out vec4 finalColor;
+
+// Clustered lights, binned on the CPU by LightClusterer
+
+// two texels per light, position and range then color
+// directional lights come first, their first texel is the direction to the light
+uniform sampler2D lightData;
+
+// offset and count into lightIndexes for every cluster, one row per depth slice
+uniform sampler2D clusterData;
+
+// indexes of point lights, counted after the directional lights
+uniform sampler2D lightIndexes;
+
+uniform int directionalCount;
+uniform ivec3 clusterCounts;        // tiles x, tiles y, depth slices
+uniform vec4 clusterParams;         // viewport width, viewport height, slice scale, slice bias
+uniform mat4 viewMatrix;
+
+// Input lighting values
+uniform vec4 ambient;
+uniform vec3 viewPos;
+
+vec4 FetchTexel(sampler2D data, int index)
+{
+    int width = textureSize(data, 0).x;
+    return texelFetch(data, ivec2(index % width, index / width), 0);
+}
+
+void AddLight(vec3 light, vec3 color, vec3 normal, vec3 viewD, inout vec3 lightDot, inout vec3 specular)
+{
+    float NdotL = max(dot(normal, light), 0.0);
+    lightDot += color*NdotL;
+
+    float specCo = 0.0;
+    if (NdotL > 0.0) specCo = pow(max(0.0, dot(viewD, reflect(-(light), normal))), 16.0); // 16 refers to shine
+    specular += color*specCo;
+}
+
+void main()
+{
+    // Texel color fetching from texture sampler
+    vec4 texelColor = texture(texture0, fragTexCoord);
+    vec3 lightDot = vec3(0.0);
+    vec3 normal = normalize(fragNormal);
+    vec3 viewD = normalize(viewPos - fragPosition);
+    vec3 specular = vec3(0.0);
+
+    for (int i = 0; i < directionalCount; i++)
+    {
+        vec3 light = FetchTexel(lightData, i*2).xyz;
+        vec3 color = FetchTexel(lightData, i*2 + 1).rgb;
+        AddLight(light, color, normal, viewD, lightDot, specular);
+    }
+
+    // find the cluster for this pixel from the screen tile and view depth
+    float depth = max(-(viewMatrix*vec4(fragPosition, 1.0)).z, 0.0001);
+    ivec2 tile = ivec2(gl_FragCoord.xy/clusterParams.xy*vec2(clusterCounts.xy));
+    tile = clamp(tile, ivec2(0), clusterCounts.xy - 1);
+    int slice = clamp(int(floor(log(depth)*clusterParams.z + clusterParams.w)), 0, clusterCounts.z - 1);
+
+    vec2 range = texelFetch(clusterData, ivec2(tile.x + tile.y*clusterCounts.x, slice), 0).xy;
+    int offset = int(range.x);
+    int count = int(range.y);
+
+    for (int i = 0; i < count; i++)
+    {
+        int lightIndex = directionalCount + int(FetchTexel(lightIndexes, offset + i).r);
+
+        vec4 positionRange = FetchTexel(lightData, lightIndex*2);
+        vec3 color = FetchTexel(lightData, lightIndex*2 + 1).rgb;
+
+        vec3 toLight = positionRange.xyz - fragPosition;
+        float distance = length(toLight);
+        if (distance >= positionRange.w) continue;
+
+        // smooth falloff to zero at the light range, so lights can be culled to their range
+        float falloff = clamp(1.0 - pow(distance/positionRange.w, 4.0), 0.0, 1.0);
+        falloff = falloff*falloff/(distance*distance + 1.0);
+
+        AddLight(toLight/max(distance, 0.0001), color*falloff, normal, viewD, lightDot, specular);
+    }
+
+    finalColor = (texelColor*((colDiffuse + vec4(specular, 1.0))*vec4(lightDot, 1.0)));
+    finalColor += texelColor*(ambient/10.0)*colDiffuse;
+
+    // Gamma correction
+    finalColor = pow(finalColor, vec4(1.0/2.2));
+}
@@ -0,0 +1,177 @@
+/**********************************************************************************************
+*
+*   raylib_ECS_sample * a sample Entity Component System using raylib
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+#include "component_reflection.h"
+#include "entity_manager.h"
+
+#include <string.h>
+
+namespace Reflection
+{
+    void SaveFields(const FieldTable& table, const void* object, void* data)
+    {
+        if (table.Count == 0)
+            return;
+
+        const uint8_t* source = static_cast<const uint8_t*>(object);
+        if (table.Contiguous)
+        {
+            memcpy(data, source + table.Fields[0].Offset, table.DataSize);
+            return;
+        }
+
+        uint8_t* dest = static_cast<uint8_t*>(data);
+        for (size_t i = 0; i < table.Count; i++)
+        {
+            memcpy(dest, source + table.Fields[i].Offset, table.Fields[i].Size);
+            dest += table.Fields[i].Size;
+        }
+    }
+
+    void LoadFields(const FieldTable& table, void* object, const void* data)
+    {
+        if (table.Count == 0)
+            return;
+
+        uint8_t* dest = static_cast<uint8_t*>(object);
+        if (table.Contiguous)
+        {
+            memcpy(dest + table.Fields[0].Offset, data, table.DataSize);
+        }
+        else
+        {
+            const uint8_t* source = static_cast<const uint8_t*>(data);
+            for (size_t i = 0; i < table.Count; i++)
+            {
+                memcpy(dest + table.Fields[i].Offset, source, table.Fields[i].Size);
+                source += table.Fields[i].Size;
+            }
+        }
+
+        // a file can hold any byte, only 0 and 1 are valid bools
+        if (table.HasBools)
+        {
+            for (size_t i = 0; i < table.Count; i++)
+            {
+                if (table.Fields[i].Type == FieldType::Bool)
+                {
+                    uint8_t& value = dest[table.Fields[i].Offset];
+                    value = value != 0 ? 1 : 0;
+                }
+            }
+        }
+    }
+
+    void CopyFields(const FieldTable& table, void* dest, const void* source)
+    {
+        if (table.Count == 0)
+            return;
+
+        if (table.Contiguous)
+        {
+            size_t offset = table.Fields[0].Offset;
+            memcpy(static_cast<uint8_t*>(dest) + offset, static_cast<const uint8_t*>(source) + offset, table.DataSize);
+            return;
+        }
+
+        for (size_t i = 0; i < table.Count; i++)
+        {
+            size_t offset = table.Fields[i].Offset;
+            memcpy(static_cast<uint8_t*>(dest) + offset, static_cast<const uint8_t*>(source) + offset, table.Fields[i].Size);
+        }
+    }
+
+    uint64_t DiffFields(const FieldTable& table, const void* a, const void* b)
+    {
+        const uint8_t* left = static_cast<const uint8_t*>(a);
+        const uint8_t* right = static_cast<const uint8_t*>(b);
+
+        // most compares find nothing changed, so check the whole run before looking at single fields
+        if (table.Contiguous && table.Count > 0)
+        {
+            size_t offset = table.Fields[0].Offset;
+            if (memcmp(left + offset, right + offset, table.DataSize) == 0)
+                return 0;
+        }
+
+        uint64_t mask = 0;
+        for (size_t i = 0; i < table.Count; i++)
+        {
+            const FieldInfo& field = table.Fields[i];
+            if (memcmp(left + field.Offset, right + field.Offset, field.Size) != 0)
+                mask |= uint64_t(1) << (i < 63 ? i : 63);
+        }
+        return mask;
+    }
+
+    size_t DiffFields(const FieldTable& table, const void* const* a, const void* const* b, size_t count, uint64_t* masks)
+    {
+        size_t changed = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            masks[i] = DiffFields(table, a[i], b[i]);
+            if (masks[i] != 0)
+                changed++;
+        }
+        return changed;
+    }
+
+    uint64_t DiffRecord(const FieldTable& table, const void* record, const void* object)
+    {
+        const uint8_t* value = static_cast<const uint8_t*>(record);
+        const uint8_t* fields = static_cast<const uint8_t*>(object);
+
+        // the record is packed, so walk it alongside the fields
+        uint64_t mask = 0;
+        for (size_t i = 0; i < table.Count; i++)
+        {
+            const FieldInfo& field = table.Fields[i];
+            if (memcmp(value, fields + field.Offset, field.Size) != 0)
+                mask |= uint64_t(1) << (i < 63 ? i : 63);
+            value += field.Size;
+        }
+        return mask;
+    }
+
+    Component* FindComponent(EntitySet& entities, size_t componentId, size_t typeId, uint64_t entityId, size_t index)
+    {
+        if (entityId == InvalidEntityId)
+            return nullptr;
+
+        for (Component* component : entities.GetComponents(componentId, entityId))
+        {
+            if (component->TypeId() != typeId)
+                continue;
+
+            if (index == 0)
+                return component;
+            index--;
+        }
+        return nullptr;
+    }
+}
@@ -0,0 +1,211 @@
+/**********************************************************************************************
+*
+*   raylib_ECS_sample * a sample Entity Component System using raylib
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+#pragma once
+
+#include "raylib.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+
+class Component;
+class EntitySet;
+
+// field level reflection for components, each reflected component lists its plain data members in a constexpr table
+// the table drives scene saving, copying and diffing without a virtual call per field
+
+enum class FieldType : uint8_t
+{
+    Unknown = 0,
+    Bool,
+    Int32,
+    UInt64,
+    Float,
+    Vector2,
+    Vector3,
+    Vector4,
+    Color,
+    Enum,
+};
+
+enum FieldFlags : uint32_t
+{
+    FieldFlagNone = 0,
+    FieldFlagHidden = 1,        // not shown by generic inspectors
+    FieldFlagReadOnly = 2,      // shown but not edited
+    FieldFlagDegrees = 4,       // an angle (or angular speed) in degrees
+};
+
+struct FieldInfo
+{
+    const char* Name = nullptr;
+    size_t Offset = 0;          // from the start of the component
+    size_t Size = 0;
+    FieldType Type = FieldType::Unknown;
+    uint32_t Flags = FieldFlagNone;
+};
+
+struct FieldTable
+{
+    const FieldInfo* Fields = nullptr;
+    size_t Count = 0;
+
+    // fields are packed back to back in saved records
+    size_t DataSize = 0;
+
+    // the fields are declared in order with no gaps, so the whole record is one copy
+    bool Contiguous = false;
+    bool HasBools = false;
+};
+
+namespace Reflection
+{
+    template<class T>
+    constexpr FieldType GetFieldType()
+    {
+        if constexpr (std::is_same<T, bool>::value)
+            return FieldType::Bool;
+        else if constexpr (std::is_enum<T>::value)
+            return FieldType::Enum;
+        else if constexpr (std::is_same<T, int32_t>::value)
+            return FieldType::Int32;
+        else if constexpr (std::is_same<T, uint64_t>::value)
+            return FieldType::UInt64;
+        else if constexpr (std::is_same<T, float>::value)
+            return FieldType::Float;
+        else if constexpr (std::is_same<T, ::Vector2>::value)
+            return FieldType::Vector2;
+        else if constexpr (std::is_same<T, ::Vector3>::value)
+            return FieldType::Vector3;
+        else if constexpr (std::is_same<T, ::Vector4>::value)
+            return FieldType::Vector4;
+        else if constexpr (std::is_same<T, ::Color>::value)
+            return FieldType::Color;
+        else
+            return FieldType::Unknown;
+    }
+
+    template<class T>
+    constexpr FieldInfo MakeField(const char* name, size_t offset, uint32_t flags = FieldFlagNone)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "reflected fields must be plain data");
+        static_assert(GetFieldType<T>() != FieldType::Unknown, "no field type for this member");
+        return FieldInfo{ name, offset, sizeof(T), GetFieldType<T>(), flags };
+    }
+
+    template<size_t N>
+    constexpr FieldTable MakeTable(const FieldInfo(&fields)[N])
+    {
+        FieldTable table = { fields, N, 0, true, false };
+        for (size_t i = 0; i < N; i++)
+        {
+            table.DataSize += fields[i].Size;
+            if (i > 0 && fields[i].Offset != fields[i - 1].Offset + fields[i - 1].Size)
+                table.Contiguous = false;
+            if (fields[i].Type == FieldType::Bool)
+                table.HasBools = true;
+        }
+        return table;
+    }
+
+    template<class T>
+    inline T& GetField(void* object, const FieldInfo& field)
+    {
+        return *reinterpret_cast<T*>(static_cast<uint8_t*>(object) + field.Offset);
+    }
+
+    // copy the fields of an object into a packed record and back
+    void SaveFields(const FieldTable& table, const void* object, void* data);
+    void LoadFields(const FieldTable& table, void* object, const void* data);
+
+    // copy every field from one object to another of the same type
+    void CopyFields(const FieldTable& table, void* dest, const void* source);
+
+    /// <summary>
+    /// Compare two objects of the same type, bit N of the result is set when field N differs
+    /// Tables with more than 64 fields report the extra fields in bit 63
+    /// </summary>
+    uint64_t DiffFields(const FieldTable& table, const void* a, const void* b);
+
+    /// <summary>
+    /// Compare count pairs of objects that share a table, writing one mask per pair
+    /// Returns how many pairs had differences
+    /// </summary>
+    size_t DiffFields(const FieldTable& table, const void* const* a, const void* const* b, size_t count, uint64_t* masks);
+
+    /// <summary>
+    /// Compare a packed record from SaveFields with an object, bit N of the result is set when field N differs
+    /// </summary>
+    uint64_t DiffRecord(const FieldTable& table, const void* record, const void* object);
+
+    /// <summary>
+    /// Find a component again by its entity, table and place among the components of the same type on that entity
+    /// Packed records and edit entries keep these instead of pointers, so they stay valid when components are made again
+    /// </summary>
+    /// <returns>The component, nullptr if the entity has no such component</returns>
+    Component* FindComponent(EntitySet& entities, size_t componentId, size_t typeId, uint64_t entityId, size_t index);
+
+    // test a field against a mask from DiffFields
+    inline bool IsFieldInMask(uint64_t mask, size_t field)
+    {
+        return (mask & (uint64_t(1) << (field < 63 ? field : 63))) != 0;
+    }
+}
+
+// offsetof on a class with virtual functions is conditionally supported, every compiler we build with handles it
+#if defined(__GNUC__) || defined(__clang__)
+#define RLECS_FIELDS_BEGIN_WARNINGS _Pragma("GCC diagnostic push") _Pragma("GCC diagnostic ignored \"-Winvalid-offsetof\"")
+#define RLECS_FIELDS_END_WARNINGS _Pragma("GCC diagnostic pop")
+#else
+#define RLECS_FIELDS_BEGIN_WARNINGS
+#define RLECS_FIELDS_END_WARNINGS
+#endif
+
+// list the saved fields of a component inside its class, after DEFINE_COMPONENT
+//     BEGIN_COMPONENT_FIELDS(MyComponent)
+//         COMPONENT_FIELD(Speed)
+//         COMPONENT_FIELD(Heading, FieldFlagDegrees)
+//     END_COMPONENT_FIELDS()
+#define BEGIN_COMPONENT_FIELDS(TYPE) \
+    using ReflectedType = TYPE; \
+    static const FieldTable& GetFields() \
+    { \
+        RLECS_FIELDS_BEGIN_WARNINGS \
+        static constexpr FieldInfo fields[] = {
+
+#define COMPONENT_FIELD(NAME, ...) \
+            Reflection::MakeField<decltype(ReflectedType::NAME)>(#NAME, offsetof(ReflectedType, NAME), ##__VA_ARGS__),
+
+#define END_COMPONENT_FIELDS() \
+        }; \
+        RLECS_FIELDS_END_WARNINGS \
+        static constexpr FieldTable table = Reflection::MakeTable(fields); \
+        return table; \
+    } \
+    const FieldTable* GetFieldTable() override { return &GetFields(); }
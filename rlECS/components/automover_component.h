@@ -30,6 +30,7 @@
 
 #include "entity_manager.h"
 #include "transform_component.h"
+#include "platform_services.h"
 
 #include "raylib.h"
 
@@ -48,11 +49,17 @@ public:
 
     inline void OnCreate() override { NeedUpdate = true; }
 
+    BEGIN_COMPONENT_FIELDS(AutoMoverComponent)
+        COMPONENT_FIELD(LinearSpeed)
+        COMPONENT_FIELD(AngularSpeed, FieldFlagDegrees)
+        COMPONENT_FIELD(UseHeading)
+    END_COMPONENT_FIELDS()
+
     inline void OnUpdate()
     {
         TransformComponent* transform = MustGetComponent<TransformComponent>();
 
-        float delta = GetFrameTime();
+        float delta = TimeSource::Get().GetFrameTime();
 
         transform->RotatePitch(AngularSpeed.x * delta);
         if (UseHeading)
@@ -41,4 +41,8 @@ public:
 
 public:
     DEFINE_COMPONENT(CameraComponent);
+
+    BEGIN_COMPONENT_FIELDS(CameraComponent)
+        COMPONENT_FIELD(FOVY, FieldFlagDegrees)
+    END_COMPONENT_FIELDS()
 };
\ No newline at end of file
@@ -29,10 +29,27 @@
 
 #include "entity_manager.h"
 #include "transform_component.h"
+#include "systems/occlusion_culler.h"
+#include "systems/render_snapshot.h"
 
 #include "raymath.h"
 #include "rlgl.h"
 
+#include <algorithm>
+
+inline BoundingBox TransformBoundingBox(const BoundingBox& bounds, const Matrix& matrix)
+{
+    BoundingBox result = { Vector3{ 1e30f, 1e30f, 1e30f }, Vector3{ -1e30f, -1e30f, -1e30f } };
+    for (int i = 0; i < 8; i++)
+    {
+        Vector3 corner = { (i & 1) ? bounds.max.x : bounds.min.x, (i & 2) ? bounds.max.y : bounds.min.y, (i & 4) ? bounds.max.z : bounds.min.z };
+        corner = Vector3Transform(corner, matrix);
+
+        result.min = Vector3Min(result.min, corner);
+        result.max = Vector3Max(result.max, corner);
+    }
+    return result;
+}
 
 class DrawableComponent : public Component
 {
@@ -40,14 +57,16 @@ public:
     DEFINE_COMPONENT(DrawableComponent);
 
     inline virtual void Draw() {}
-};
 
-enum class DrawShape
-{
-    Box,
-    Sphere,
-    Cylinder,
-    Plane
+    // world space bounds used for culling, drawables without bounds are always drawn
+    inline virtual bool GetWorldBounds(BoundingBox& bounds) { return false; }
+
+    // drawables that hide what is behind them can add themselves to the occlusion buffer
+    inline virtual bool IsOccluder() { return false; }
+    inline virtual void AddOccluder(OcclusionCuller& culler) {}
+
+    // copy what is needed to draw into the snapshot, drawables that return false are drawn live
+    inline virtual bool Extract(RenderSnapshot& snapshot) { return false; }
 };
 
 class ShapeComponent : public DrawableComponent
@@ -60,43 +79,116 @@ public:
     Vector3 ObjectOrigin = { 0, 0,0 };
     Vector3 ObjectOrientationShift = { 0, 0 ,0 };
 
+    // boxes and planes flagged as occluders are drawn into the occlusion buffer
+    bool Occluder = false;
+
 public:
 
     DEFINE_DERIVED_COMPONENT(ShapeComponent, DrawableComponent);
 
-    inline void Draw() override
-    {
-        TransformComponent* transform = Entities.GetComponent<TransformComponent>(this);
-        if (transform == nullptr)
-            return;
+    BEGIN_COMPONENT_FIELDS(ShapeComponent)
+        COMPONENT_FIELD(ObjectSize)
+        COMPONENT_FIELD(ObjectColor)
+        COMPONENT_FIELD(ObjectShape)
+        COMPONENT_FIELD(ObjectOrigin)
+        COMPONENT_FIELD(ObjectOrientationShift, FieldFlagDegrees)
+        COMPONENT_FIELD(Occluder)
+    END_COMPONENT_FIELDS()
 
-        transform->PushMatrix();
-
-        rlRotatef(ObjectOrientationShift.x, 1, 0, 0);
-        rlRotatef(ObjectOrientationShift.y, 0, 1, 0);
-        rlRotatef(ObjectOrientationShift.z, 0, 0, 1);
+    // the matrix used to draw the shape, the orientation shift rotates Z, then Y, then X before the transform
+    inline Matrix GetShapeMatrix(TransformComponent* transform)
+    {
+        Matrix shift = MatrixMultiply(MatrixMultiply(MatrixRotateZ(ObjectOrientationShift.z * DEG2RAD), MatrixRotateY(ObjectOrientationShift.y * DEG2RAD)), MatrixRotateX(ObjectOrientationShift.x * DEG2RAD));
+        return MatrixMultiply(shift, transform->GetWorldMatrix());
+    }
 
+    inline BoundingBox GetLocalBounds()
+    {
         switch (ObjectShape)
         {
-        case DrawShape::Box:
-            DrawCube(ObjectOrigin, ObjectSize.x, ObjectSize.y, ObjectSize.z, ObjectColor);
-            break;
         case DrawShape::Sphere:
-            DrawSphere(ObjectOrigin, std::max(std::max(ObjectSize.x, ObjectSize.y), ObjectSize.z), ObjectColor);
-            ;           break;
+        {
+            float radius = std::max(std::max(ObjectSize.x, ObjectSize.y), ObjectSize.z);
+            return BoundingBox{ Vector3Subtract(ObjectOrigin, Vector3{ radius, radius, radius }), Vector3Add(ObjectOrigin, Vector3{ radius, radius, radius }) };
+        }
         case DrawShape::Cylinder:
-            DrawCylinder(ObjectOrigin, ObjectSize.x, ObjectSize.y, ObjectSize.z, 32, ObjectColor);
-            break;
+        {
+            float radius = std::max(ObjectSize.x, ObjectSize.y);
+            return BoundingBox{ Vector3Add(ObjectOrigin, Vector3{ -radius, 0, -radius }), Vector3Add(ObjectOrigin, Vector3{ radius, ObjectSize.z, radius }) };
+        }
         case DrawShape::Plane:
-            rlDisableBackfaceCulling();
-            DrawPlane(ObjectOrigin, Vector2{ ObjectSize.x,ObjectSize.y }, ObjectColor);
-            rlDrawRenderBatchActive();
-            rlEnableBackfaceCulling();
-            break;
+            return BoundingBox{ Vector3Add(ObjectOrigin, Vector3{ -ObjectSize.x * 0.5f, 0, -ObjectSize.y * 0.5f }), Vector3Add(ObjectOrigin, Vector3{ ObjectSize.x * 0.5f, 0, ObjectSize.y * 0.5f }) };
+
         default:
-            break;
+        {
+            Vector3 halfSize = Vector3Scale(ObjectSize, 0.5f);
+            return BoundingBox{ Vector3Subtract(ObjectOrigin, halfSize), Vector3Add(ObjectOrigin, halfSize) };
+        }
+        }
+    }
+
+    inline bool GetWorldBounds(BoundingBox& bounds) override
+    {
+        TransformComponent* transform = Entities.GetComponent<TransformComponent>(this);
+        if (transform == nullptr)
+            return false;
+
+        bounds = TransformBoundingBox(GetLocalBounds(), GetShapeMatrix(transform));
+        return true;
+    }
+
+    inline bool IsOccluder() override
+    {
+        return Occluder && (ObjectShape == DrawShape::Box || ObjectShape == DrawShape::Plane);
+    }
+
+    inline void AddOccluder(OcclusionCuller& culler) override
+    {
+        TransformComponent* transform = Entities.GetComponent<TransformComponent>(this);
+        if (transform == nullptr)
+            return;
+
+        BoundingBox bounds = GetLocalBounds();
+        if (ObjectShape == DrawShape::Box)
+        {
+            culler.AddOccluderBox(GetShapeMatrix(transform), bounds.min, bounds.max);
         }
+        else
+        {
+            culler.AddOccluderQuad(GetShapeMatrix(transform),
+                Vector3{ bounds.min.x, bounds.min.y, bounds.min.z },
+                Vector3{ bounds.max.x, bounds.min.y, bounds.min.z },
+                Vector3{ bounds.max.x, bounds.min.y, bounds.max.z },
+                Vector3{ bounds.min.x, bounds.min.y, bounds.max.z });
+        }
+    }
+
+    inline bool GetRenderShape(RenderShape& shape)
+    {
+        TransformComponent* transform = Entities.GetComponent<TransformComponent>(this);
+        if (transform == nullptr)
+            return false;
 
-        transform->PopMatrix();
+        shape.Transform = MatrixTranspose(GetShapeMatrix(transform));
+        shape.Origin = ObjectOrigin;
+        shape.Size = ObjectSize;
+        shape.Tint = ObjectColor;
+        shape.Shape = ObjectShape;
+        return true;
+    }
+
+    inline bool Extract(RenderSnapshot& snapshot) override
+    {
+        RenderShape shape;
+        if (GetRenderShape(shape))
+            snapshot.Shapes.push_back(shape);
+        return true;
+    }
+
+    inline void Draw() override
+    {
+        RenderShape shape;
+        if (GetRenderShape(shape))
+            DrawRenderShape(shape);
     }
 };
@@ -43,4 +43,11 @@ public:
 
 public:
     DEFINE_COMPONENT(FlightDataComponent);
+
+    BEGIN_COMPONENT_FIELDS(FlightDataComponent)
+        COMPONENT_FIELD(Speed)
+        COMPONENT_FIELD(RotationSpeed, FieldFlagDegrees)
+        COMPONENT_FIELD(UseMouseButton)
+        COMPONENT_FIELD(UseHeading)
+    END_COMPONENT_FIELDS()
 };
\ No newline at end of file
@@ -29,61 +29,24 @@
 #include "light_component.h"
 #include "transform_component.h"
 
-void LightComponent::Setup(int index, Shader& shader)
+void LightComponent::Setup(int index)
 {
     LightIndex = index;
     LightEnabled = 1;
-
-    // TODO: Below code doesn't look good to me, 
-    // it assumes a specific shader naming and structure
-    // Probably this implementation could be improved
-    char enabledName[32] = "lights[x].enabled\0";
-    char typeName[32] = "lights[x].type\0";
-    char posName[32] = "lights[x].position\0";
-    char targetName[32] = "lights[x].target\0";
-    char colorName[32] = "lights[x].color\0";
-
-    // Set location name [x] depending on lights count
-    enabledName[7] = '0' + LightIndex;
-    typeName[7] = '0' + LightIndex;
-    posName[7] = '0' + LightIndex;
-    targetName[7] = '0' + LightIndex;
-    colorName[7] = '0' + LightIndex;
-
-    EnabledLoc = GetShaderLocation(shader, enabledName);
-    TypeLoc = GetShaderLocation(shader, typeName);
-    PosLoc = GetShaderLocation(shader, posName);
-    TargetLoc = GetShaderLocation(shader, targetName);
-    ColorLoc = GetShaderLocation(shader, colorName);
-
-    Update(shader);
 }
 
-void LightComponent::Update(Shader& shader)
+void LightComponent::Extract(RenderLight& light)
 {
-    // Send to shader light enabled state and type
-    SetShaderValue(shader, EnabledLoc, &LightEnabled, SHADER_UNIFORM_INT);
-    SetShaderValue(shader, TypeLoc, &LightType, SHADER_UNIFORM_INT);
-
     auto* transform = MustGetComponent<TransformComponent>();
 
-    Vector3 pos = transform->GetWorldPosition();
-    float p[3] = { pos.x,pos.y,pos.z };
-   
-    // Send to shader light position values
-    SetShaderValue(shader, PosLoc, p, SHADER_UNIFORM_VEC3);
+    light.Slot = LightIndex;
+    light.Type = (int)LightType;
+    light.Position = transform->GetWorldPosition();
 
-    // Send to shader light target position values
-    Vector3 target = { 0 };
+    light.Target = Vector3{ 0, 0, 0 };
     if (LightType == LightTypes::DIRECTIONAL)
-        target = transform->GetWorldTarget();
-
-    float t[3] = { target.x,target.y,target.z };
-
-    SetShaderValue(shader, TargetLoc, &target.x, SHADER_UNIFORM_VEC3);
+        light.Target = transform->GetWorldTarget();
 
-    // Send to shader light color values
-    float color[4] = { (float)LightColor.r / (float)255, (float)LightColor.g / (float)255,
-                       (float)LightColor.b / (float)255, (float)LightColor.a / (float)255 };
-    SetShaderValue(shader, ColorLoc, color, SHADER_UNIFORM_VEC4);
+    light.Range = Range;
+    light.LightColor = LightColor;
 }
@@ -30,6 +30,7 @@
 
 #include "entity_manager.h"
 #include "transform_component.h"
+#include "systems/render_snapshot.h"
 
 #include "raylib.h"
 
@@ -45,23 +46,29 @@ public:
     LightTypes LightType = LightTypes::POINT;
     Color LightColor = WHITE;
 
+    // point lights have no effect past this distance
+    float Range = 10;
+
     int LightEnabled = 1;
 
 protected:
     int LightIndex = -1;
 
-    // Shader locations
-    int EnabledLoc;
-    int TypeLoc;
-    int PosLoc;
-    int TargetLoc;
-    int ColorLoc;
-
 public:
     DEFINE_COMPONENT(LightComponent);
 
+    BEGIN_COMPONENT_FIELDS(LightComponent)
+        COMPONENT_FIELD(LightType)
+        COMPONENT_FIELD(LightColor)
+        COMPONENT_FIELD(Range)
+        COMPONENT_FIELD(LightEnabled)
+    END_COMPONENT_FIELDS()
+
     inline bool IsSetup() const { return LightIndex != -1; };
+    inline int GetLightIndex() const { return LightIndex; }
+
+    void Setup(int index);
 
-    void Setup(int index, Shader& shader);
-    void Update(Shader& shader);
+    // copies the values the shader needs, so they can be uploaded without touching the entity
+    void Extract(RenderLight& light);
 };
\ No newline at end of file
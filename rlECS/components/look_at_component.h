@@ -45,6 +45,11 @@ public:
 
     inline void OnCreate() override { NeedUpdate = true; }
 
+    // entity ids are kept when a scene is loaded, so the target can be saved as is
+    BEGIN_COMPONENT_FIELDS(LookAtComponent)
+        COMPONENT_FIELD(TargetEntityId)
+    END_COMPONENT_FIELDS()
+
     inline void SetTarget(Component* component)
     {
         if (component == nullptr)
@@ -0,0 +1,62 @@
+/**********************************************************************************************
+*
+*   raylib_ECS_sample * a sample Entity Component System using raylib
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+
+#pragma once
+
+#include "entity_manager.h"
+
+#include <memory>
+#include <stdint.h>
+#include <vector>
+
+struct PrefabTemplate;
+
+// on the root of every prefab instance, the template is shared by all of them
+class PrefabInstanceComponent : public Component
+{
+public:
+    DEFINE_COMPONENT(PrefabInstanceComponent);
+
+    std::shared_ptr<const PrefabTemplate> Source;
+
+    // a template component whose fields this instance changed, the changed values are packed in OverrideData
+    struct Override
+    {
+        uint32_t Record = 0;        // index into the template components
+        uint64_t Mask = 0;          // the changed fields, as from Reflection::DiffFields
+        uint32_t DataOffset = 0;
+        uint32_t DataSize = 0;
+    };
+
+    // empty until something in the instance differs from the template, see Prefab::UpdateOverrides
+    std::vector<Override> Overrides;
+    std::vector<uint8_t> OverrideData;
+
+    inline bool HasOverrides() const { return !Overrides.empty(); }
+};
@@ -29,6 +29,7 @@
 #pragma once
 
 #include "entity_manager.h"
+#include "render_backend.h"
 
 #include "raylib.h"
 #include "raymath.h"
@@ -50,6 +51,20 @@ private:
 public:
     DEFINE_COMPONENT(TransformComponent);
 
+    BEGIN_COMPONENT_FIELDS(TransformComponent)
+        COMPONENT_FIELD(Position)
+        COMPONENT_FIELD(Orientation)
+    END_COMPONENT_FIELDS()
+
+    // the world matrix is rebuilt the first time it's asked for
+    inline void LoadData(const void* data) override
+    {
+        Component::LoadData(data);
+        Dirty = true;
+    }
+
+    inline void OnFieldsChanged() override { SetDirty(); }
+
     void Detach()
     {
         if (GetParent() == InvalidEntityId)
@@ -69,6 +84,7 @@ public:
     void SetDirty()
     {
          Dirty = true;
+         Entities.MarkChanged();
          for (EntityId_t childId : GetEntity().Children)
          {
              TransformComponent* childTransform = Entities.GetComponent<TransformComponent>(childId);
@@ -270,12 +286,12 @@ public:
     void PushMatrix()
     {
         const Matrix& glMatrix = GetGLWorldMatrix();
-        rlPushMatrix();
-        rlMultMatrixf((float*)(&glMatrix.m0));
+        RenderBackend::Get().PushMatrix();
+        RenderBackend::Get().MultMatrix(glMatrix);
     }
 
     void PopMatrix()
     {
-        rlPopMatrix();
+        RenderBackend::Get().PopMatrix();
     }
 };
\ No newline at end of file
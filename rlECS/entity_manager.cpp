@@ -27,18 +27,36 @@
 **********************************************************************************************/
 
 #include "entity_manager.h"
+#include "profiler.h"
 
 #include <algorithm>
+#include <assert.h>
 #include <map>
+#include <stdio.h>
+#include <string.h>
+#include <unordered_map>
 
 
 std::map<size_t, ComponentInfo> ComponentFactories;
+std::unordered_map<ComponentKey_t, ComponentInfo> ComponentKeys;
 
 namespace ComponentManager
 {
-    void Register(size_t typeId, const char* name, ComponentFactory factory, bool unquie)
+    bool Register(size_t typeId, ComponentKey_t key, const char* name, ComponentFactory factory, bool unquie)
     {
-        ComponentFactories[typeId] = ComponentInfo{ typeId, name, factory, unquie };
+        auto itr = ComponentKeys.find(key);
+        if (itr != ComponentKeys.end() && strcmp(itr->second.Name, name) != 0)
+        {
+            // two type names hashing to one key would save and load as each other, so it has to be renamed
+            fprintf(stderr, "ComponentManager: %s has the same key as %s (%llx) and was not registered\n", name, itr->second.Name, (unsigned long long)key);
+            assert(!"component key collision");
+            return false;
+        }
+
+        ComponentInfo info = ComponentInfo{ typeId, key, name, factory, unquie };
+        ComponentKeys[key] = info;
+        ComponentFactories[typeId] = info;
+        return true;
     }
 
     const std::map<size_t, ComponentInfo>& GetComponentList()
@@ -46,6 +64,25 @@ namespace ComponentManager
         return ComponentFactories;
     }
 
+    const ComponentInfo* FindComponentInfo(ComponentKey_t key)
+    {
+        auto itr = ComponentKeys.find(key);
+        if (itr == ComponentKeys.end())
+            return nullptr;
+
+        return &itr->second;
+    }
+
+    const ComponentInfo* FindComponentInfo(const char* typeName)
+    {
+        // the name is checked as well, a name that was never registered can still hash to a key that was
+        const ComponentInfo* info = FindComponentInfo(HashComponentName(typeName));
+        if (info == nullptr || strcmp(info->Name, typeName) != 0)
+            return nullptr;
+
+        return info;
+    }
+
     Component* Create(size_t typeId, EntityId_t entityId, EntitySet& entities)
     {
         std::map<size_t, ComponentInfo>::iterator itr = ComponentFactories.find(typeId);
@@ -59,16 +96,136 @@ namespace ComponentManager
 
     Component* Create(const char* typeName, EntityId_t entityId, EntitySet& entities)
     {
-        for (auto itr : ComponentFactories)
-        {
-            if (strcmp(itr.second.Name, typeName) == 0)
-            {
-                return Create(itr.first, entityId, entities);
-            }
-        }
+        const ComponentInfo* info = FindComponentInfo(typeName);
+        if (info == nullptr)
+            return nullptr;
 
-        return nullptr;
+        Component* comp = info->Factory(entityId, entities);
+        entities.StoreComponent(comp->Id(), comp);
+        return comp;
+    }
+
+    Component* CreateFromKey(ComponentKey_t key, EntityId_t entityId, EntitySet& entities)
+    {
+        const ComponentInfo* info = FindComponentInfo(key);
+        if (info == nullptr)
+            return nullptr;
+
+        Component* comp = info->Factory(entityId, entities);
+        entities.StoreComponent(comp->Id(), comp);
+        return comp;
+    }
+}
+
+size_t Component::GetDataSize()
+{
+    const FieldTable* table = GetFieldTable();
+    return table != nullptr ? table->DataSize : 0;
+}
+
+void Component::SaveData(void* data)
+{
+    const FieldTable* table = GetFieldTable();
+    if (table != nullptr)
+        Reflection::SaveFields(*table, this, data);
+}
+
+void Component::LoadData(const void* data)
+{
+    const FieldTable* table = GetFieldTable();
+    if (table != nullptr)
+        Reflection::LoadFields(*table, this, data);
+}
+
+bool Component::CopyFields(Component* source)
+{
+    const FieldTable* table = GetFieldTable();
+    if (table == nullptr || source == nullptr || source->TypeId() != TypeId())
+        return false;
+
+    Reflection::CopyFields(*table, this, source);
+    return true;
+}
+
+ComponentList::ComponentList(const ComponentList& other)
+{
+    for (Component* component : other)
+        push_back(component);
+}
+
+ComponentList::ComponentList(ComponentList&& other) noexcept
+    : Count(other.Count)
+    , Capacity(other.Capacity)
+{
+    if (Capacity > 1)
+        Items = other.Items;
+    else
+        Single = other.Single;
+
+    other.Count = 0;
+    other.Capacity = 1;
+    other.Single = nullptr;
+}
+
+ComponentList::~ComponentList()
+{
+    if (Capacity > 1)
+        delete[] Items;
+}
+
+ComponentList& ComponentList::operator=(const ComponentList& other)
+{
+    if (this != &other)
+    {
+        clear();
+        for (Component* component : other)
+            push_back(component);
+    }
+    return *this;
+}
+
+ComponentList& ComponentList::operator=(ComponentList&& other) noexcept
+{
+    if (this == &other)
+        return *this;
+
+    if (Capacity > 1)
+        delete[] Items;
+
+    Count = other.Count;
+    Capacity = other.Capacity;
+    if (Capacity > 1)
+        Items = other.Items;
+    else
+        Single = other.Single;
+
+    other.Count = 0;
+    other.Capacity = 1;
+    other.Single = nullptr;
+    return *this;
+}
+
+void ComponentList::push_back(Component* component)
+{
+    if (Count == Capacity)
+    {
+        Component** items = new Component*[Capacity * 2];
+        std::copy(begin(), end(), items);
+        if (Capacity > 1)
+            delete[] Items;
+
+        Items = items;
+        Capacity *= 2;
     }
+
+    begin()[Count++] = component;
+}
+
+ComponentList::iterator ComponentList::erase(iterator itr)
+{
+    std::copy(itr + 1, end(), itr);
+    Count--;
+    return itr;
 }
 
 ComponentTable::~ComponentTable()
@@ -108,11 +265,53 @@ EntityId_t EntitySet::CreateEntity()
 
     EntityMap.emplace(NextEntity, Entity{ NextEntity });
     RootNodes.insert(NextEntity);
+    StampChunk(EntityChunkTable, NextEntity);
     NextEntity++;
+    MarkChanged();
+    HierarchyGeneration++;
+    NoteHierarchyChange(NextEntity - 1);
 
     return NextEntity - 1;
 }
 
+void EntitySet::NoteHierarchyChange(EntityId_t id)
+{
+    // loads touch every entity, so once the log fills up it is dropped and nothing more goes in until it is read,
+    // all that is kept is that only generations after the current one can be asked for
+    if (HierarchyChangesPaused)
+    {
+        HierarchyChangesStart = HierarchyGeneration;
+        return;
+    }
+
+    if (HierarchyChanges.size() >= MaxHierarchyChanges)
+    {
+        HierarchyChanges.clear();
+        HierarchyChangesPaused = true;
+        HierarchyChangesStart = HierarchyGeneration;
+        return;
+    }
+
+    HierarchyChanges.emplace_back(HierarchyGeneration, id);
+}
+
+bool EntitySet::GetHierarchyChanges(uint64_t sinceGeneration, std::vector<EntityId_t>& ids)
+{
+    ids.clear();
+
+    // a reader from before the log filled up has to rebuild anyway, the changes after it can be tracked again
+    HierarchyChangesPaused = false;
+    if (sinceGeneration < HierarchyChangesStart || sinceGeneration > HierarchyGeneration)
+        return false;
+
+    for (auto itr = HierarchyChanges.rbegin(); itr != HierarchyChanges.rend() && itr->first > sinceGeneration; ++itr)
+        ids.push_back(itr->second);
+
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    return true;
+}
+
 void EntitySet::RemoveFromParent(Entity* entity)
 {
     if (entity == nullptr)
@@ -124,6 +323,8 @@ void EntitySet::RemoveFromParent(Entity* entity)
         auto itr = std::find(parent->Children.begin(), parent->Children.end(), entity->Id);
         if (itr != parent->Children.end())
             parent->Children.erase(itr);
+
+        StampChunk(EntityChunkTable, parent->Id);
     }
 }
 
@@ -134,30 +335,38 @@ void EntitySet::RemoveEntity(EntityId_t entityId, bool removeChildren)
         return;
 
     Entity& entity = itr->second;
+    MarkChanged();
+    HierarchyGeneration++;
+    NoteHierarchyChange(entityId);
+    StampChunk(EntityChunkTable, entityId);
 
+    // the children remove themselves from the list as they go
+    std::vector<EntityId_t> children = entity.Children;
     if (!removeChildren)
     {
-        for (EntityId_t childId : entity.Children)
+        for (EntityId_t childId : children)
         {
             ReparentEntity(childId, entity.Parent);
         }
     }
     else
     {
-        for (EntityId_t childId : entity.Children)
+        for (EntityId_t childId : children)
         {
             RemoveEntity(childId, true);
         }
     }
 
-    for (auto componentTable : ComponentDB)
+    for (auto& componentTable : ComponentDB)
     {
         EraseAllComponents(componentTable.first, entityId);
     }
     if (entity.Parent == InvalidEntityId)
-        RootNodes.erase(entity.Parent);
+        RootNodes.erase(entityId);
 
     RemoveFromParent(&entity);
+    RemoveName(entity);
+    ClearNameCounters(entityId);
 
     EntityMap.erase(itr);
 }
@@ -173,13 +382,137 @@ Entity* EntitySet::GetEntity(EntityId_t id)
 
 const char* EntitySet::GetEntityName(EntityId_t id)
 {
-    static std::string emptyName;
-
     auto itr = EntityMap.find(id);
     if (itr == EntityMap.end())
-        return emptyName.c_str();
+        return Names.Get(EmptyName);
 
-    return itr->second.Name.c_str();
+    return Names.Get(itr->second.NameId);
+}
+
+void EntitySet::SetEntityName(EntityId_t id, const char* name)
+{
+    Entity* entity = GetEntity(id);
+    if (entity == nullptr)
+        return;
+
+    NameId_t nameId = Names.Intern(name != nullptr ? name : "");
+    if (nameId == entity->NameId)
+    {
+        Names.Release(nameId);
+        return;
+    }
+
+    RemoveName(*entity);
+    entity->NameId = nameId;
+    MarkChanged();
+    StampChunk(EntityChunkTable, id);
+
+    if (nameId == EmptyName)
+        return;
+
+    NameIndex[nameId].push_back(id);
+    NoteChildName(entity->Parent, nameId);
+}
+
+void EntitySet::RemoveName(Entity& entity)
+{
+    if (entity.NameId == EmptyName)
+        return;
+
+    auto itr = NameIndex.find(entity.NameId);
+    if (itr != NameIndex.end())
+    {
+        std::vector<EntityId_t>& ids = itr->second;
+        auto entry = std::find(ids.begin(), ids.end(), entity.Id);
+        if (entry != ids.end())
+        {
+            *entry = ids.back();
+            ids.pop_back();
+        }
+
+        if (ids.empty())
+            NameIndex.erase(itr);
+    }
+
+    Names.Release(entity.NameId);
+    entity.NameId = EmptyName;
+}
+
+void EntitySet::NoteChildName(EntityId_t parent, NameId_t name)
+{
+    if (name == EmptyName)
+        return;
+
+    std::string_view baseName;
+    int suffix = 0;
+    SplitNameSuffix(Names.Get(name), baseName, suffix);
+
+    auto& counters = NameCounters[parent];
+
+    // the counters hold on to their base names so the ids stay valid
+    NameId_t baseId = Names.Intern(baseName);
+    auto itr = counters.find(baseId);
+    if (itr == counters.end())
+    {
+        counters.emplace(baseId, suffix);
+        return;
+    }
+
+    Names.Release(baseId);
+    if (suffix > itr->second)
+        itr->second = suffix;
+}
+
+void EntitySet::ClearNameCounters(EntityId_t parent)
+{
+    auto itr = NameCounters.find(parent);
+    if (itr == NameCounters.end())
+        return;
+
+    for (auto& counter : itr->second)
+        Names.Release(counter.first);
+
+    NameCounters.erase(itr);
+}
+
+EntityId_t EntitySet::FindEntity(const char* name)
+{
+    const std::vector<EntityId_t>& ids = FindEntities(name);
+    return ids.empty() ? InvalidEntityId : ids.front();
+}
+
+const std::vector<EntityId_t>& EntitySet::FindEntities(const char* name)
+{
+    static std::vector<EntityId_t> noEntities;
+
+    NameId_t nameId = Names.Find(name != nullptr ? name : "");
+    if (nameId == InvalidName || nameId == EmptyName)
+        return noEntities;
+
+    auto itr = NameIndex.find(nameId);
+    if (itr == NameIndex.end())
+        return noEntities;
+
+    return itr->second;
+}
+
+std::string EntitySet::GetUniqueName(EntityId_t parent, const char* baseName)
+{
+    std::string name = baseName != nullptr ? baseName : "";
+
+    NameId_t baseId = Names.Find(name);
+    if (baseId == InvalidName || baseId == EmptyName)
+        return name;
+
+    auto parentCounters = NameCounters.find(parent);
+    if (parentCounters == NameCounters.end())
+        return name;
+
+    auto counter = parentCounters->second.find(baseId);
+    if (counter == parentCounters->second.end())
+        return name;
+
+    return name + " (" + std::to_string(counter->second + 1) + ")";
 }
 
 EntityId_t EntitySet::GetEntityParent(EntityId_t id)
@@ -203,6 +536,11 @@ EntityId_t EntitySet::AddChild(EntityId_t id)
         RootNodes.erase(childId);
 
     child->Parent = id;
+    MarkChanged();
+    HierarchyGeneration++;
+    NoteHierarchyChange(childId);
+    StampChunk(EntityChunkTable, id);
+    StampChunk(EntityChunkTable, childId);
 
     return childId;
 }
@@ -218,13 +556,165 @@ void EntitySet::ReparentEntity(EntityId_t id, EntityId_t newParent)
 
     RemoveFromParent(entity);
     entity->Parent = newParent;
+    MarkChanged();
+    HierarchyGeneration++;
+    NoteHierarchyChange(id);
+    StampChunk(EntityChunkTable, id);
 
     if (entity->Parent == InvalidEntityId)
         RootNodes.insert(id);
 
     Entity* parent = GetEntity(newParent);
     if (parent != nullptr)
+    {
         parent->Children.push_back(id);
+        StampChunk(EntityChunkTable, newParent);
+    }
+
+    NoteChildName(newParent, entity->NameId);
+}
+
+Entity* EntitySet::LoadEntity(EntityId_t id, EntityId_t parent, const EntityId_t* children, size_t childCount)
+{
+    if (id == InvalidEntityId)
+        return nullptr;
+
+    size_t count = EntityMap.size();
+    auto itr = EntityMap.emplace_hint(EntityMap.end(), id, Entity{ id });
+    if (EntityMap.size() == count)
+        return nullptr;
+
+    Entity& entity = itr->second;
+    entity.Parent = parent;
+    if (childCount > 0)
+        entity.Children.assign(children, children + childCount);
+
+    if (parent == InvalidEntityId)
+        RootNodes.emplace_hint(RootNodes.end(), id);
+
+    if (id >= NextEntity)
+        NextEntity = id + 1;
+
+    StampChunk(EntityChunkTable, id);
+    MarkChanged();
+    HierarchyGeneration++;
+    NoteHierarchyChange(id);
+
+    return &entity;
+}
+
+EntityId_t EntitySet::ReserveEntityIds(size_t count)
+{
+    // ids are only ever handed out from NextEntity up, so it is above every id in use
+    EntityId_t first = NextEntity;
+    NextEntity += count;
+    return first;
+}
+
+void EntitySet::LoadComponents(size_t componentId, Component* const* components, size_t count)
+{
+    if (count == 0)
+        return;
+
+    ComponentTable& componentTable = ComponentDB[componentId];
+
+    for (size_t i = 0; i < count; i++)
+    {
+        Component* component = components[i];
+        auto itr = componentTable.Entities.emplace_hint(componentTable.Entities.end(), component->EntityId, ComponentList());
+        itr->second.push_back(component);
+        StampChunk(componentId, component->EntityId);
+
+        component->OnCreate();
+        if (component->WantUpdate())
+            ComponentUpdateCache.push_back(component);
+    }
+
+    MarkChanged();
+    ComponentGeneration++;
+}
+
+void EntitySet::RemoveEntities(std::function<bool(EntityId_t)> filter)
+{
+    std::vector<EntityId_t> removed;
+    for (const auto& entity : EntityMap)
+    {
+        if (filter(entity.first))
+            removed.push_back(entity.first);
+    }
+
+    if (removed.empty())
+        return;
+
+    // the list is sorted, so membership is a binary search
+    auto isRemoved = [&removed](EntityId_t id) { return std::binary_search(removed.begin(), removed.end(), id); };
+
+    ComponentUpdateCache.erase(std::remove_if(ComponentUpdateCache.begin(), ComponentUpdateCache.end(),
+        [&isRemoved](Component* component) { return isRemoved(component->EntityId); }), ComponentUpdateCache.end());
+
+    // both the tables and the removed list are in id order, so each table is one walk
+    for (auto& componentTable : ComponentDB)
+    {
+        auto& entities = componentTable.second.Entities;
+        auto removedItr = removed.begin();
+        for (auto itr = entities.begin(); itr != entities.end();)
+        {
+            removedItr = std::lower_bound(removedItr, removed.end(), itr->first);
+            if (removedItr == removed.end())
+                break;
+
+            if (*removedItr != itr->first)
+            {
+                ++itr;
+                continue;
+            }
+
+            for (Component* component : itr->second)
+            {
+                component->OnDestory();
+                delete(component);
+            }
+            StampChunk(componentTable.first, itr->first);
+            itr = entities.erase(itr);
+        }
+    }
+
+    HierarchyGeneration++;
+    for (EntityId_t id : removed)
+    {
+        auto itr = EntityMap.find(id);
+        Entity& entity = itr->second;
+        NoteHierarchyChange(id);
+
+        for (EntityId_t childId : entity.Children)
+        {
+            if (isRemoved(childId))
+                continue;
+
+            Entity* child = GetEntity(childId);
+            if (child == nullptr)
+                continue;
+
+            child->Parent = InvalidEntityId;
+            RootNodes.insert(childId);
+            NoteHierarchyChange(childId);
+            StampChunk(EntityChunkTable, childId);
+        }
+
+        if (entity.Parent == InvalidEntityId)
+            RootNodes.erase(id);
+        else if (!isRemoved(entity.Parent))
+            RemoveFromParent(&entity);
+
+        RemoveName(entity);
+        ClearNameCounters(id);
+        StampChunk(EntityChunkTable, id);
+
+        EntityMap.erase(itr);
+    }
+
+    MarkChanged();
+    ComponentGeneration++;
 }
 
 size_t EntitySet::GetParentCount(EntityId_t id)
@@ -241,6 +731,8 @@ size_t EntitySet::GetParentCount(EntityId_t id)
 
 void EntitySet::Update()
 {
+    PROFILE_SCOPE("EntitySet::Update");
+
     for (auto* component : ComponentUpdateCache)
     {
         if (component->Active)
@@ -262,11 +754,23 @@ void EntitySet::DoForEachEntity(std::function<void(EntityId_t)> func, EntityId_t
     }
     else
     {
-        for (auto entity : EntityMap)
+        for (const auto& entity : EntityMap)
             func(entity.first);
     }
 }
 
+void EntitySet::DoForEachEntityRecord(std::function<void(Entity&)> func)
+{
+    for (auto& entity : EntityMap)
+        func(entity.second);
+}
+
+void EntitySet::DoForEachEntityRecordInRange(EntityId_t first, EntityId_t last, std::function<void(Entity&)> func)
+{
+    for (auto itr = EntityMap.lower_bound(first); itr != EntityMap.end() && itr->first < last; ++itr)
+        func(itr->second);
+}
+
 void EntitySet::DoForEachRootEntity(std::function<void(EntityId_t)> func)
 {
     for (EntityId_t entity : RootNodes)
@@ -308,6 +812,9 @@ Component* EntitySet::StoreComponent(size_t compId, Component* component)
         return component;
 
     component->OnCreate();
+    MarkChanged();
+    ComponentGeneration++;
+    StampChunk(compId, component->EntityId);
 
     if (component->WantUpdate())
         ComponentUpdateCache.push_back(component);
@@ -342,9 +849,9 @@ bool EntitySet::HasComponent(size_t componentId, EntityId_t entityId)
     return entityCacheItr != componentTable.Entities.end() && !entityCacheItr->second.empty();
 }
 
-static std::vector<Component*> EmptyComponentList;
+static ComponentList EmptyComponentList;
 
-const std::vector<Component*>& EntitySet::FindComponents(size_t compId, EntityId_t entityId)
+const ComponentList& EntitySet::FindComponents(size_t compId, EntityId_t entityId)
 {
     auto componentTableItr = ComponentDB.find(compId);
     if (componentTableItr == ComponentDB.end())
@@ -352,7 +859,7 @@ const std::vector<Component*>& EntitySet::FindComponents(size_t compId, EntityId
 
     ComponentTable& componentTable = componentTableItr->second;
 
-    std::map<uint64_t, ComponentList>::iterator entityCacheItr = componentTable.Entities.find(entityId);
+    ComponentTable::EntityComponents::iterator entityCacheItr = componentTable.Entities.find(entityId);
     if (entityCacheItr == componentTable.Entities.end())
         return EmptyComponentList;
 
@@ -381,6 +888,9 @@ void EntitySet::EraseAllComponents(size_t compId, EntityId_t entityId)
         }
 
         componentTable.Entities.erase(entityCacheItr);
+        MarkChanged();
+        ComponentGeneration++;
+        StampChunk(compId, entityId);
     }
 }
 
@@ -403,8 +913,11 @@ void EntitySet::EraseComponent(size_t compId, Component* component)
         if (component->WantUpdate())
             ComponentUpdateCache.erase(std::find(ComponentUpdateCache.begin(), ComponentUpdateCache.end(), component));
 
+        StampChunk(compId, component->EntityId);
         delete(component);
         components.erase(itr);
+        MarkChanged();
+        ComponentGeneration++;
     }
 }
 
@@ -423,6 +936,50 @@ void EntitySet::DoForEachEntity(size_t compId, std::function<void(Component*)> f
     }
 }
 
+void EntitySet::DoForEachComponentInRange(size_t compId, EntityId_t first, EntityId_t last, std::function<void(Component*)> func)
+{
+    auto componentTableItr = ComponentDB.find(compId);
+    if (componentTableItr == ComponentDB.end())
+        return;
+
+    auto& entities = componentTableItr->second.Entities;
+    for (auto itr = entities.lower_bound(first); itr != entities.end() && itr->first < last; ++itr)
+    {
+        for (Component* component : itr->second)
+            func(component);
+    }
+}
+
+void EntitySet::StampChunk(size_t tableId, EntityId_t id)
+{
+    std::pair<size_t, uint64_t> chunk(tableId, id / ChangeChunkSpan);
+    if (LastStamped == nullptr || chunk != LastStampedChunk)
+    {
+        LastStamped = &ChunkStamps[chunk];
+        LastStampedChunk = chunk;
+    }
+
+    *LastStamped = ++LastChunkStamp;
+}
+
+void EntitySet::MarkComponentChanged(Component* component)
+{
+    if (component == nullptr)
+        return;
+
+    StampChunk(component->Id(), component->EntityId);
+    MarkChanged();
+}
+
+void EntitySet::DoForEachChangedChunk(uint64_t sinceStamp, std::function<void(size_t tableId, uint64_t chunk)> func)
+{
+    for (const auto& stamp : ChunkStamps)
+    {
+        if (stamp.second > sinceStamp)
+            func(stamp.first.first, stamp.first.second);
+    }
+}
+
 void EntitySet::DoForEachComponentInEntity(EntityId_t entityId, std::function<void(Component*)> func)
 {
      for (auto& componentTable : ComponentDB)
@@ -28,21 +28,47 @@
 
 #pragma once
 
+#include "component_reflection.h"
+#include "memory_pool.h"
+#include "name_table.h"
+
 #include <stdint.h>
 #include <functional>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <map>
 
 using EntityId_t = uint64_t;
 constexpr EntityId_t InvalidEntityId = uint64_t(-1);
 
+// a hash of the component type name, the same in every build and module so it can be saved or sent
+using ComponentKey_t = uint64_t;
+
+constexpr ComponentKey_t HashComponentName(const char* name)
+{
+    // FNV-1a
+    ComponentKey_t hash = 0xcbf29ce484222325ull;
+    for (; *name != 0; name++)
+    {
+        hash ^= uint8_t(*name);
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+// changes are tracked for saving in runs of this many ids, see SceneFile::IncrementalSaver
+constexpr EntityId_t ChangeChunkSpan = 4096;
+
+// the table the change stamps of the entities themselves are kept under
+constexpr size_t EntityChunkTable = size_t(-1);
+
 class Entity
 {
 public:
     EntityId_t Id = InvalidEntityId;
-    std::string Name;
+    NameId_t NameId = EmptyName;
 
     EntityId_t Parent = InvalidEntityId;
     std::vector<EntityId_t> Children;
@@ -51,12 +77,55 @@ public:
 class EntitySet;
 class Component;
 
-using ComponentList = std::vector<Component*>;
+namespace ComponentManager
+{
+    template<class T>
+    inline T* Create(EntityId_t entityId, EntitySet& entities);
+}
+
+// the components of one type on an entity, nearly always just one, so that one is kept in place instead of allocated
+class ComponentList
+{
+public:
+    using iterator = Component**;
+    using const_iterator = Component* const*;
+
+    ComponentList() = default;
+    ComponentList(const ComponentList& other);
+    ComponentList(ComponentList&& other) noexcept;
+    ~ComponentList();
+
+    ComponentList& operator=(const ComponentList& other);
+    ComponentList& operator=(ComponentList&& other) noexcept;
+
+    void push_back(Component* component);
+    iterator erase(iterator itr);
+    inline void clear() { Count = 0; }
+
+    inline iterator begin() { return Capacity > 1 ? Items : &Single; }
+    inline iterator end() { return begin() + Count; }
+    inline const_iterator begin() const { return Capacity > 1 ? Items : &Single; }
+    inline const_iterator end() const { return begin() + Count; }
+
+    inline size_t size() const { return Count; }
+    inline bool empty() const { return Count == 0; }
+    inline Component* operator[](size_t index) const { return begin()[index]; }
+
+private:
+    union
+    {
+        Component* Single = nullptr;
+        Component** Items;
+    };
+    uint32_t Count = 0;
+    uint32_t Capacity = 1;
+};
 
 class ComponentTable
 {
 public:
-    std::map<EntityId_t, ComponentList> Entities;
+    using EntityComponents = std::map<EntityId_t, ComponentList, std::less<EntityId_t>, PoolAllocator<std::pair<const EntityId_t, ComponentList>>>;
+    EntityComponents Entities;
 
     virtual ~ComponentTable();
 
@@ -66,7 +135,7 @@ public:
 class EntitySet
 {
 private:
-    std::map<EntityId_t, Entity> EntityMap;
+    std::map<EntityId_t, Entity, std::less<EntityId_t>, PoolAllocator<std::pair<const EntityId_t, Entity>>> EntityMap;
     std::set<EntityId_t> RootNodes;
 
     uint64_t NextEntity = 0;
@@ -74,13 +143,44 @@ private:
     std::map<size_t, ComponentTable> ComponentDB;
     std::vector<Component*> ComponentUpdateCache;
 
+    uint64_t ChangeGeneration = 0;
+    uint64_t HierarchyGeneration = 0;
+    uint64_t ComponentGeneration = 0;
+
+    // the entities each hierarchy generation touched, oldest first, dropped all at once when it fills up
+    // nothing is kept until the first GetHierarchyChanges, sets no tree view looks at never hold a log
+    std::vector<std::pair<uint64_t, EntityId_t>> HierarchyChanges;
+    uint64_t HierarchyChangesStart = 0;
+    bool HierarchyChangesPaused = true;
+
+    NameTable Names;
+    std::unordered_map<NameId_t, std::vector<EntityId_t>> NameIndex;
+
+    // the highest "(n)" used for each base name under a parent, roots are under InvalidEntityId
+    std::unordered_map<EntityId_t, std::unordered_map<NameId_t, int>> NameCounters;
+
+    // the last change to each run of ids in each table, savers write the chunks stamped after their last save
+    std::map<std::pair<size_t, uint64_t>, uint64_t> ChunkStamps;
+    uint64_t LastChunkStamp = 0;
+
+    // changes come in runs to the same chunk, loads especially, so the last one is kept at hand
+    uint64_t* LastStamped = nullptr;
+    std::pair<size_t, uint64_t> LastStampedChunk;
+
 private:   
     void EraseAllComponents(size_t componentId, EntityId_t entityId);
     void EraseComponent(size_t componentId, Component* component);
     Component* FindComponent(size_t componentId, EntityId_t entityId);
-    const std::vector<Component*>& FindComponents(size_t componentId, EntityId_t entityId);
+    const ComponentList& FindComponents(size_t componentId, EntityId_t entityId);
 
     void RemoveFromParent(Entity* entity);
+    void NoteHierarchyChange(EntityId_t id);
+
+    void RemoveName(Entity& entity);
+    void NoteChildName(EntityId_t parent, NameId_t name);
+    void ClearNameCounters(EntityId_t parent);
+
+    void StampChunk(size_t tableId, EntityId_t id);
 
 public:
     EntityId_t CreateEntity();
@@ -88,12 +188,56 @@ public:
     Entity* GetEntity(EntityId_t id);
 
     const char* GetEntityName(EntityId_t id);
+    void SetEntityName(EntityId_t id, const char* name);
     EntityId_t GetEntityParent(EntityId_t id);
 
+    /// <summary>
+    /// Find entities by exact name
+    /// </summary>
+    /// <param name="name">The name to look for</param>
+    /// <returns>The first entity with the name, or InvalidEntityId</returns>
+    EntityId_t FindEntity(const char* name);
+    const std::vector<EntityId_t>& FindEntities(const char* name);
+
+    /// <summary>
+    /// A name no child of the parent has, "Base", then "Base (1)", "Base (2)" and so on
+    /// </summary>
+    /// <param name="parent">The parent the new entity goes under, InvalidEntityId for the root</param>
+    /// <param name="baseName">The name to start from</param>
+    std::string GetUniqueName(EntityId_t parent, const char* baseName);
+
+    inline const NameTable& GetNameTable() const { return Names; }
+
     EntityId_t AddChild(EntityId_t id);
     void ReparentEntity(EntityId_t id, EntityId_t newParent);
     size_t GetParentCount(EntityId_t id);
 
+    inline size_t GetEntityCount() const { return EntityMap.size(); }
+
+    /// <summary>
+    /// Add an entity with a known id and place in the tree, used when loading saved scenes
+    /// Ids added in increasing order are appended without searching
+    /// </summary>
+    /// <returns>The new entity, or nullptr if the id is already used</returns>
+    Entity* LoadEntity(EntityId_t id, EntityId_t parent, const EntityId_t* children, size_t childCount);
+
+    /// <summary>
+    /// Take a run of unused ids for LoadEntity, all of them higher than any id in use so loading them appends
+    /// </summary>
+    /// <returns>The first id of the run</returns>
+    EntityId_t ReserveEntityIds(size_t count);
+
+    /// <summary>
+    /// Store a run of newly created components with the same component id, OnCreate is called on each
+    /// </summary>
+    void LoadComponents(size_t componentId, Component* const* components, size_t count);
+
+    /// <summary>
+    /// Remove every entity the filter accepts in one pass over the set, much faster than removing them one at a time
+    /// Children are not removed with their parents, kept children of removed entities become roots
+    /// </summary>
+    void RemoveEntities(std::function<bool(EntityId_t)> filter);
+
     bool HasComponent(size_t componentId, EntityId_t entityId);
 
     template<class T>
@@ -104,6 +248,46 @@ public:
 
     void Update();
 
+    /// <summary>
+    /// Note that something in the set changed (hierarchy, components or a transform)
+    /// Views compare the generation against the last one they drew to skip redundant redraws
+    /// </summary>
+    inline void MarkChanged() { ChangeGeneration++; }
+    inline uint64_t GetChangeGeneration() const { return ChangeGeneration; }
+
+    /// <summary>
+    /// Bumped only when entities are created, removed or reparented
+    /// Tree views update their rows when this changes instead of walking the tree every frame
+    /// </summary>
+    inline uint64_t GetHierarchyGeneration() const { return HierarchyGeneration; }
+
+    static constexpr size_t MaxHierarchyChanges = 1024;
+
+    /// <summary>
+    /// The entities created, removed or reparented after a hierarchy generation, so tree views can patch their rows
+    /// </summary>
+    /// <param name="ids">Gets the ids, sorted and each listed once</param>
+    /// <returns>False if the changes after that generation were dropped (a scene load or clear, or this is the first call), the caller has to rebuild</returns>
+    bool GetHierarchyChanges(uint64_t sinceGeneration, std::vector<EntityId_t>& ids);
+
+    // bumped only when components are added or removed
+    inline uint64_t GetComponentGeneration() const { return ComponentGeneration; }
+
+    /// <summary>
+    /// Note that the data of a component changed, so the next incremental save writes it
+    /// The editor does this for every edit it makes, code that writes fields outside of play mode should as well
+    /// </summary>
+    void MarkComponentChanged(Component* component);
+
+    // the newest change stamp, savers remember it to know what changed after them
+    inline uint64_t GetLastChunkStamp() const { return LastChunkStamp; }
+
+    /// <summary>
+    /// Iterate the chunks of ids that changed after a stamp
+    /// </summary>
+    /// <param name="func">Called with the component id of the table (EntityChunkTable for the entities) and the chunk, id / ChangeChunkSpan</param>
+    void DoForEachChangedChunk(uint64_t sinceStamp, std::function<void(size_t tableId, uint64_t chunk)> func);
+
     Component* StoreComponent(size_t componentId, Component* component);
 
     /// <summary>
@@ -112,6 +296,15 @@ public:
     /// <param name="func">Callback to run for every entity</param>
     void DoForEachEntity(std::function<void(EntityId_t)> func, EntityId_t startWith = InvalidEntityId);
 
+    // the entities themselves in id order, for bulk copies that would otherwise look up every id
+    void DoForEachEntityRecord(std::function<void(Entity&)> func);
+
+    // the entities with ids from first up to but not including last, in id order
+    void DoForEachEntityRecordInRange(EntityId_t first, EntityId_t last, std::function<void(Entity&)> func);
+
+    // the components in one table whose entity ids are from first up to but not including last, in id order
+    void DoForEachComponentInRange(size_t componentId, EntityId_t first, EntityId_t last, std::function<void(Component*)> func);
+
     /// <summary>
     /// Iterate the root entities by Id
     /// </summary>
@@ -168,15 +361,7 @@ public:
     }
 
     template<class T>
-    inline T* AddComponent(Component* component)
-    {
-        if (component == nullptr)
-            return AddComponent<T>();
-
-        T* newComponent = ComponentManager::Create<T>(component->EntityId, *this);
-
-        return static_cast<T*>(StoreComponent(newComponent->Id(), newComponent));
-    }
+    T* AddComponent(Component* component);
 
     template<class T>
     inline void RemoveComponents(EntityId_t entityId)
@@ -185,12 +370,14 @@ public:
     }
 
     template<class T>
-    inline void RemoveComponent(Component* component)
-    {
-        if (component == nullptr)
-            return;
+    void RemoveComponent(Component* component);
 
-        EraseComponent(component->Id(), component);
+    void RemoveComponent(Component* component);
+
+    // every component in a table that belongs to the entity
+    inline const ComponentList& GetComponents(size_t componentId, EntityId_t entityId)
+    {
+        return FindComponents(componentId, entityId);
     }
 
     template<class T>
@@ -200,10 +387,7 @@ public:
     }
 
     template<class T>
-    inline T* GetComponent(Component* component)
-    {
-        return static_cast<T*>(FindComponent(T::GetComponentId(), component->EntityId));
-    }
+    T* GetComponent(Component* component);
 
     template<class T>
     inline T* MustGetComponent(EntityId_t entityId)
@@ -216,14 +400,7 @@ public:
     }
 
     template<class T>
-    inline T* MustGetComponent(Component* component)
-    {
-        T* newComponent = static_cast<T*>(FindComponent(T::GetComponentId(), component->EntityId));
-        if (newComponent != nullptr)
-            return newComponent;
-
-        return AddComponent<T>(component->EntityId);
-    }
+    T* MustGetComponent(Component* component);
 };
 
 class Component
@@ -243,6 +420,11 @@ public:
     {}
 
     virtual ~Component() = default;
+
+    // a large scene makes and frees them by the million, the pool saves a heap allocation for each
+    static void* operator new(size_t size) { return MemoryPool::Allocate(size); }
+    static void operator delete(void* block, size_t size) { MemoryPool::Free(block, size); }
+
     virtual size_t Id() { return 0; }
     virtual size_t TypeId() { return 0; }
     virtual const char* ComponentName() { return nullptr; }
@@ -251,6 +433,21 @@ public:
     virtual void OnDestory() {}
     virtual void OnUpdate() {}
 
+    // the reflected fields, see BEGIN_COMPONENT_FIELDS
+    virtual const FieldTable* GetFieldTable() { return nullptr; }
+
+    // plain data saved in scene files and copied back in one go, 0 if there is nothing to save
+    // reflected components save their fields packed in declaration order
+    virtual size_t GetDataSize();
+    virtual void SaveData(void* data);
+    virtual void LoadData(const void* data);
+
+    // copy the reflected fields from another component of the same type
+    bool CopyFields(Component* source);
+
+    // called after the fields were written directly (by an undo and the like), not by LoadData
+    virtual void OnFieldsChanged() {}
+
     inline bool WantUpdate() { return NeedUpdate; }
 
     template<class T>
@@ -308,10 +505,56 @@ public:
     }
 };
 
+// EntitySet templates that need the full Component definition
+template<class T>
+inline T* EntitySet::AddComponent(Component* component)
+{
+    if (component == nullptr)
+        return AddComponent<T>();
+
+    T* newComponent = ComponentManager::Create<T>(component->EntityId, *this);
+
+    return static_cast<T*>(StoreComponent(newComponent->Id(), newComponent));
+}
+
+template<class T>
+inline void EntitySet::RemoveComponent(Component* component)
+{
+    if (component == nullptr)
+        return;
+
+    EraseComponent(component->Id(), component);
+}
+
+inline void EntitySet::RemoveComponent(Component* component)
+{
+    if (component == nullptr)
+        return;
+
+    EraseComponent(component->Id(), component);
+}
+
+template<class T>
+inline T* EntitySet::GetComponent(Component* component)
+{
+    return static_cast<T*>(FindComponent(T::GetComponentId(), component->EntityId));
+}
+
+template<class T>
+inline T* EntitySet::MustGetComponent(Component* component)
+{
+    T* newComponent = static_cast<T*>(FindComponent(T::GetComponentId(), component->EntityId));
+    if (newComponent != nullptr)
+        return newComponent;
+
+    return AddComponent<T>(component->EntityId);
+}
+
 #define DEFINE_COMPONENT(TYPE) \
     TYPE(EntityId_t id, EntitySet& entities) : Component(id, entities) {} \
-    static size_t GetComponentId() { return reinterpret_cast<size_t>(#TYPE); } \
-    static size_t GetComponentTypeId() { return reinterpret_cast<size_t>(#TYPE); } \
+    static constexpr ComponentKey_t GetComponentKey() { return HashComponentName(#TYPE); } \
+    static size_t GetComponentId() { return size_t(HashComponentName(#TYPE)); } \
+    static size_t GetComponentTypeId() { return size_t(HashComponentName(#TYPE)); } \
     static const char* GetComponentName() { return #TYPE; } \
     size_t Id() override { return TYPE::GetComponentId(); } \
     size_t TypeId() override { return TYPE::GetComponentTypeId(); } \
@@ -320,8 +563,9 @@ public:
 
 #define DEFINE_DERIVED_COMPONENT(TYPE, BASETYPE) \
     TYPE(EntityId_t id, EntitySet& entities) : BASETYPE(id, entities) {} \
-    static size_t GetComponentId() { return reinterpret_cast<size_t>(#BASETYPE); } \
-    static size_t GetComponentTypeId() { return reinterpret_cast<size_t>(#TYPE); } \
+    static constexpr ComponentKey_t GetComponentKey() { return HashComponentName(#TYPE); } \
+    static size_t GetComponentId() { return size_t(HashComponentName(#BASETYPE)); } \
+    static size_t GetComponentTypeId() { return size_t(HashComponentName(#TYPE)); } \
     static const char* GetComponentName() { return #TYPE; } \
     size_t Id() override { return TYPE::GetComponentId(); } \
     size_t TypeId() override { return TYPE::GetComponentTypeId(); } \
@@ -333,6 +577,7 @@ using ComponentFactory = std::function<Component* (EntityId_t, EntitySet&)>;
 struct ComponentInfo
 {
     size_t Id = 0;
+    ComponentKey_t Key = 0;
     const char* Name = nullptr;
     ComponentFactory Factory = nullptr;
     bool Unique = false;
@@ -340,17 +585,26 @@ struct ComponentInfo
 
 namespace ComponentManager
 {
-    void Register(size_t typeId, const char* name, ComponentFactory factory, bool unquie);
+    /// <summary>
+    /// Register a component type under its table id and its persistent key
+    /// Fails if a different type name already has the same key
+    /// </summary>
+    bool Register(size_t typeId, ComponentKey_t key, const char* name, ComponentFactory factory, bool unquie);
 
     const std::map<size_t, ComponentInfo>& GetComponentList();
 
+    // every registered type by key, including base types that share a table id with a derived type
+    const ComponentInfo* FindComponentInfo(ComponentKey_t key);
+    const ComponentInfo* FindComponentInfo(const char* typeName);
+
     Component* Create(size_t typeId, EntityId_t entityId, EntitySet& manager);
     Component* Create(const char* typeName, EntityId_t entityId, EntitySet& manager);
+    Component* CreateFromKey(ComponentKey_t key, EntityId_t entityId, EntitySet& manager);
 
     template<class T>
-    inline void Register(bool unique = true)
+    inline bool Register(bool unique = true)
     {
-        Register(T::GetComponentId(), T::GetComponentName(), T::Factory, unique);
+        return Register(T::GetComponentId(), T::GetComponentKey(), T::GetComponentName(), T::Factory, unique);
     }
 
     template<class T>
@@ -0,0 +1,269 @@
+/**********************************************************************************************
+*
+*   raylib_ECS_sample * a sample Entity Component System using raylib
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+
+#include "frame_stats.h"
+
+#include <algorithm>
+#include <stdio.h>
+
+namespace FrameStats
+{
+    // 0.1ms buckets, anything past the last bucket uses the exact max
+    constexpr double BucketMs = 0.1;
+    constexpr size_t BucketCount = 2000;
+
+    class PhaseHistory
+    {
+    public:
+        void Add(double ms)
+        {
+            if (Samples.size() == WindowSize)
+            {
+                double old = Samples[Next];
+                Buckets[GetBucket(old)]--;
+                Total -= old;
+                Samples[Next] = ms;
+            }
+            else
+            {
+                Samples.push_back(ms);
+            }
+
+            Next = (Next + 1) % WindowSize;
+            Buckets[GetBucket(ms)]++;
+            Total += ms;
+        }
+
+        Percentiles Get() const
+        {
+            Percentiles result;
+            if (Samples.empty())
+                return result;
+
+            result.Max = *std::max_element(Samples.begin(), Samples.end());
+            result.Mean = Total / Samples.size();
+            result.P50 = GetPercentile(0.50, result.Max);
+            result.P95 = GetPercentile(0.95, result.Max);
+            result.P99 = GetPercentile(0.99, result.Max);
+            return result;
+        }
+
+        // oldest first
+        double GetSample(size_t index) const
+        {
+            if (Samples.size() < WindowSize)
+                return Samples[index];
+
+            return Samples[(Next + index) % WindowSize];
+        }
+
+        size_t GetCount() const { return Samples.size(); }
+
+    private:
+        static size_t GetBucket(double ms)
+        {
+            return std::min((size_t)(std::max(ms, 0.0) / BucketMs), BucketCount);
+        }
+
+        double GetPercentile(double percentile, double max) const
+        {
+            size_t target = std::max<size_t>((size_t)(percentile * Samples.size() + 0.5), 1);
+            size_t count = 0;
+            for (size_t i = 0; i < BucketCount; i++)
+            {
+                count += Buckets[i];
+                if (count >= target)
+                    return std::min((i + 1) * BucketMs, max);
+            }
+            return max;
+        }
+
+        std::vector<double> Samples;
+        size_t Next = 0;
+        uint32_t Buckets[BucketCount + 1] = { 0 };
+        double Total = 0;
+    };
+
+    PhaseHistory Phases[PhaseCount];
+    double CurrentPhaseMs[PhaseCount] = { 0 };
+
+    std::deque<Hitch> Hitches;
+    double HitchThresholdMs = 33.3;
+
+    uint64_t FrameStart = 0;
+    uint64_t FrameCount = 0;
+
+    const char* GetPhaseName(FramePhase phase)
+    {
+        switch (phase)
+        {
+        case FramePhase::Frame:     return "Frame";
+        case FramePhase::Update:    return "Update";
+        case FramePhase::Systems:   return "Systems";
+        case FramePhase::Render:    return "Render";
+        case FramePhase::UI:        return "UI";
+        case FramePhase::Present:   return "Present";
+        default:                    return "Unknown";
+        }
+    }
+
+    void BeginFrame()
+    {
+        FrameStart = Profiler::Now();
+        std::fill(CurrentPhaseMs, CurrentPhaseMs + PhaseCount, 0.0);
+    }
+
+    void EndFrame()
+    {
+        if (FrameStart == 0)
+            return;
+
+        CurrentPhaseMs[(size_t)FramePhase::Frame] = (Profiler::Now() - FrameStart) / 1000000.0;
+        FrameStart = 0;
+
+        for (size_t i = 0; i < PhaseCount; i++)
+            Phases[i].Add(CurrentPhaseMs[i]);
+
+        if (CurrentPhaseMs[(size_t)FramePhase::Frame] > HitchThresholdMs)
+        {
+            if (Hitches.size() >= MaxHitches)
+                Hitches.pop_front();
+
+            Hitches.emplace_back();
+            Hitch& hitch = Hitches.back();
+            hitch.FrameNumber = FrameCount;
+            std::copy(CurrentPhaseMs, CurrentPhaseMs + PhaseCount, hitch.PhaseMs);
+
+            // the frame mark comes just before this, so the newest profiler frame is this one unless the profiler is paused and kept an old one
+            const std::deque<Profiler::FrameRecord>& frames = Profiler::GetFrames();
+            if (!frames.empty() && frames.back().FrameId + 1 == Profiler::GetFrameCount())
+                hitch.Zones = frames.back().Events;
+        }
+
+        FrameCount++;
+    }
+
+    void AddPhaseTime(FramePhase phase, double ms)
+    {
+        if (phase < FramePhase::Count)
+            CurrentPhaseMs[(size_t)phase] += ms;
+    }
+
+    void SetHitchThreshold(double ms)
+    {
+        HitchThresholdMs = ms;
+    }
+
+    double GetHitchThreshold()
+    {
+        return HitchThresholdMs;
+    }
+
+    Percentiles GetPercentiles(FramePhase phase)
+    {
+        if (phase >= FramePhase::Count)
+            return Percentiles();
+
+        return Phases[(size_t)phase].Get();
+    }
+
+    size_t GetSampleCount()
+    {
+        return Phases[(size_t)FramePhase::Frame].GetCount();
+    }
+
+    uint64_t GetFrameCount()
+    {
+        return FrameCount;
+    }
+
+    const std::deque<Hitch>& GetHitches()
+    {
+        return Hitches;
+    }
+
+    void ClearHitches()
+    {
+        Hitches.clear();
+    }
+
+    bool WriteSummaryCSV(const char* fileName)
+    {
+        FILE* fp = fopen(fileName, "w");
+        if (fp == nullptr)
+            return false;
+
+        fprintf(fp, "phase,samples,p50_ms,p95_ms,p99_ms,max_ms,mean_ms\n");
+        for (size_t i = 0; i < PhaseCount; i++)
+        {
+            Percentiles stats = Phases[i].Get();
+            fprintf(fp, "%s,%zu,%.3f,%.3f,%.3f,%.3f,%.3f\n", GetPhaseName((FramePhase)i), Phases[i].GetCount(), stats.P50, stats.P95, stats.P99, stats.Max, stats.Mean);
+        }
+        fprintf(fp, "hitches,%zu,,,,,\n", Hitches.size());
+
+        fclose(fp);
+        return true;
+    }
+
+    bool WriteFramesCSV(const char* fileName)
+    {
+        FILE* fp = fopen(fileName, "w");
+        if (fp == nullptr)
+            return false;
+
+        fprintf(fp, "frame");
+        for (size_t i = 0; i < PhaseCount; i++)
+            fprintf(fp, ",%s_ms", GetPhaseName((FramePhase)i));
+        fprintf(fp, "\n");
+
+        size_t count = GetSampleCount();
+        uint64_t firstFrame = FrameCount - count;
+        for (size_t frame = 0; frame < count; frame++)
+        {
+            fprintf(fp, "%llu", (unsigned long long)(firstFrame + frame));
+            for (size_t i = 0; i < PhaseCount; i++)
+                fprintf(fp, ",%.3f", Phases[i].GetSample(frame));
+            fprintf(fp, "\n");
+        }
+
+        fclose(fp);
+        return true;
+    }
+
+    ScopedPhase::ScopedPhase(FramePhase phase)
+        : Phase(phase)
+        , Start(Profiler::Now())
+    {
+    }
+
+    ScopedPhase::~ScopedPhase()
+    {
+        AddPhaseTime(Phase, (Profiler::Now() - Start) / 1000000.0);
+    }
+}
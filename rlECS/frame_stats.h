@@ -0,0 +1,120 @@
+/**********************************************************************************************
+*
+*   raylib_ECS_sample * a sample Entity Component System using raylib
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+
+#pragma once
+
+#include "profiler.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <deque>
+#include <vector>
+
+// rolling frame time distribution, with the profiler zones of slow frames kept for later
+// main thread only
+namespace FrameStats
+{
+    enum class FramePhase : uint8_t
+    {
+        Frame,      // the whole frame, not counting time spent idle waiting for events
+        Update,
+        Systems,    // ECS work, also counted in the phase it ran in
+        Render,
+        UI,
+        Present,
+        Count,
+    };
+
+    constexpr size_t PhaseCount = (size_t)FramePhase::Count;
+
+    // number of frames the percentiles are computed over
+    constexpr size_t WindowSize = 600;
+    constexpr size_t MaxHitches = 32;
+
+    // percentiles are rounded up to the 0.1ms histogram buckets
+    struct Percentiles
+    {
+        double P50 = 0;
+        double P95 = 0;
+        double P99 = 0;
+        double Max = 0;
+        double Mean = 0;
+    };
+
+    struct Hitch
+    {
+        uint64_t FrameNumber = 0;
+        double PhaseMs[PhaseCount] = { 0 };
+        std::vector<Profiler::Event> Zones;    // empty when the profiler is not built in or is paused
+    };
+
+    const char* GetPhaseName(FramePhase phase);
+
+    void BeginFrame();
+    void EndFrame();
+
+    /// <summary>
+    /// Add time to a phase of the current frame
+    /// </summary>
+    /// <param name="phase">Phase to add to</param>
+    /// <param name="ms">Time in milliseconds</param>
+    void AddPhaseTime(FramePhase phase, double ms);
+
+    void SetHitchThreshold(double ms);
+    double GetHitchThreshold();
+
+    Percentiles GetPercentiles(FramePhase phase);
+    size_t GetSampleCount();
+    uint64_t GetFrameCount();
+
+    const std::deque<Hitch>& GetHitches();
+    void ClearHitches();
+
+    /// <summary>
+    /// Write one row per phase with the percentiles over the current window
+    /// </summary>
+    bool WriteSummaryCSV(const char* fileName);
+
+    /// <summary>
+    /// Write one row per frame in the current window with every phase time
+    /// </summary>
+    bool WriteFramesCSV(const char* fileName);
+
+    class ScopedPhase
+    {
+    public:
+        ScopedPhase(FramePhase phase);
+        ~ScopedPhase();
+
+    private:
+        FramePhase Phase;
+        uint64_t Start = 0;
+    };
+}
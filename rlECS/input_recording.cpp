@@ -0,0 +1,293 @@
+/**********************************************************************************************
+*
+*   raylib_ECS_sample * a sample Entity Component System using raylib
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+#include "input_recording.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+
+// mouse buttons captured each frame, raylib has fewer than this
+constexpr int MaxMouseButtons = 8;
+
+namespace InputLog
+{
+    // "RLIR" followed by a version and the frame count, then each frame as
+    // time, mouse x, mouse y, button bits, key count and the key codes
+    constexpr uint32_t Magic = 0x52494C52;
+    constexpr uint32_t Version = 1;
+
+    bool Save(const char* fileName, const std::vector<InputFrame>& frames)
+    {
+        FILE* fp = fopen(fileName, "wb");
+        if (fp == nullptr)
+            return false;
+
+        uint32_t header[3] = { Magic, Version, (uint32_t)frames.size() };
+        bool ok = fwrite(header, sizeof(header), 1, fp) == 1;
+
+        for (const InputFrame& frame : frames)
+        {
+            if (!ok)
+                break;
+
+            float values[3] = { frame.FrameTime, frame.MousePosition.x, frame.MousePosition.y };
+            uint8_t counts[2] = { frame.MouseButtons, (uint8_t)std::min<size_t>(frame.KeysDown.size(), 255) };
+
+            ok = fwrite(values, sizeof(values), 1, fp) == 1 && fwrite(counts, sizeof(counts), 1, fp) == 1;
+            if (ok && counts[1] > 0)
+                ok = fwrite(frame.KeysDown.data(), sizeof(uint16_t), counts[1], fp) == counts[1];
+        }
+
+        fclose(fp);
+        return ok;
+    }
+
+    bool Load(const char* fileName, std::vector<InputFrame>& frames)
+    {
+        frames.clear();
+
+        FILE* fp = fopen(fileName, "rb");
+        if (fp == nullptr)
+            return false;
+
+        uint32_t header[3] = { 0 };
+        bool ok = fread(header, sizeof(header), 1, fp) == 1 && header[0] == Magic && header[1] == Version;
+
+        if (ok)
+            frames.resize(header[2]);
+
+        for (InputFrame& frame : frames)
+        {
+            if (!ok)
+                break;
+
+            float values[3] = { 0 };
+            uint8_t counts[2] = { 0 };
+
+            ok = fread(values, sizeof(values), 1, fp) == 1 && fread(counts, sizeof(counts), 1, fp) == 1;
+            if (!ok)
+                break;
+
+            frame.FrameTime = values[0];
+            frame.MousePosition = Vector2{ values[1], values[2] };
+            frame.MouseButtons = counts[0];
+            frame.KeysDown.resize(counts[1]);
+            if (counts[1] > 0)
+                ok = fread(frame.KeysDown.data(), sizeof(uint16_t), counts[1], fp) == counts[1];
+        }
+
+        fclose(fp);
+
+        if (!ok)
+            frames.clear();
+
+        return ok;
+    }
+}
+
+// recording
+
+void InputRecorder::Start()
+{
+    if (Recording)
+        return;
+
+    Time = &TimeSource::Get();
+    Input = &InputSource::Get();
+
+    Frames.clear();
+    Now = 0;
+    Recording = true;
+
+    TimeSource::Set(this);
+    InputSource::Set(this);
+}
+
+void InputRecorder::Stop()
+{
+    if (!Recording)
+        return;
+
+    Recording = false;
+
+    TimeSource::Set(Time);
+    InputSource::Set(Input);
+}
+
+void InputRecorder::NextFrame()
+{
+    if (!Recording)
+        return;
+
+    InputFrame frame;
+    frame.FrameTime = Time->GetFrameTime();
+    frame.MousePosition = Input->GetMousePosition();
+    for (int i = 0; i < MaxMouseButtons; i++)
+    {
+        if (Input->IsMouseButtonDown(i))
+            frame.MouseButtons |= (uint8_t)(1 << i);
+    }
+
+    Now += frame.FrameTime;
+    Frames.emplace_back(std::move(frame));
+}
+
+float InputRecorder::GetFrameTime()
+{
+    return Frames.empty() ? Time->GetFrameTime() : Frames.back().FrameTime;
+}
+
+double InputRecorder::GetTime()
+{
+    return Now;
+}
+
+bool InputRecorder::IsKeyDown(int key)
+{
+    if (!Input->IsKeyDown(key))
+        return false;
+
+    if (!Frames.empty())
+    {
+        std::vector<uint16_t>& keys = Frames.back().KeysDown;
+        if (std::find(keys.begin(), keys.end(), (uint16_t)key) == keys.end())
+            keys.push_back((uint16_t)key);
+    }
+
+    return true;
+}
+
+bool InputRecorder::IsMouseButtonDown(int button)
+{
+    if (Frames.empty() || button < 0 || button >= MaxMouseButtons)
+        return Input->IsMouseButtonDown(button);
+
+    return (Frames.back().MouseButtons & (1 << button)) != 0;
+}
+
+Vector2 InputRecorder::GetMousePosition()
+{
+    return Frames.empty() ? Input->GetMousePosition() : Frames.back().MousePosition;
+}
+
+// replay
+
+bool InputReplayer::Load(const char* fileName)
+{
+    return InputLog::Load(fileName, Frames);
+}
+
+void InputReplayer::Start()
+{
+    if (Playing)
+        return;
+
+    Time = &TimeSource::Get();
+    Input = &InputSource::Get();
+
+    FrameIndex = 0;
+    Now = 0;
+    Stepped = false;
+    Playing = true;
+
+    TimeSource::Set(this);
+    InputSource::Set(this);
+}
+
+void InputReplayer::Stop()
+{
+    if (!Playing)
+        return;
+
+    Playing = false;
+
+    TimeSource::Set(Time);
+    InputSource::Set(Input);
+}
+
+bool InputReplayer::NextFrame()
+{
+    if (!Playing)
+        return false;
+
+    // the first call lands on frame 0
+    if (Stepped)
+        FrameIndex++;
+    Stepped = true;
+
+    const InputFrame* frame = GetCurrentFrame();
+    if (frame == nullptr)
+        return false;
+
+    Now += frame->FrameTime;
+    return true;
+}
+
+const InputFrame* InputReplayer::GetCurrentFrame() const
+{
+    if (FrameIndex >= Frames.size())
+        return nullptr;
+
+    return &Frames[FrameIndex];
+}
+
+float InputReplayer::GetFrameTime()
+{
+    const InputFrame* frame = GetCurrentFrame();
+    return frame != nullptr ? frame->FrameTime : 0;
+}
+
+double InputReplayer::GetTime()
+{
+    return Now;
+}
+
+bool InputReplayer::IsKeyDown(int key)
+{
+    const InputFrame* frame = GetCurrentFrame();
+    if (frame == nullptr)
+        return false;
+
+    return std::find(frame->KeysDown.begin(), frame->KeysDown.end(), (uint16_t)key) != frame->KeysDown.end();
+}
+
+bool InputReplayer::IsMouseButtonDown(int button)
+{
+    const InputFrame* frame = GetCurrentFrame();
+    if (frame == nullptr || button < 0 || button >= MaxMouseButtons)
+        return false;
+
+    return (frame->MouseButtons & (1 << button)) != 0;
+}
+
+Vector2 InputReplayer::GetMousePosition()
+{
+    const InputFrame* frame = GetCurrentFrame();
+    return frame != nullptr ? frame->MousePosition : Vector2{ 0, 0 };
+}
@@ -0,0 +1,124 @@
+/**********************************************************************************************
+*
+*   raylib_ECS_sample * a sample Entity Component System using raylib
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+#pragma once
+
+#include "platform_services.h"
+
+#include "raylib.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// the input and time one frame saw, only keys that were down when something asked are kept
+struct InputFrame
+{
+    float FrameTime = 0;
+    Vector2 MousePosition = { 0, 0 };
+    uint8_t MouseButtons = 0;
+    std::vector<uint16_t> KeysDown;
+};
+
+namespace InputLog
+{
+    bool Save(const char* fileName, const std::vector<InputFrame>& frames);
+    bool Load(const char* fileName, std::vector<InputFrame>& frames);
+}
+
+// sits in front of the current time and input sources and writes down everything read through them
+class InputRecorder : public TimeSource, public InputSource
+{
+public:
+    // installs the recorder as the time and input source
+    void Start();
+
+    // puts back the sources that were there before
+    void Stop();
+
+    // call once at the start of every frame, before anything reads input
+    void NextFrame();
+
+    inline bool IsRecording() const { return Recording; }
+    inline const std::vector<InputFrame>& GetFrames() const { return Frames; }
+
+    inline bool Save(const char* fileName) const { return InputLog::Save(fileName, Frames); }
+
+    float GetFrameTime() override;
+    double GetTime() override;
+
+    bool IsKeyDown(int key) override;
+    bool IsMouseButtonDown(int button) override;
+    Vector2 GetMousePosition() override;
+
+protected:
+    TimeSource* Time = nullptr;
+    InputSource* Input = nullptr;
+
+    std::vector<InputFrame> Frames;
+    double Now = 0;
+    bool Recording = false;
+};
+
+// feeds a recorded log back through the time and input sources, one frame at a time
+class InputReplayer : public TimeSource, public InputSource
+{
+public:
+    bool Load(const char* fileName);
+    inline void SetFrames(const std::vector<InputFrame>& frames) { Frames = frames; }
+
+    // installs the replayer as the time and input source, starting from the first frame
+    void Start();
+    void Stop();
+
+    // moves to the next recorded frame, false once the log runs out
+    bool NextFrame();
+
+    inline bool IsPlaying() const { return Playing; }
+    inline size_t GetFrameIndex() const { return FrameIndex; }
+    inline size_t GetFrameCount() const { return Frames.size(); }
+
+    float GetFrameTime() override;
+    double GetTime() override;
+
+    bool IsKeyDown(int key) override;
+    bool IsMouseButtonDown(int button) override;
+    Vector2 GetMousePosition() override;
+
+protected:
+    const InputFrame* GetCurrentFrame() const;
+
+    TimeSource* Time = nullptr;
+    InputSource* Input = nullptr;
+
+    std::vector<InputFrame> Frames;
+    size_t FrameIndex = 0;
+    double Now = 0;
+    bool Stepped = false;
+    bool Playing = false;
+};
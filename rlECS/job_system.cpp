@@ -0,0 +1,238 @@
+/**********************************************************************************************
+*
+*   raylib_ECS_sample * a sample Entity Component System using raylib
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+
+#include "job_system.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+namespace JobSystem
+{
+    thread_local bool IsWorkerThread = false;
+
+    class WorkerPool
+    {
+    public:
+        WorkerPool()
+        {
+            size_t threadCount = std::max<size_t>(std::thread::hardware_concurrency(), 2) - 1;
+            for (size_t i = 0; i < threadCount; i++)
+                Workers.emplace_back([this]() { WorkerLoop(); });
+        }
+
+        ~WorkerPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(Mutex);
+                Quit = true;
+            }
+            WakeWorkers.notify_all();
+
+            for (auto& worker : Workers)
+                worker.join();
+        }
+
+        size_t GetCount() const { return Workers.size() + 1; }
+
+        size_t GetPendingTaskCount() const { return PendingTasks; }
+
+        void SetTaskCompleteCallback(std::function<void()>& callback)
+        {
+            std::lock_guard<std::mutex> lock(Mutex);
+            TaskComplete = std::move(callback);
+        }
+
+        std::future<void> Queue(std::function<void()>& task)
+        {
+            std::packaged_task<void()> job(std::move(task));
+            std::future<void> result = job.get_future();
+            {
+                std::lock_guard<std::mutex> lock(Mutex);
+                Tasks.emplace_back(std::move(job));
+                PendingTasks++;
+            }
+            WakeWorkers.notify_one();
+            return result;
+        }
+
+        void Run(size_t count, std::function<void(size_t)>& func)
+        {
+            // only one batch at a time, callers queue up here
+            std::lock_guard<std::mutex> batchLock(BatchMutex);
+
+            {
+                std::lock_guard<std::mutex> lock(Mutex);
+                BatchFunc = &func;
+                BatchCount = count;
+                NextIndex = 0;
+                Remaining = count;
+                BatchId++;
+            }
+            WakeWorkers.notify_all();
+
+            RunBatchItems();
+
+            std::unique_lock<std::mutex> lock(Mutex);
+            BatchDone.wait(lock, [this]() { return Remaining == 0 && ActiveWorkers == 0; });
+            BatchFunc = nullptr;
+        }
+
+    private:
+        void RunBatchItems()
+        {
+            while (true)
+            {
+                size_t index = NextIndex.fetch_add(1);
+                if (index >= BatchCount)
+                    return;
+
+                (*BatchFunc)(index);
+
+                if (Remaining.fetch_sub(1) == 1)
+                {
+                    std::lock_guard<std::mutex> lock(Mutex);
+                    BatchDone.notify_all();
+                }
+            }
+        }
+
+        void WorkerLoop()
+        {
+            IsWorkerThread = true;
+            PROFILE_THREAD("Job Worker");
+            uint64_t lastBatch = 0;
+
+            while (true)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(Mutex);
+                    WakeWorkers.wait(lock, [this, lastBatch]() { return Quit || (BatchFunc != nullptr && BatchId != lastBatch) || !Tasks.empty(); });
+                    if (Quit)
+                        return;
+
+                    // parallel batches have someone waiting on them, so they go before background tasks
+                    if (BatchFunc == nullptr || BatchId == lastBatch)
+                    {
+                        std::packaged_task<void()> task = std::move(Tasks.front());
+                        Tasks.pop_front();
+                        std::function<void()> onComplete = TaskComplete;
+                        lock.unlock();
+
+                        {
+                            PROFILE_SCOPE("JobSystem::Task");
+                            task();
+                        }
+
+                        PendingTasks--;
+                        if (onComplete)
+                            onComplete();
+                        continue;
+                    }
+
+                    lastBatch = BatchId;
+                    ActiveWorkers++;
+                }
+
+                RunBatchItems();
+
+                std::lock_guard<std::mutex> lock(Mutex);
+                ActiveWorkers--;
+                BatchDone.notify_all();
+            }
+        }
+
+        std::vector<std::thread> Workers;
+
+        std::mutex BatchMutex;
+        std::mutex Mutex;
+        std::condition_variable WakeWorkers;
+        std::condition_variable BatchDone;
+
+        std::deque<std::packaged_task<void()>> Tasks;
+        std::atomic<size_t> PendingTasks = 0;
+        std::function<void()> TaskComplete;
+
+        std::function<void(size_t)>* BatchFunc = nullptr;
+        size_t BatchCount = 0;
+        uint64_t BatchId = 0;
+        size_t ActiveWorkers = 0;
+        std::atomic<size_t> NextIndex = 0;
+        std::atomic<size_t> Remaining = 0;
+        bool Quit = false;
+    };
+
+    WorkerPool& GetPool()
+    {
+        static WorkerPool pool;
+        return pool;
+    }
+
+    size_t GetWorkerCount()
+    {
+        return GetPool().GetCount();
+    }
+
+    void ParallelFor(size_t count, std::function<void(size_t index)> func)
+    {
+        if (count == 0 || func == nullptr)
+            return;
+
+        // small batches and nested calls from inside a job just run inline
+        if (count == 1 || IsWorkerThread)
+        {
+            for (size_t i = 0; i < count; i++)
+                func(i);
+            return;
+        }
+
+        GetPool().Run(count, func);
+    }
+
+    std::future<void> Submit(std::function<void()> task)
+    {
+        return GetPool().Queue(task);
+    }
+
+    size_t GetPendingTaskCount()
+    {
+        return GetPool().GetPendingTaskCount();
+    }
+
+    void SetTaskCompleteCallback(std::function<void()> callback)
+    {
+        GetPool().SetTaskCompleteCallback(callback);
+    }
+}
@@ -0,0 +1,68 @@
+/**********************************************************************************************
+*
+*   raylib_ECS_sample * a sample Entity Component System using raylib
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+
+#pragma once
+
+#include <stddef.h>
+#include <functional>
+#include <future>
+
+// a small pool of worker threads for splitting up CPU side work
+namespace JobSystem
+{
+    /// <summary>
+    /// Number of threads that run jobs, including the calling thread
+    /// </summary>
+    size_t GetWorkerCount();
+
+    /// <summary>
+    /// Run a function for each index in [0, count) spread over the worker threads, returns when all indexes are done
+    /// </summary>
+    /// <param name="count">Number of indexes to run</param>
+    /// <param name="func">Callback run once for every index, may be called from any thread</param>
+    void ParallelFor(size_t count, std::function<void(size_t index)> func);
+
+    /// <summary>
+    /// Queue a function to run on a worker thread in the background
+    /// </summary>
+    /// <param name="task">Callback to run</param>
+    /// <returns>A future that is ready when the task has finished</returns>
+    std::future<void> Submit(std::function<void()> task);
+
+    /// <summary>
+    /// Number of submitted tasks that are queued or running
+    /// </summary>
+    size_t GetPendingTaskCount();
+
+    /// <summary>
+    /// Set a function to be called every time a submitted task finishes, so a thread waiting on something else can be woken up
+    /// </summary>
+    /// <param name="callback">Callback to run, called from the worker thread that ran the task</param>
+    void SetTaskCompleteCallback(std::function<void()> callback);
+}
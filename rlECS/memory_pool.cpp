@@ -0,0 +1,111 @@
+/**********************************************************************************************
+*
+*   raylib_ECS_sample * a sample Entity Component System using raylib
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+#include "memory_pool.h"
+
+#include <mutex>
+#include <new>
+#include <stdint.h>
+
+namespace MemoryPool
+{
+    // sizes are rounded up to a multiple of this, a type's alignment divides its size so every block stays aligned for what fits in it
+    static constexpr size_t Granularity = 8;
+    static constexpr size_t ClassCount = MaxPooledSize / Granularity;
+    static constexpr size_t SlabSize = 1024 * 1024;
+
+    struct FreeBlock
+    {
+        FreeBlock* Next = nullptr;
+    };
+
+    struct SizeClass
+    {
+        std::mutex Lock;
+        FreeBlock* FreeList = nullptr;
+        uint8_t* Next = nullptr;
+        size_t Remaining = 0;
+    };
+
+    // never destroyed, static objects holding components can still free them at exit
+    static SizeClass* GetClasses()
+    {
+        static SizeClass* classes = new SizeClass[ClassCount];
+        return classes;
+    }
+
+    void* Allocate(size_t size)
+    {
+        if (size > MaxPooledSize)
+            return ::operator new(size);
+
+        size_t index = size > 0 ? (size - 1) / Granularity : 0;
+        size_t blockSize = (index + 1) * Granularity;
+
+        SizeClass& sizeClass = GetClasses()[index];
+        std::lock_guard<std::mutex> lock(sizeClass.Lock);
+
+        if (sizeClass.FreeList != nullptr)
+        {
+            FreeBlock* block = sizeClass.FreeList;
+            sizeClass.FreeList = block->Next;
+            return block;
+        }
+
+        // the end of the old slab too small for a block is left unused
+        if (sizeClass.Remaining < blockSize)
+        {
+            sizeClass.Next = static_cast<uint8_t*>(::operator new(SlabSize));
+            sizeClass.Remaining = SlabSize;
+        }
+
+        void* block = sizeClass.Next;
+        sizeClass.Next += blockSize;
+        sizeClass.Remaining -= blockSize;
+        return block;
+    }
+
+    void Free(void* block, size_t size)
+    {
+        if (block == nullptr)
+            return;
+
+        if (size > MaxPooledSize)
+        {
+            ::operator delete(block);
+            return;
+        }
+
+        SizeClass& sizeClass = GetClasses()[size > 0 ? (size - 1) / Granularity : 0];
+        std::lock_guard<std::mutex> lock(sizeClass.Lock);
+
+        FreeBlock* freed = static_cast<FreeBlock*>(block);
+        freed->Next = sizeClass.FreeList;
+        sizeClass.FreeList = freed;
+    }
+}
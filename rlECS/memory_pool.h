@@ -0,0 +1,64 @@
+/**********************************************************************************************
+*
+*   raylib_ECS_sample * a sample Entity Component System using raylib
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+
+// blocks of a few fixed sizes carved out of big slabs, for the millions of small objects a large scene is made of
+// freed blocks go back on a list for the next allocation of the same size, slabs are kept for reuse and never given back
+namespace MemoryPool
+{
+    // anything bigger goes straight to the heap
+    constexpr size_t MaxPooledSize = 512;
+
+    void* Allocate(size_t size);
+    void Free(void* block, size_t size);
+}
+
+// puts the nodes of a std::map or std::set in the pool, the pool is shared so every instance is equal
+template<class T>
+class PoolAllocator
+{
+public:
+    using value_type = T;
+
+    PoolAllocator() = default;
+
+    template<class U>
+    PoolAllocator(const PoolAllocator<U>&) {}
+
+    inline T* allocate(size_t count) { return static_cast<T*>(MemoryPool::Allocate(count * sizeof(T))); }
+    inline void deallocate(T* block, size_t count) { MemoryPool::Free(block, count * sizeof(T)); }
+
+    template<class U>
+    inline bool operator==(const PoolAllocator<U>&) const { return true; }
+
+    template<class U>
+    inline bool operator!=(const PoolAllocator<U>&) const { return false; }
+};
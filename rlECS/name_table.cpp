@@ -0,0 +1,119 @@
+/**********************************************************************************************
+*
+*   raylib_ECS_sample * a sample Entity Component System using raylib
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+#include "name_table.h"
+
+NameTable::NameTable()
+{
+    // the empty name is always there and never released
+    Names.emplace_back();
+    References.push_back(1);
+}
+
+NameId_t NameTable::Intern(std::string_view name)
+{
+    if (name.empty())
+        return EmptyName;
+
+    auto itr = Index.find(name);
+    if (itr != Index.end())
+    {
+        References[itr->second]++;
+        return itr->second;
+    }
+
+    NameId_t id = InvalidName;
+    if (!FreeIds.empty())
+    {
+        id = FreeIds.back();
+        FreeIds.pop_back();
+        Names[id] = name;
+        References[id] = 1;
+    }
+    else
+    {
+        id = NameId_t(Names.size());
+        Names.emplace_back(name);
+        References.push_back(1);
+    }
+
+    Index.emplace(std::string_view(Names[id]), id);
+    return id;
+}
+
+void NameTable::Release(NameId_t id)
+{
+    if (id == EmptyName || id >= Names.size() || References[id] == 0)
+        return;
+
+    if (--References[id] > 0)
+        return;
+
+    Index.erase(std::string_view(Names[id]));
+    Names[id].clear();
+    Names[id].shrink_to_fit();
+    FreeIds.push_back(id);
+}
+
+NameId_t NameTable::Find(std::string_view name) const
+{
+    if (name.empty())
+        return EmptyName;
+
+    auto itr = Index.find(name);
+    if (itr == Index.end())
+        return InvalidName;
+
+    return itr->second;
+}
+
+void SplitNameSuffix(std::string_view name, std::string_view& baseName, int& suffix)
+{
+    baseName = name;
+    suffix = 0;
+
+    if (name.size() < 4 || name.back() != ')')
+        return;
+
+    size_t open = name.rfind(" (");
+    if (open == std::string_view::npos || open + 3 > name.size() - 1)
+        return;
+
+    int value = 0;
+    for (size_t i = open + 2; i < name.size() - 1; i++)
+    {
+        char c = name[i];
+        if (c < '0' || c > '9' || value > 100000000)
+            return;
+
+        value = value * 10 + (c - '0');
+    }
+
+    baseName = name.substr(0, open);
+    suffix = value;
+}
@@ -0,0 +1,72 @@
+/**********************************************************************************************
+*
+*   raylib_ECS_sample * a sample Entity Component System using raylib
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+#pragma once
+
+#include <deque>
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using NameId_t = uint32_t;
+constexpr NameId_t EmptyName = 0;
+constexpr NameId_t InvalidName = NameId_t(-1);
+
+// every distinct name is stored once and referred to by id, ids of released names get reused
+class NameTable
+{
+public:
+    NameTable();
+
+    /// <summary>
+    /// Get the id for a name, adding it if it's new
+    /// Each call holds a reference that must be given back with Release
+    /// </summary>
+    NameId_t Intern(std::string_view name);
+    void Release(NameId_t id);
+
+    // the id of a name that's already in the table, InvalidName if it isn't
+    NameId_t Find(std::string_view name) const;
+
+    inline const char* Get(NameId_t id) const { return id < Names.size() ? Names[id].c_str() : ""; }
+
+    inline size_t GetCount() const { return Index.size(); }
+
+private:
+    // a deque so the strings never move, the index points into them
+    std::deque<std::string> Names;
+    std::vector<uint32_t> References;
+    std::vector<NameId_t> FreeIds;
+
+    std::unordered_map<std::string_view, NameId_t> Index;
+};
+
+// splits "Base (3)" into "Base" and 3, names without a number give back the whole name and 0
+void SplitNameSuffix(std::string_view name, std::string_view& baseName, int& suffix);
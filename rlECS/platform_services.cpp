@@ -0,0 +1,107 @@
+/**********************************************************************************************
+*
+*   raylib_ECS_sample * a sample Entity Component System using raylib
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+#include "platform_services.h"
+
+#include "raylib.h"
+
+// headless builds never open a window, so they step time by hand and see no input
+#ifdef RLECS_HEADLESS
+static FixedTimeSource DefaultTime;
+static NullInputSource DefaultInput;
+#else
+static RaylibTimeSource DefaultTime;
+static RaylibInputSource DefaultInput;
+#endif
+
+static TimeSource* CurrentTime = &DefaultTime;
+static InputSource* CurrentInput = &DefaultInput;
+
+TimeSource& TimeSource::Get()
+{
+    return *CurrentTime;
+}
+
+void TimeSource::Set(TimeSource* source)
+{
+    CurrentTime = source != nullptr ? source : &DefaultTime;
+}
+
+InputSource& InputSource::Get()
+{
+    return *CurrentInput;
+}
+
+void InputSource::Set(InputSource* source)
+{
+    CurrentInput = source != nullptr ? source : &DefaultInput;
+}
+
+#ifndef RLECS_HEADLESS
+
+// raylib
+
+void RaylibTimeSource::BeginFrame()
+{
+    double now = ::GetTime();
+    FrameTime = (FrameStart < 0 || Waited) ? NominalFrameTime : float(now - FrameStart);
+    FrameStart = now;
+    Waited = false;
+}
+
+float RaylibTimeSource::GetFrameTime()
+{
+    return FrameTime;
+}
+
+double RaylibTimeSource::GetTime()
+{
+    return ::GetTime();
+}
+
+RaylibTimeSource& RaylibTimeSource::GetDefault()
+{
+    return DefaultTime;
+}
+
+bool RaylibInputSource::IsKeyDown(int key)
+{
+    return ::IsKeyDown(key);
+}
+
+bool RaylibInputSource::IsMouseButtonDown(int button)
+{
+    return ::IsMouseButtonDown(button);
+}
+
+Vector2 RaylibInputSource::GetMousePosition()
+{
+    return ::GetMousePosition();
+}
+
+#endif
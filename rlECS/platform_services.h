@@ -0,0 +1,125 @@
+/**********************************************************************************************
+*
+*   raylib_ECS_sample * a sample Entity Component System using raylib
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+#pragma once
+
+#include "raylib.h"
+
+// where the ECS gets its frame time from, so simulations can run at a fixed step with no window
+class TimeSource
+{
+public:
+    virtual ~TimeSource() = default;
+
+    virtual float GetFrameTime() = 0;
+    virtual double GetTime() = 0;
+
+    // the time source all updates use, raylib unless something else was set
+    static TimeSource& Get();
+
+    // the source must outlive its use, nullptr goes back to the default
+    static void Set(TimeSource* source);
+};
+
+// where the ECS reads keys and the mouse from, so input can be scripted or replayed
+class InputSource
+{
+public:
+    virtual ~InputSource() = default;
+
+    virtual bool IsKeyDown(int key) = 0;
+    virtual bool IsMouseButtonDown(int button) = 0;
+    virtual Vector2 GetMousePosition() = 0;
+
+    // the input source all controllers use, raylib unless something else was set
+    static InputSource& Get();
+
+    // the source must outlive its use, nullptr goes back to the default
+    static void Set(InputSource* source);
+};
+
+// the same delta every frame, time only moves when the owner steps it
+class FixedTimeSource : public TimeSource
+{
+public:
+    float Step = 1.0f / 60.0f;
+
+    inline void Advance() { Now += Step; }
+    inline void Reset() { Now = 0; }
+
+    inline float GetFrameTime() override { return Step; }
+    inline double GetTime() override { return Now; }
+
+protected:
+    double Now = 0;
+};
+
+// nothing is ever pressed
+class NullInputSource : public InputSource
+{
+public:
+    inline bool IsKeyDown(int) override { return false; }
+    inline bool IsMouseButtonDown(int) override { return false; }
+    inline Vector2 GetMousePosition() override { return Vector2{ 0, 0 }; }
+};
+
+#ifndef RLECS_HEADLESS
+// reads the window's clock and input from raylib
+// the frame time is measured from one BeginFrame to the next, so a wait for window events can be left out of it
+class RaylibTimeSource : public TimeSource
+{
+public:
+    // what the first frame and a frame after a wait report
+    float NominalFrameTime = 1.0f / 60.0f;
+
+    // call once at the start of every frame, before anything reads the frame time
+    void BeginFrame();
+
+    // the loop waited for events since the last frame, the next frame reports NominalFrameTime instead of the wait
+    inline void SkipWait() { Waited = true; }
+
+    float GetFrameTime() override;
+    double GetTime() override;
+
+    // the one used when no other time source was set
+    static RaylibTimeSource& GetDefault();
+
+private:
+    double FrameStart = -1;
+    float FrameTime = 0;
+    bool Waited = false;
+};
+
+class RaylibInputSource : public InputSource
+{
+public:
+    bool IsKeyDown(int key) override;
+    bool IsMouseButtonDown(int button) override;
+    Vector2 GetMousePosition() override;
+};
+#endif
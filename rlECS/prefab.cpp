@@ -0,0 +1,421 @@
+/**********************************************************************************************
+*
+*   raylib_ECS_sample * a sample Entity Component System using raylib
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+
+#include "prefab.h"
+#include "components/prefab_instance_component.h"
+
+#include <algorithm>
+#include <string.h>
+
+size_t PrefabTemplate::GetMemoryUsed() const
+{
+    size_t size = sizeof(*this) + Entities.capacity() * sizeof(EntityRecord) + Components.capacity() * sizeof(ComponentRecord) + Data.capacity();
+    for (const EntityRecord& entity : Entities)
+        size += entity.Name.capacity();
+    return size;
+}
+
+// the instance entity for each template entity, InvalidEntityId under any entity whose children no longer match the template
+static void MapInstance(EntitySet& entities, const PrefabTemplate& prefab, EntityId_t root, std::vector<EntityId_t>& ids)
+{
+    ids.assign(prefab.Entities.size(), InvalidEntityId);
+    ids[0] = root;
+
+    // parents come before their children, so each one is mapped before it is looked at
+    for (size_t i = 0; i < prefab.Entities.size(); i++)
+    {
+        if (ids[i] == InvalidEntityId)
+            continue;
+
+        const PrefabTemplate::EntityRecord& record = prefab.Entities[i];
+        Entity* entity = entities.GetEntity(ids[i]);
+        if (entity == nullptr || entity->Children.size() != record.ChildCount)
+            continue;
+
+        for (uint32_t child = 0; child < record.ChildCount; child++)
+            ids[record.FirstChild + child] = entity->Children[child];
+    }
+}
+
+// copy a packed template record into a live component, leaving the fields in keepMask alone
+static void WriteRecord(const FieldTable& table, const uint8_t* record, Component* component, uint64_t keepMask)
+{
+    uint8_t* object = reinterpret_cast<uint8_t*>(component);
+    for (size_t i = 0; i < table.Count; i++)
+    {
+        const FieldInfo& field = table.Fields[i];
+        if (!Reflection::IsFieldInMask(keepMask, i))
+            memcpy(object + field.Offset, record, field.Size);
+        record += field.Size;
+    }
+    component->OnFieldsChanged();
+}
+
+static void UpdateInstanceOverrides(EntitySet& entities, const PrefabTemplate& prefab, PrefabInstanceComponent* instance, std::vector<EntityId_t>& ids)
+{
+    instance->Overrides.clear();
+    instance->OverrideData.clear();
+
+    MapInstance(entities, prefab, instance->EntityId, ids);
+
+    for (size_t i = 0; i < prefab.Components.size(); i++)
+    {
+        const PrefabTemplate::ComponentRecord& record = prefab.Components[i];
+        Component* component = Reflection::FindComponent(entities, record.ComponentId, record.TypeId, ids[record.Entity], record.Index);
+        if (component == nullptr)
+            continue;
+
+        const FieldTable* table = component->GetFieldTable();
+        if (table == nullptr || table->DataSize != record.DataSize)
+            continue;
+
+        uint64_t mask = Reflection::DiffRecord(*table, prefab.Data.data() + record.DataOffset, component);
+        if (mask == 0)
+            continue;
+
+        PrefabInstanceComponent::Override entry;
+        entry.Record = uint32_t(i);
+        entry.Mask = mask;
+        entry.DataOffset = uint32_t(instance->OverrideData.size());
+
+        const uint8_t* object = reinterpret_cast<const uint8_t*>(component);
+        for (size_t field = 0; field < table->Count; field++)
+        {
+            if (!Reflection::IsFieldInMask(mask, field))
+                continue;
+
+            const FieldInfo& info = table->Fields[field];
+            instance->OverrideData.insert(instance->OverrideData.end(), object + info.Offset, object + info.Offset + info.Size);
+        }
+        entry.DataSize = uint32_t(instance->OverrideData.size() - entry.DataOffset);
+
+        instance->Overrides.push_back(entry);
+    }
+
+    // instances that match the template give their space back
+    instance->Overrides.shrink_to_fit();
+    instance->OverrideData.shrink_to_fit();
+}
+
+bool Prefab::Capture(EntitySet& entities, EntityId_t root)
+{
+    if (entities.GetEntity(root) == nullptr)
+        return false;
+
+    std::shared_ptr<PrefabTemplate> prefab = std::make_shared<PrefabTemplate>();
+
+    std::vector<EntityId_t> ids = { root };
+    prefab->Entities.emplace_back();
+
+    for (size_t i = 0; i < ids.size(); i++)
+    {
+        Entity* entity = entities.GetEntity(ids[i]);
+
+        PrefabTemplate::EntityRecord& record = prefab->Entities[i];
+        record.Name = entities.GetEntityName(ids[i]);
+        record.FirstChild = uint32_t(ids.size());
+        record.ChildCount = uint32_t(entity->Children.size());
+
+        for (EntityId_t child : entity->Children)
+        {
+            ids.push_back(child);
+
+            PrefabTemplate::EntityRecord childRecord;
+            childRecord.Parent = uint32_t(i);
+            prefab->Entities.push_back(childRecord);
+        }
+
+        size_t firstComponent = prefab->Components.size();
+        entities.DoForEachComponentInEntity(ids[i], [&prefab, i, firstComponent](Component* component)
+            {
+                // nested prefabs are flattened into this one
+                if (component->Id() == PrefabInstanceComponent::GetComponentId())
+                    return;
+
+                PrefabTemplate::ComponentRecord record;
+                record.Entity = uint32_t(i);
+                record.ComponentId = component->Id();
+                record.TypeId = component->TypeId();
+                record.Key = HashComponentName(component->ComponentName());
+                record.Active = component->Active;
+                record.DataOffset = prefab->Data.size();
+                record.DataSize = component->GetDataSize();
+
+                for (size_t other = firstComponent; other < prefab->Components.size(); other++)
+                {
+                    if (prefab->Components[other].TypeId == record.TypeId)
+                        record.Index++;
+                }
+
+                prefab->Data.resize(prefab->Data.size() + record.DataSize);
+                if (record.DataSize > 0)
+                    component->SaveData(prefab->Data.data() + record.DataOffset);
+
+                prefab->Components.push_back(record);
+            });
+    }
+
+    std::stable_sort(prefab->Components.begin(), prefab->Components.end(),
+        [](const PrefabTemplate::ComponentRecord& a, const PrefabTemplate::ComponentRecord& b) { return a.ComponentId < b.ComponentId; });
+
+    prefab->Entities.shrink_to_fit();
+    prefab->Components.shrink_to_fit();
+    prefab->Data.shrink_to_fit();
+
+    Template = prefab;
+    return true;
+}
+
+EntityId_t Prefab::Instantiate(EntitySet& entities, EntityId_t parent)
+{
+    std::vector<EntityId_t> roots;
+    if (InstantiateBatch(entities, 1, parent, &roots) == 0)
+        return InvalidEntityId;
+
+    return roots.front();
+}
+
+size_t Prefab::InstantiateBatch(EntitySet& entities, size_t count, EntityId_t parent, std::vector<EntityId_t>* roots)
+{
+    if (Template == nullptr || count == 0)
+        return 0;
+
+    if (parent != InvalidEntityId && entities.GetEntity(parent) == nullptr)
+        return 0;
+
+    const PrefabTemplate& prefab = *Template;
+    const size_t entityCount = prefab.Entities.size();
+
+    // every id in the range is above the ones in use, so the entities and components below are all appends
+    EntityId_t firstId = entities.ReserveEntityIds(count * entityCount);
+
+    std::vector<EntityId_t> children;
+    for (size_t instance = 0; instance < count; instance++)
+    {
+        EntityId_t baseId = firstId + instance * entityCount;
+
+        for (size_t i = 0; i < entityCount; i++)
+        {
+            const PrefabTemplate::EntityRecord& record = prefab.Entities[i];
+
+            children.clear();
+            for (uint32_t child = 0; child < record.ChildCount; child++)
+                children.push_back(baseId + record.FirstChild + child);
+
+            EntityId_t entityParent = record.Parent == PrefabTemplate::NoParent ? InvalidEntityId : baseId + record.Parent;
+            entities.LoadEntity(baseId + i, entityParent, children.data(), children.size());
+        }
+
+        if (parent != InvalidEntityId)
+            entities.ReparentEntity(baseId, parent);
+
+        for (size_t i = 0; i < entityCount; i++)
+        {
+            if (!prefab.Entities[i].Name.empty())
+                entities.SetEntityName(baseId + i, prefab.Entities[i].Name.c_str());
+        }
+
+        if (roots != nullptr)
+            roots->push_back(baseId);
+    }
+
+    std::vector<const ComponentInfo*> types(prefab.Components.size());
+    for (size_t i = 0; i < prefab.Components.size(); i++)
+        types[i] = ComponentManager::FindComponentInfo(prefab.Components[i].Key);
+
+    // one table at a time, instance by instance, keeps the ids in each table in order
+    std::vector<Component*> batch;
+    for (size_t first = 0; first < prefab.Components.size();)
+    {
+        size_t componentId = prefab.Components[first].ComponentId;
+        size_t last = first;
+        while (last < prefab.Components.size() && prefab.Components[last].ComponentId == componentId)
+            last++;
+
+        batch.clear();
+        batch.reserve(count * (last - first));
+
+        for (size_t instance = 0; instance < count; instance++)
+        {
+            EntityId_t baseId = firstId + instance * entityCount;
+            for (size_t i = first; i < last; i++)
+            {
+                if (types[i] == nullptr)
+                    continue;
+
+                const PrefabTemplate::ComponentRecord& record = prefab.Components[i];
+                Component* component = types[i]->Factory(baseId + record.Entity, entities);
+                component->Active = record.Active;
+                if (record.DataSize > 0)
+                    component->LoadData(prefab.Data.data() + record.DataOffset);
+
+                batch.push_back(component);
+            }
+        }
+
+        entities.LoadComponents(componentId, batch.data(), batch.size());
+        first = last;
+    }
+
+    batch.clear();
+    for (size_t instance = 0; instance < count; instance++)
+    {
+        PrefabInstanceComponent* component = PrefabInstanceComponent::Factory(firstId + instance * entityCount, entities);
+        component->Source = Template;
+        batch.push_back(component);
+    }
+    entities.LoadComponents(PrefabInstanceComponent::GetComponentId(), batch.data(), batch.size());
+
+    return count;
+}
+
+size_t Prefab::UpdateOverrides(EntitySet& entities)
+{
+    if (Template == nullptr)
+        return 0;
+
+    size_t bytes = 0;
+    std::vector<EntityId_t> ids;
+    entities.DoForEachEntity<PrefabInstanceComponent>([this, &entities, &ids, &bytes](PrefabInstanceComponent* instance)
+        {
+            if (instance->Source != Template)
+                return;
+
+            UpdateInstanceOverrides(entities, *Template, instance, ids);
+            bytes += instance->Overrides.capacity() * sizeof(PrefabInstanceComponent::Override) + instance->OverrideData.capacity();
+        });
+
+    return bytes;
+}
+
+bool Prefab::Apply(EntitySet& entities, EntityId_t root)
+{
+    std::shared_ptr<const PrefabTemplate> oldTemplate = Template;
+    if (!Capture(entities, root))
+        return false;
+
+    if (oldTemplate == nullptr)
+        return true;
+
+    const PrefabTemplate& oldPrefab = *oldTemplate;
+    const PrefabTemplate& newPrefab = *Template;
+
+    // instances are mapped with the new tree, so ones made from a template with a different tree keep the old one
+    bool sameTree = oldPrefab.Entities.size() == newPrefab.Entities.size();
+    for (size_t i = 0; sameTree && i < newPrefab.Entities.size(); i++)
+        sameTree = oldPrefab.Entities[i].ChildCount == newPrefab.Entities[i].ChildCount;
+
+    if (!sameTree)
+        return true;
+
+    // the old record for each new one, by entity, type and place on the entity
+    std::vector<size_t> oldRecords(newPrefab.Components.size(), size_t(-1));
+    for (size_t i = 0; i < newPrefab.Components.size(); i++)
+    {
+        const PrefabTemplate::ComponentRecord& record = newPrefab.Components[i];
+        for (size_t j = 0; j < oldPrefab.Components.size(); j++)
+        {
+            const PrefabTemplate::ComponentRecord& oldRecord = oldPrefab.Components[j];
+            if (oldRecord.Entity == record.Entity && oldRecord.TypeId == record.TypeId && oldRecord.Index == record.Index)
+            {
+                oldRecords[i] = j;
+                break;
+            }
+        }
+    }
+
+    std::vector<uint64_t> keepMasks;
+    std::vector<EntityId_t> ids;
+    entities.DoForEachEntity<PrefabInstanceComponent>([&](PrefabInstanceComponent* instance)
+        {
+            if (instance->Source != oldTemplate)
+                return;
+
+            if (instance->EntityId != root)
+            {
+                UpdateInstanceOverrides(entities, oldPrefab, instance, ids);
+
+                keepMasks.assign(oldPrefab.Components.size(), 0);
+                for (const PrefabInstanceComponent::Override& entry : instance->Overrides)
+                    keepMasks[entry.Record] = entry.Mask;
+
+                for (size_t i = 0; i < newPrefab.Components.size(); i++)
+                {
+                    const PrefabTemplate::ComponentRecord& record = newPrefab.Components[i];
+                    Component* component = Reflection::FindComponent(entities, record.ComponentId, record.TypeId, ids[record.Entity], record.Index);
+                    if (component == nullptr)
+                        continue;
+
+                    const FieldTable* table = component->GetFieldTable();
+                    if (table == nullptr || table->DataSize != record.DataSize)
+                        continue;
+
+                    uint64_t keepMask = oldRecords[i] != size_t(-1) ? keepMasks[oldRecords[i]] : 0;
+                    WriteRecord(*table, newPrefab.Data.data() + record.DataOffset, component, keepMask);
+                    entities.MarkComponentChanged(component);
+                }
+            }
+
+            instance->Source = Template;
+            UpdateInstanceOverrides(entities, newPrefab, instance, ids);
+        });
+
+    entities.MarkChanged();
+    return true;
+}
+
+void Prefab::Revert(EntitySet& entities, EntityId_t instanceRoot)
+{
+    PrefabInstanceComponent* instance = entities.GetComponent<PrefabInstanceComponent>(instanceRoot);
+    if (instance == nullptr || instance->Source == nullptr)
+        return;
+
+    const PrefabTemplate& prefab = *instance->Source;
+
+    std::vector<EntityId_t> ids;
+    MapInstance(entities, prefab, instanceRoot, ids);
+
+    for (const PrefabTemplate::ComponentRecord& record : prefab.Components)
+    {
+        Component* component = Reflection::FindComponent(entities, record.ComponentId, record.TypeId, ids[record.Entity], record.Index);
+        if (component == nullptr || record.DataSize == 0 || component->GetDataSize() != record.DataSize)
+            continue;
+
+        component->LoadData(prefab.Data.data() + record.DataOffset);
+        component->Active = record.Active;
+        entities.MarkComponentChanged(component);
+    }
+
+    instance->Overrides.clear();
+    instance->Overrides.shrink_to_fit();
+    instance->OverrideData.clear();
+    instance->OverrideData.shrink_to_fit();
+
+    entities.MarkChanged();
+}
@@ -0,0 +1,123 @@
+/**********************************************************************************************
+*
+*   raylib_ECS_sample * a sample Entity Component System using raylib
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+
+#pragma once
+
+#include "entity_manager.h"
+
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// the read only part of a prefab, every instance points at the same one
+struct PrefabTemplate
+{
+    static constexpr uint32_t NoParent = uint32_t(-1);
+
+    struct EntityRecord
+    {
+        uint32_t Parent = NoParent;
+        uint32_t FirstChild = 0;
+        uint32_t ChildCount = 0;
+        std::string Name;
+    };
+
+    struct ComponentRecord
+    {
+        uint32_t Entity = 0;
+        uint32_t Index = 0;             // among the components of the same type on the entity
+        size_t ComponentId = 0;
+        size_t TypeId = 0;
+        ComponentKey_t Key = 0;
+        bool Active = true;
+        size_t DataOffset = 0;
+        size_t DataSize = 0;
+    };
+
+    // breadth first, so the root is first and the children of each entity are next to each other
+    std::vector<EntityRecord> Entities;
+
+    // grouped by table and in entity order inside each, so every table is filled with one bulk load
+    std::vector<ComponentRecord> Components;
+    std::vector<uint8_t> Data;
+
+    size_t GetMemoryUsed() const;
+};
+
+/// <summary>
+/// An entity subtree kept as a template that can be spawned many times
+/// Spawning is batched: the ids are taken as one range and each table is filled with one bulk load of copies of the template data
+/// Every instance is a full copy of the template components, its root only notes which fields differ from the template (its overrides)
+/// </summary>
+class Prefab
+{
+public:
+    /// <summary>
+    /// Make the template from an entity and everything under it
+    /// </summary>
+    /// <returns>False if the entity does not exist</returns>
+    bool Capture(EntitySet& entities, EntityId_t root);
+
+    EntityId_t Instantiate(EntitySet& entities, EntityId_t parent = InvalidEntityId);
+
+    /// <summary>
+    /// Spawn a number of instances in one batch
+    /// </summary>
+    /// <param name="parent">The entity the instances go under, InvalidEntityId for the root</param>
+    /// <param name="roots">Optional list that gets the root of each instance</param>
+    /// <returns>The number of instances made</returns>
+    size_t InstantiateBatch(EntitySet& entities, size_t count, EntityId_t parent = InvalidEntityId, std::vector<EntityId_t>* roots = nullptr);
+
+    /// <summary>
+    /// Note the fields each instance changed from the template, instances that still match it hold nothing
+    /// </summary>
+    /// <returns>The bytes held by overrides across all instances</returns>
+    size_t UpdateOverrides(EntitySet& entities);
+
+    /// <summary>
+    /// Replace the template with an entity subtree, usually an edited instance
+    /// Every instance takes the new values for the fields it did not override
+    /// Only field values are pushed to instances, added or removed entities and components are not
+    /// </summary>
+    bool Apply(EntitySet& entities, EntityId_t root);
+
+    // put the template values back into an instance and drop its overrides
+    void Revert(EntitySet& entities, EntityId_t instanceRoot);
+
+    inline bool IsValid() const { return Template != nullptr; }
+    inline const std::shared_ptr<const PrefabTemplate>& GetTemplate() const { return Template; }
+
+    inline size_t GetEntityCount() const { return Template != nullptr ? Template->Entities.size() : 0; }
+    inline size_t GetComponentCount() const { return Template != nullptr ? Template->Components.size() : 0; }
+
+private:
+    std::shared_ptr<const PrefabTemplate> Template;
+};
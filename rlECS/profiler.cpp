@@ -0,0 +1,284 @@
+/**********************************************************************************************
+*
+*   raylib_ECS_sample * a sample Entity Component System using raylib
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+
+#include "profiler.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <stdio.h>
+
+namespace Profiler
+{
+    // each thread writes into its own ring, only the main thread reads them when a frame is marked
+    constexpr uint32_t ThreadBufferSize = 1 << 14;
+
+    struct ThreadBuffer
+    {
+        uint16_t Index = 0;
+        std::string Name;
+
+        std::vector<Event> Events;
+        std::atomic<uint32_t> Head = 0;
+        std::atomic<uint32_t> Tail = 0;
+    };
+
+    std::mutex ThreadListMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> ThreadBuffers;
+
+    thread_local ThreadBuffer* CurrentThreadBuffer = nullptr;
+    thread_local uint16_t CurrentDepth = 0;
+
+    std::atomic<bool> Paused = false;
+    std::atomic<size_t> DroppedEvents = 0;
+
+    std::deque<FrameRecord> Frames;
+    uint64_t FrameCount = 0;
+    uint64_t LastFrameMark = 0;
+
+    uint64_t Now()
+    {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    ThreadBuffer& GetThreadBuffer()
+    {
+        if (CurrentThreadBuffer != nullptr)
+            return *CurrentThreadBuffer;
+
+        std::lock_guard<std::mutex> lock(ThreadListMutex);
+        ThreadBuffers.emplace_back(std::make_unique<ThreadBuffer>());
+
+        CurrentThreadBuffer = ThreadBuffers.back().get();
+        CurrentThreadBuffer->Index = (uint16_t)(ThreadBuffers.size() - 1);
+        CurrentThreadBuffer->Name = "Thread " + std::to_string(CurrentThreadBuffer->Index);
+        CurrentThreadBuffer->Events.resize(ThreadBufferSize);
+
+        return *CurrentThreadBuffer;
+    }
+
+    void PushEvent(const Event& event)
+    {
+        if (Paused.load(std::memory_order_relaxed))
+            return;
+
+        ThreadBuffer& buffer = GetThreadBuffer();
+
+        uint32_t head = buffer.Head.load(std::memory_order_relaxed);
+        if (head - buffer.Tail.load(std::memory_order_acquire) >= ThreadBufferSize)
+        {
+            DroppedEvents.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        Event& slot = buffer.Events[head & (ThreadBufferSize - 1)];
+        slot = event;
+        slot.Thread = buffer.Index;
+
+        buffer.Head.store(head + 1, std::memory_order_release);
+    }
+
+    void RecordZone(const char* name, uint64_t start, uint64_t end, uint16_t depth)
+    {
+        Event event;
+        event.Name = name;
+        event.Start = start;
+        event.End = end;
+        event.Depth = depth;
+        event.Type = EventType::Zone;
+        PushEvent(event);
+    }
+
+    void RecordCounter(const char* name, double value)
+    {
+        Event event;
+        event.Name = name;
+        event.Start = event.End = Now();
+        event.Value = value;
+        event.Type = EventType::Counter;
+        PushEvent(event);
+    }
+
+    void SetThreadName(const char* name)
+    {
+        ThreadBuffer& buffer = GetThreadBuffer();
+
+        std::lock_guard<std::mutex> lock(ThreadListMutex);
+        buffer.Name = name;
+    }
+
+    void MarkFrame()
+    {
+        uint64_t now = Now();
+        if (LastFrameMark == 0)
+            LastFrameMark = now;
+
+        FrameRecord frame;
+        frame.FrameId = FrameCount++;
+        frame.Start = LastFrameMark;
+        frame.End = now;
+        LastFrameMark = now;
+
+        bool paused = Paused.load(std::memory_order_relaxed);
+
+        // reuse the storage from the frame that is about to fall out of the history
+        if (!paused && Frames.size() >= MaxFrameHistory)
+        {
+            frame.Events = std::move(Frames.front().Events);
+            frame.Events.clear();
+            Frames.pop_front();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(ThreadListMutex);
+            for (auto& buffer : ThreadBuffers)
+            {
+                uint32_t head = buffer->Head.load(std::memory_order_acquire);
+                uint32_t tail = buffer->Tail.load(std::memory_order_relaxed);
+
+                if (!paused)
+                {
+                    for (uint32_t i = tail; i != head; i++)
+                        frame.Events.push_back(buffer->Events[i & (ThreadBufferSize - 1)]);
+                }
+
+                buffer->Tail.store(head, std::memory_order_release);
+            }
+        }
+
+        if (!paused)
+            Frames.emplace_back(std::move(frame));
+    }
+
+    void SetPaused(bool paused)
+    {
+        Paused = paused;
+    }
+
+    bool IsPaused()
+    {
+        return Paused;
+    }
+
+    const std::deque<FrameRecord>& GetFrames()
+    {
+        return Frames;
+    }
+
+    uint64_t GetFrameCount()
+    {
+        return FrameCount;
+    }
+
+    std::vector<ThreadInfo> GetThreads()
+    {
+        std::vector<ThreadInfo> threads;
+
+        std::lock_guard<std::mutex> lock(ThreadListMutex);
+        for (auto& buffer : ThreadBuffers)
+            threads.push_back(ThreadInfo{ buffer->Index, buffer->Name });
+
+        return threads;
+    }
+
+    size_t GetDroppedEvents()
+    {
+        return DroppedEvents;
+    }
+
+    void WriteJSONString(FILE* fp, const char* text)
+    {
+        fputc('"', fp);
+        for (const char* c = text; c != nullptr && *c != '\0'; c++)
+        {
+            if (*c == '"' || *c == '\\')
+                fputc('\\', fp);
+
+            if ((unsigned char)*c >= 0x20)
+                fputc(*c, fp);
+        }
+        fputc('"', fp);
+    }
+
+    bool ExportChromeTrace(const char* fileName)
+    {
+        FILE* fp = fopen(fileName, "w");
+        if (fp == nullptr)
+            return false;
+
+        uint64_t origin = Frames.empty() ? 0 : Frames.front().Start;
+        auto toMicroseconds = [origin](uint64_t time) { return (int64_t)(time - origin) / 1000.0; };
+
+        fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+        bool first = true;
+        for (const ThreadInfo& thread : GetThreads())
+        {
+            fprintf(fp, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":", first ? "" : ",\n", thread.Index);
+            WriteJSONString(fp, thread.Name.c_str());
+            fprintf(fp, "}}");
+            first = false;
+        }
+
+        for (const FrameRecord& frame : Frames)
+        {
+            fprintf(fp, "%s{\"name\":\"Frame %llu\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":0,\"ts\":%.3f}", first ? "" : ",\n", (unsigned long long)frame.FrameId, toMicroseconds(frame.Start));
+            first = false;
+
+            for (const Event& event : frame.Events)
+            {
+                fprintf(fp, ",\n{\"name\":");
+                WriteJSONString(fp, event.Name);
+
+                if (event.Type == EventType::Zone)
+                    fprintf(fp, ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", event.Thread, toMicroseconds(event.Start), (event.End - event.Start) / 1000.0);
+                else
+                    fprintf(fp, ",\"ph\":\"C\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"args\":{\"value\":%g}}", event.Thread, toMicroseconds(event.Start), event.Value);
+            }
+        }
+
+        fprintf(fp, "\n]}\n");
+        fclose(fp);
+        return true;
+    }
+
+    ScopedZone::ScopedZone(const char* name)
+        : Name(name)
+        , Start(Now())
+        , Depth(CurrentDepth++)
+    {
+    }
+
+    ScopedZone::~ScopedZone()
+    {
+        CurrentDepth--;
+        RecordZone(Name, Start, Now(), Depth);
+    }
+}
@@ -0,0 +1,155 @@
+/**********************************************************************************************
+*
+*   raylib_ECS_sample * a sample Entity Component System using raylib
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <chrono>
+#include <deque>
+#include <string>
+#include <vector>
+
+// CPU profiler, instrumentation macros only do anything when RLECS_PROFILER is defined
+namespace Profiler
+{
+    enum class EventType : uint8_t
+    {
+        Zone,
+        Counter,
+    };
+
+    struct Event
+    {
+        const char* Name = nullptr;     // must be a string literal or otherwise live forever
+        uint64_t Start = 0;             // nanoseconds, counters only use the start
+        uint64_t End = 0;
+        double Value = 0;
+        uint16_t Thread = 0;
+        uint16_t Depth = 0;
+        EventType Type = EventType::Zone;
+
+        inline double GetMilliseconds() const { return (End - Start) / 1000000.0; }
+    };
+
+    struct FrameRecord
+    {
+        uint64_t FrameId = 0;
+        uint64_t Start = 0;
+        uint64_t End = 0;
+        std::vector<Event> Events;
+
+        inline double GetMilliseconds() const { return (End - Start) / 1000000.0; }
+    };
+
+    struct ThreadInfo
+    {
+        uint16_t Index = 0;
+        std::string Name;
+    };
+
+    constexpr size_t MaxFrameHistory = 300;
+
+    /// <summary>
+    /// Current profiler time in nanoseconds
+    /// </summary>
+    uint64_t Now();
+
+    /// <summary>
+    /// Milliseconds from start until now, for the timings the systems report in their stats
+    /// </summary>
+    inline double MillisecondsSince(const std::chrono::high_resolution_clock::time_point& start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    void RecordZone(const char* name, uint64_t start, uint64_t end, uint16_t depth);
+    void RecordCounter(const char* name, double value);
+    void SetThreadName(const char* name);
+
+    /// <summary>
+    /// End the current frame, collects the events from every thread into the frame history. Call from the main thread only
+    /// </summary>
+    void MarkFrame();
+
+    void SetPaused(bool paused);
+    bool IsPaused();
+
+    /// <summary>
+    /// The last MaxFrameHistory frames, oldest first. Main thread only
+    /// </summary>
+    const std::deque<FrameRecord>& GetFrames();
+
+    /// <summary>
+    /// Number of frames marked, paused or not. The newest frame has id GetFrameCount() - 1 unless it was marked while paused
+    /// </summary>
+    uint64_t GetFrameCount();
+
+    std::vector<ThreadInfo> GetThreads();
+
+    /// <summary>
+    /// Number of events lost because a thread filled its buffer before the frame was collected
+    /// </summary>
+    size_t GetDroppedEvents();
+
+    /// <summary>
+    /// Write the frame history as Chrome trace_event JSON (chrome://tracing, Perfetto)
+    /// </summary>
+    /// <param name="fileName">File to write</param>
+    /// <returns>True if the file was written</returns>
+    bool ExportChromeTrace(const char* fileName);
+
+    class ScopedZone
+    {
+    public:
+        ScopedZone(const char* name);
+        ~ScopedZone();
+
+    private:
+        const char* Name = nullptr;
+        uint64_t Start = 0;
+        uint16_t Depth = 0;
+    };
+}
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#ifdef RLECS_PROFILER
+#define PROFILE_SCOPE(name) Profiler::ScopedZone PROFILE_CONCAT(_profileZone, __LINE__)(name)
+#define PROFILE_COUNTER(name, value) Profiler::RecordCounter(name, (double)(value))
+#define PROFILE_THREAD(name) Profiler::SetThreadName(name)
+#define PROFILE_FRAME_MARK() Profiler::MarkFrame()
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_COUNTER(name, value)
+#define PROFILE_THREAD(name)
+#define PROFILE_FRAME_MARK()
+#endif
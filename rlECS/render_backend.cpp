@@ -0,0 +1,373 @@
+/**********************************************************************************************
+*
+*   raylib_ECS_sample * a sample Entity Component System using raylib
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+
+#include "render_backend.h"
+#include "profiler.h"
+
+#include "raylib.h"
+#include "rlgl.h"
+
+#ifndef RL_MAX_SHADER_LOCATIONS
+#define RL_MAX_SHADER_LOCATIONS 32
+#endif
+
+#ifdef RLECS_HEADLESS
+// there is no GPU to draw with, so keep the stats and drop the commands as they come in
+class HeadlessRenderBackend : public RecordingRenderBackend
+{
+public:
+    HeadlessRenderBackend() { KeepCommands = false; }
+};
+
+static HeadlessRenderBackend DefaultBackend;
+#else
+static RaylibRenderBackend DefaultBackend;
+#endif
+static RenderBackend* CurrentBackend = &DefaultBackend;
+
+RenderBackend& RenderBackend::Get()
+{
+    return *CurrentBackend;
+}
+
+void RenderBackend::Set(RenderBackend* backend)
+{
+    CurrentBackend = backend != nullptr ? backend : &DefaultBackend;
+}
+
+#ifndef RLECS_HEADLESS
+
+// raylib
+
+Shader RaylibRenderBackend::LoadShader(const char* vsFileName, const char* fsFileName)
+{
+    PROFILE_SCOPE("RaylibRenderBackend::LoadShader");
+
+    return ::LoadShader(vsFileName, fsFileName);
+}
+
+int RaylibRenderBackend::GetShaderLocation(Shader shader, const char* uniformName)
+{
+    return ::GetShaderLocation(shader, uniformName);
+}
+
+void RaylibRenderBackend::SetShaderValue(Shader shader, int locIndex, const void* value, int uniformType)
+{
+    ::SetShaderValue(shader, locIndex, value, uniformType);
+}
+
+void RaylibRenderBackend::SetShaderValueV(Shader shader, int locIndex, const void* value, int uniformType, int count)
+{
+    ::SetShaderValueV(shader, locIndex, value, uniformType, count);
+}
+
+void RaylibRenderBackend::SetShaderMatrix(Shader shader, int locIndex, const Matrix& matrix)
+{
+    SetShaderValueMatrix(shader, locIndex, matrix);
+}
+
+unsigned int RaylibRenderBackend::LoadDataTexture(const void* data, int width, int height, int format)
+{
+    PROFILE_SCOPE("RaylibRenderBackend::LoadDataTexture");
+
+    return rlLoadTexture(data, width, height, format, 1);
+}
+
+void RaylibRenderBackend::UpdateDataTexture(unsigned int id, const void* data, int width, int height, int format)
+{
+    rlUpdateTexture(id, 0, 0, width, height, format, data);
+}
+
+void RaylibRenderBackend::UnloadDataTexture(unsigned int id)
+{
+    rlUnloadTexture(id);
+}
+
+void RaylibRenderBackend::SetShaderTexture(Shader shader, int locIndex, unsigned int id, int width, int height)
+{
+    Texture2D texture = { id, width, height, 1, 0 };
+    SetShaderValueTexture(shader, locIndex, texture);
+}
+
+void RaylibRenderBackend::BeginMode3D(const Camera3D& camera)
+{
+    ::BeginMode3D(camera);
+}
+
+void RaylibRenderBackend::EndMode3D()
+{
+    ::EndMode3D();
+}
+
+void RaylibRenderBackend::PushMatrix()
+{
+    rlPushMatrix();
+}
+
+void RaylibRenderBackend::PopMatrix()
+{
+    rlPopMatrix();
+}
+
+void RaylibRenderBackend::MultMatrix(const Matrix& glMatrix)
+{
+    rlMultMatrixf((float*)(&glMatrix.m0));
+}
+
+void RaylibRenderBackend::SetBackfaceCulling(bool enabled)
+{
+    if (enabled)
+        rlEnableBackfaceCulling();
+    else
+        rlDisableBackfaceCulling();
+}
+
+void RaylibRenderBackend::Flush()
+{
+    rlDrawRenderBatchActive();
+}
+
+void RaylibRenderBackend::DrawCube(Vector3 position, float width, float height, float length, Color color)
+{
+    ::DrawCube(position, width, height, length, color);
+}
+
+void RaylibRenderBackend::DrawSphere(Vector3 center, float radius, Color color)
+{
+    ::DrawSphere(center, radius, color);
+}
+
+void RaylibRenderBackend::DrawCylinder(Vector3 position, float radiusTop, float radiusBottom, float height, int slices, Color color)
+{
+    ::DrawCylinder(position, radiusTop, radiusBottom, height, slices, color);
+}
+
+void RaylibRenderBackend::DrawPlane(Vector3 center, Vector2 size, Color color)
+{
+    ::DrawPlane(center, size, color);
+}
+
+int RaylibRenderBackend::GetScreenWidth()
+{
+    return ::GetScreenWidth();
+}
+
+int RaylibRenderBackend::GetScreenHeight()
+{
+    return ::GetScreenHeight();
+}
+
+#endif
+
+// recording
+
+void RecordingRenderBackend::Reset()
+{
+    Commands.clear();
+    Stats = RenderStats();
+    BatchVertices = 0;
+}
+
+void RecordingRenderBackend::Record(RenderCommandType type, int value)
+{
+    if (KeepCommands)
+        Commands.push_back(RenderCommand{ type, value });
+}
+
+void RecordingRenderBackend::AddVertices(int count)
+{
+    // raylib submits the batch by itself when it fills up
+    if (BatchVertices + count > BatchVertexLimit)
+        Flush();
+
+    Stats.Shapes++;
+    Stats.Vertices += count;
+    BatchVertices += count;
+    Record(RenderCommandType::Draw, count);
+}
+
+Shader RecordingRenderBackend::LoadShader(const char* vsFileName, const char* fsFileName)
+{
+    // shaders need somewhere to store locations, even if nothing is ever compiled
+    ShaderLocations.emplace_back(new int[RL_MAX_SHADER_LOCATIONS]);
+    for (int i = 0; i < RL_MAX_SHADER_LOCATIONS; i++)
+        ShaderLocations.back()[i] = -1;
+
+    Record(RenderCommandType::LoadShader, 0);
+
+    Shader shader = { 0 };
+    shader.id = (unsigned int)ShaderLocations.size();
+    shader.locs = ShaderLocations.back().get();
+    return shader;
+}
+
+int RecordingRenderBackend::GetShaderLocation(Shader shader, const char* uniformName)
+{
+    // hand out a stable fake location for every uniform name
+    auto itr = Locations.find(uniformName);
+    if (itr != Locations.end())
+        return itr->second;
+
+    int location = (int)Locations.size();
+    Locations[uniformName] = location;
+    return location;
+}
+
+void RecordingRenderBackend::SetShaderValue(Shader shader, int locIndex, const void* value, int uniformType)
+{
+    SetShaderValueV(shader, locIndex, value, uniformType, 1);
+}
+
+void RecordingRenderBackend::SetShaderValueV(Shader shader, int locIndex, const void* value, int uniformType, int count)
+{
+    if (locIndex < 0)
+        return;
+
+    Stats.UniformUploads++;
+    Record(RenderCommandType::SetShaderValue, count);
+}
+
+void RecordingRenderBackend::AddTextureUpload(int width, int height, int format)
+{
+    int bytesPerPixel = 4;
+    if (format == PIXELFORMAT_UNCOMPRESSED_R32G32B32A32)
+        bytesPerPixel = 16;
+
+    Stats.TextureUploads++;
+    Stats.TextureBytes += (size_t)width * height * bytesPerPixel;
+    Record(RenderCommandType::UpdateTexture, width * height * bytesPerPixel);
+}
+
+unsigned int RecordingRenderBackend::LoadDataTexture(const void* data, int width, int height, int format)
+{
+    AddTextureUpload(width, height, format);
+    return NextTextureId++;
+}
+
+void RecordingRenderBackend::UpdateDataTexture(unsigned int id, const void* data, int width, int height, int format)
+{
+    AddTextureUpload(width, height, format);
+}
+
+void RecordingRenderBackend::UnloadDataTexture(unsigned int id)
+{
+}
+
+void RecordingRenderBackend::SetShaderTexture(Shader shader, int locIndex, unsigned int id, int width, int height)
+{
+    if (locIndex < 0)
+        return;
+
+    Stats.UniformUploads++;
+    Record(RenderCommandType::SetShaderValue, 1);
+}
+
+void RecordingRenderBackend::SetShaderMatrix(Shader shader, int locIndex, const Matrix& matrix)
+{
+    SetShaderValueV(shader, locIndex, &matrix, SHADER_UNIFORM_VEC4, 4);
+}
+
+void RecordingRenderBackend::BeginMode3D(const Camera3D& camera)
+{
+    // changing the projection submits anything already batched
+    Flush();
+    Stats.StateChanges++;
+    Stats.MatrixPushes++;
+    Record(RenderCommandType::BeginMode3D, 0);
+}
+
+void RecordingRenderBackend::EndMode3D()
+{
+    Flush();
+    Stats.StateChanges++;
+    Record(RenderCommandType::EndMode3D, 0);
+}
+
+void RecordingRenderBackend::PushMatrix()
+{
+    Stats.MatrixPushes++;
+    Record(RenderCommandType::PushMatrix, 0);
+}
+
+void RecordingRenderBackend::PopMatrix()
+{
+    Record(RenderCommandType::PopMatrix, 0);
+}
+
+void RecordingRenderBackend::MultMatrix(const Matrix& glMatrix)
+{
+    Record(RenderCommandType::MultMatrix, 0);
+}
+
+void RecordingRenderBackend::SetBackfaceCulling(bool enabled)
+{
+    if (enabled == BackfaceCulling)
+        return;
+
+    BackfaceCulling = enabled;
+    Stats.StateChanges++;
+    Record(RenderCommandType::SetBackfaceCulling, enabled ? 1 : 0);
+}
+
+void RecordingRenderBackend::Flush()
+{
+    Stats.Flushes++;
+    if (BatchVertices > 0)
+        Stats.DrawCalls++;
+
+    Record(RenderCommandType::Flush, (int)BatchVertices);
+    BatchVertices = 0;
+}
+
+// vertex counts match what raylib's shape functions push into the batch
+
+void RecordingRenderBackend::DrawCube(Vector3 position, float width, float height, float length, Color color)
+{
+    AddVertices(36);
+}
+
+void RecordingRenderBackend::DrawSphere(Vector3 center, float radius, Color color)
+{
+    // DrawSphere uses 16 rings and 16 slices
+    AddVertices((16 + 2) * 16 * 6);
+}
+
+void RecordingRenderBackend::DrawCylinder(Vector3 position, float radiusTop, float radiusBottom, float height, int slices, Color color)
+{
+    if (slices < 3)
+        slices = 3;
+
+    // sides, top and bottom caps, or a cone and the bottom cap
+    AddVertices(slices * (radiusTop > 0 ? 12 : 6));
+}
+
+void RecordingRenderBackend::DrawPlane(Vector3 center, Vector2 size, Color color)
+{
+    AddVertices(4);
+}
@@ -0,0 +1,216 @@
+/**********************************************************************************************
+*
+*   raylib_ECS_sample * a sample Entity Component System using raylib
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+
+#pragma once
+
+#include "raylib.h"
+
+#include <map>
+#include <memory>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+// the drawing calls the ECS makes, so rendering can be sent somewhere other than raylib
+class RenderBackend
+{
+public:
+    virtual ~RenderBackend() = default;
+
+    virtual Shader LoadShader(const char* vsFileName, const char* fsFileName) = 0;
+    virtual int GetShaderLocation(Shader shader, const char* uniformName) = 0;
+    virtual void SetShaderValue(Shader shader, int locIndex, const void* value, int uniformType) = 0;
+    virtual void SetShaderValueV(Shader shader, int locIndex, const void* value, int uniformType, int count) = 0;
+    virtual void SetShaderMatrix(Shader shader, int locIndex, const Matrix& matrix) = 0;
+
+    // raw float textures for feeding data to shaders, format is a raylib PixelFormat
+    virtual unsigned int LoadDataTexture(const void* data, int width, int height, int format) = 0;
+    virtual void UpdateDataTexture(unsigned int id, const void* data, int width, int height, int format) = 0;
+    virtual void UnloadDataTexture(unsigned int id) = 0;
+    virtual void SetShaderTexture(Shader shader, int locIndex, unsigned int id, int width, int height) = 0;
+
+    virtual void BeginMode3D(const Camera3D& camera) = 0;
+    virtual void EndMode3D() = 0;
+
+    virtual void PushMatrix() = 0;
+    virtual void PopMatrix() = 0;
+    virtual void MultMatrix(const Matrix& glMatrix) = 0;
+
+    virtual void SetBackfaceCulling(bool enabled) = 0;
+    virtual void Flush() = 0;
+
+    virtual void DrawCube(Vector3 position, float width, float height, float length, Color color) = 0;
+    virtual void DrawSphere(Vector3 center, float radius, Color color) = 0;
+    virtual void DrawCylinder(Vector3 position, float radiusTop, float radiusBottom, float height, int slices, Color color) = 0;
+    virtual void DrawPlane(Vector3 center, Vector2 size, Color color) = 0;
+
+    // size of the default framebuffer, used when a view doesn't give its own
+    virtual int GetScreenWidth() = 0;
+    virtual int GetScreenHeight() = 0;
+
+    // the backend all drawing goes to, raylib unless something else was set
+    static RenderBackend& Get();
+
+    // the backend must outlive its use, nullptr goes back to raylib
+    static void Set(RenderBackend* backend);
+};
+
+#ifndef RLECS_HEADLESS
+// sends everything straight to raylib and rlgl
+class RaylibRenderBackend : public RenderBackend
+{
+public:
+    Shader LoadShader(const char* vsFileName, const char* fsFileName) override;
+    int GetShaderLocation(Shader shader, const char* uniformName) override;
+    void SetShaderValue(Shader shader, int locIndex, const void* value, int uniformType) override;
+    void SetShaderValueV(Shader shader, int locIndex, const void* value, int uniformType, int count) override;
+    void SetShaderMatrix(Shader shader, int locIndex, const Matrix& matrix) override;
+
+    unsigned int LoadDataTexture(const void* data, int width, int height, int format) override;
+    void UpdateDataTexture(unsigned int id, const void* data, int width, int height, int format) override;
+    void UnloadDataTexture(unsigned int id) override;
+    void SetShaderTexture(Shader shader, int locIndex, unsigned int id, int width, int height) override;
+
+    void BeginMode3D(const Camera3D& camera) override;
+    void EndMode3D() override;
+
+    void PushMatrix() override;
+    void PopMatrix() override;
+    void MultMatrix(const Matrix& glMatrix) override;
+
+    void SetBackfaceCulling(bool enabled) override;
+    void Flush() override;
+
+    void DrawCube(Vector3 position, float width, float height, float length, Color color) override;
+    void DrawSphere(Vector3 center, float radius, Color color) override;
+    void DrawCylinder(Vector3 position, float radiusTop, float radiusBottom, float height, int slices, Color color) override;
+    void DrawPlane(Vector3 center, Vector2 size, Color color) override;
+
+    int GetScreenWidth() override;
+    int GetScreenHeight() override;
+};
+#endif
+
+enum class RenderCommandType
+{
+    LoadShader,
+    SetShaderValue,
+    UpdateTexture,
+    BeginMode3D,
+    EndMode3D,
+    PushMatrix,
+    PopMatrix,
+    MultMatrix,
+    SetBackfaceCulling,
+    Flush,
+    Draw,
+};
+
+struct RenderCommand
+{
+    RenderCommandType Type = RenderCommandType::Draw;
+    int Value = 0;      // vertices for draws and flushes, uniform count for shader values, bytes for textures, on/off for state
+};
+
+struct RenderStats
+{
+    size_t Shapes = 0;
+    size_t DrawCalls = 0;
+    size_t Vertices = 0;
+    size_t StateChanges = 0;
+    size_t MatrixPushes = 0;
+    size_t Flushes = 0;
+    size_t UniformUploads = 0;
+    size_t TextureUploads = 0;
+    size_t TextureBytes = 0;
+};
+
+// makes no GL calls, just logs what would have been drawn, so the render path can run without a GPU
+class RecordingRenderBackend : public RenderBackend
+{
+public:
+    // vertices raylib's default batch holds before it has to flush on its own
+    size_t BatchVertexLimit = 8192 * 4;
+
+    // turn off to only keep the stats
+    bool KeepCommands = true;
+
+    // the framebuffer size reported to anything that asks
+    int ScreenWidth = 1280;
+    int ScreenHeight = 720;
+
+    void Reset();
+
+    inline const std::vector<RenderCommand>& GetCommands() const { return Commands; }
+    inline const RenderStats& GetStats() const { return Stats; }
+
+    Shader LoadShader(const char* vsFileName, const char* fsFileName) override;
+    int GetShaderLocation(Shader shader, const char* uniformName) override;
+    void SetShaderValue(Shader shader, int locIndex, const void* value, int uniformType) override;
+    void SetShaderValueV(Shader shader, int locIndex, const void* value, int uniformType, int count) override;
+    void SetShaderMatrix(Shader shader, int locIndex, const Matrix& matrix) override;
+
+    unsigned int LoadDataTexture(const void* data, int width, int height, int format) override;
+    void UpdateDataTexture(unsigned int id, const void* data, int width, int height, int format) override;
+    void UnloadDataTexture(unsigned int id) override;
+    void SetShaderTexture(Shader shader, int locIndex, unsigned int id, int width, int height) override;
+
+    void BeginMode3D(const Camera3D& camera) override;
+    void EndMode3D() override;
+
+    void PushMatrix() override;
+    void PopMatrix() override;
+    void MultMatrix(const Matrix& glMatrix) override;
+
+    void SetBackfaceCulling(bool enabled) override;
+    void Flush() override;
+
+    void DrawCube(Vector3 position, float width, float height, float length, Color color) override;
+    void DrawSphere(Vector3 center, float radius, Color color) override;
+    void DrawCylinder(Vector3 position, float radiusTop, float radiusBottom, float height, int slices, Color color) override;
+    void DrawPlane(Vector3 center, Vector2 size, Color color) override;
+
+    inline int GetScreenWidth() override { return ScreenWidth; }
+    inline int GetScreenHeight() override { return ScreenHeight; }
+
+private:
+    void Record(RenderCommandType type, int value);
+    void AddTextureUpload(int width, int height, int format);
+    void AddVertices(int count);
+
+    std::vector<RenderCommand> Commands;
+    RenderStats Stats;
+
+    size_t BatchVertices = 0;
+    bool BackfaceCulling = true;
+
+    std::map<std::string, int> Locations;
+    std::vector<std::unique_ptr<int[]>> ShaderLocations;
+    unsigned int NextTextureId = 1;
+};
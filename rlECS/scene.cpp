@@ -47,7 +47,7 @@ void SceneData::SetupEditorBaseScene()
    // 
    // editor camera
     TransformComponent* camera = Entities.AddComponent<TransformComponent>();
-    camera->GetEntity().Name = "Editor Camera";
+    Entities.SetEntityName(camera->EntityId, "Editor Camera");
     camera->AddComponent<CameraComponent>();
     camera->AddComponent<FlightDataComponent>();
     camera->SetPosition(0, 1.5f, -3);
@@ -59,9 +59,12 @@ void SceneData::SetupEditorBaseScene()
 
     // create a light
     auto* light = Entities.AddComponent<LightComponent>();
-    light->GetEntity().Name = "Default Light";
+    Entities.SetEntityName(light->EntityId, "Default Light");
     auto* lightTransform = light->MustGetComponent<TransformComponent>();
     lightTransform->SetPosition(10, 10, 10);
+
+    // far enough to reach the whole default scene from its corner
+    light->Range = 50;
     lightTransform->MustGetComponent<ShapeComponent>()->ObjectShape = DrawShape::Sphere;
 }
 
@@ -71,7 +74,7 @@ void SceneData::SetupDefaultEntities()
     // 
     // basic entity
     TransformComponent* testEntity = Entities.AddComponent<TransformComponent>();
-    testEntity->GetEntity().Name = "Test Entity";
+    Entities.SetEntityName(testEntity->EntityId, "Test Entity");
     testEntity->SetPosition(0, 0.5f, 0);
 
     // give it some geometry
@@ -85,11 +88,30 @@ void SceneData::SetupDefaultEntities()
 
     // child
     TransformComponent* child = testEntity->AddChildComponent<TransformComponent>();
-    child->GetEntity().Name = "Child";
+    Entities.SetEntityName(child->EntityId, "Child");
     child->SetPosition(0, 1.0f, 0);
     // body
     drawable = Entities.AddComponent<ShapeComponent>(child);
     drawable->ObjectColor = DARKBLUE;
     drawable->ObjectShape = DrawShape::Sphere;
     drawable->ObjectSize = Vector3{ 0.5f,0.5f,0.5f };
-}
\ No newline at end of file
+}
+
+void SceneData::Play()
+{
+    if (Run)
+        return;
+
+    PlaySnapshot.ExcludeEntitiesWith<EditorHiddenComponent>();
+    PlaySnapshot.Capture(Entities);
+    Run = true;
+}
+
+void SceneData::Stop()
+{
+    if (!Run)
+        return;
+
+    Run = false;
+    PlaySnapshot.Restore(Entities);
+}
@@ -30,6 +30,7 @@
 
 #include "entity_manager.h"
 #include "system_manager.h"
+#include "world_snapshot.h"
 
 class SceneData
 {
@@ -39,9 +40,18 @@ public:
     EntitySet Entities;
     SystemSet Systems;
 
+    // the scene as it was when play started, put back by Stop
+    WorldSnapshot PlaySnapshot;
+
     SceneData() : Systems(Entities) {}
 
     void SetupEditorBaseScene();
 
     void SetupDefaultEntities();
+
+    // start running the simulation, keeping a copy of the scene to go back to
+    void Play();
+
+    // stop the simulation and undo everything it changed, editor only entities keep their state
+    void Stop();
 };
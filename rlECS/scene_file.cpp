@@ -0,0 +1,1286 @@
+/**********************************************************************************************
+*
+*   raylib_ECS_sample * a sample Entity Component System using raylib
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+#include "scene_file.h"
+#include "job_system.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <stdio.h>
+#include <string.h>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace SceneFile
+{
+    // a read only view of a whole file
+    class MappedFile
+    {
+    public:
+        ~MappedFile() { Close(); }
+
+        bool Open(const char* fileName);
+        void Close();
+
+        const uint8_t* Data = nullptr;
+        size_t Size = 0;
+
+    private:
+#ifdef _WIN32
+        HANDLE File = INVALID_HANDLE_VALUE;
+        HANDLE Mapping = nullptr;
+#else
+        int File = -1;
+#endif
+    };
+
+#ifdef _WIN32
+    bool MappedFile::Open(const char* fileName)
+    {
+        File = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (File == INVALID_HANDLE_VALUE)
+            return false;
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(File, &size) || size.QuadPart == 0)
+            return false;
+
+        Mapping = CreateFileMappingA(File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (Mapping == nullptr)
+            return false;
+
+        Data = static_cast<const uint8_t*>(MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0));
+        Size = size_t(size.QuadPart);
+        return Data != nullptr;
+    }
+
+    void MappedFile::Close()
+    {
+        if (Data != nullptr)
+            UnmapViewOfFile(Data);
+        if (Mapping != nullptr)
+            CloseHandle(Mapping);
+        if (File != INVALID_HANDLE_VALUE)
+            CloseHandle(File);
+
+        Data = nullptr;
+        Size = 0;
+        Mapping = nullptr;
+        File = INVALID_HANDLE_VALUE;
+    }
+#else
+    bool MappedFile::Open(const char* fileName)
+    {
+        File = open(fileName, O_RDONLY);
+        if (File < 0)
+            return false;
+
+        struct stat info;
+        if (fstat(File, &info) != 0 || info.st_size == 0)
+            return false;
+
+        int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+        // every page gets read, fault them all in up front
+        flags |= MAP_POPULATE;
+#endif
+        void* data = mmap(nullptr, size_t(info.st_size), PROT_READ, flags, File, 0);
+        if (data == MAP_FAILED)
+            return false;
+
+        madvise(data, size_t(info.st_size), MADV_SEQUENTIAL);
+
+        Data = static_cast<const uint8_t*>(data);
+        Size = size_t(info.st_size);
+        return true;
+    }
+
+    void MappedFile::Close()
+    {
+        if (Data != nullptr)
+            munmap(const_cast<uint8_t*>(Data), Size);
+        if (File >= 0)
+            close(File);
+
+        Data = nullptr;
+        Size = 0;
+        File = -1;
+    }
+#endif
+
+    // saving
+
+    // fseek takes a long, which is 32 bits on Windows, and appends go past 2GB in big scenes
+    static bool SeekFile(FILE* file, uint64_t position)
+    {
+#ifdef _WIN32
+        return _fseeki64(file, __int64(position), SEEK_SET) == 0;
+#else
+        return fseeko(file, off_t(position), SEEK_SET) == 0;
+#endif
+    }
+
+    // writes through a file handle, keeping track of where it is so sections can be aligned
+    class FileWriter
+    {
+    public:
+        ~FileWriter() { Close(); }
+
+        bool Open(const char* fileName, bool append, uint64_t size)
+        {
+            File = fopen(fileName, append ? "r+b" : "wb");
+            if (File == nullptr)
+                return false;
+
+            Position = append ? size : 0;
+            return SeekFile(File, Position);
+        }
+
+        bool Close()
+        {
+            if (File == nullptr)
+                return Ok;
+
+            Ok = fclose(File) == 0 && Ok;
+            File = nullptr;
+            return Ok;
+        }
+
+        inline uint64_t Align()
+        {
+            static const uint8_t zeros[SectionAlignment] = { 0 };
+            size_t padding = size_t((SectionAlignment - (Position % SectionAlignment)) % SectionAlignment);
+            Write(zeros, padding);
+            return Position;
+        }
+
+        inline void Write(const void* data, size_t size)
+        {
+            if (size == 0 || !Ok)
+                return;
+
+            Ok = fwrite(data, 1, size, File) == size;
+            Position += size;
+            Written += size;
+        }
+
+        template<class T>
+        inline uint64_t WriteArray(const T* values, size_t count)
+        {
+            uint64_t offset = Align();
+            Write(values, sizeof(T) * count);
+            return offset;
+        }
+
+        // the header goes in last, once everything it points at is written
+        inline void WriteHeader(const Header& header)
+        {
+            if (!Ok)
+                return;
+
+            Ok = fflush(File) == 0 && SeekFile(File, 0) && fwrite(&header, sizeof(Header), 1, File) == 1 && fflush(File) == 0;
+        }
+
+        FILE* File = nullptr;
+        uint64_t Position = 0;
+        uint64_t Written = 0;
+        bool Ok = true;
+    };
+
+    // the parts of the file each section covers, from its first array to the end of its last
+    inline uint64_t GetExtent(const EntityChunkHeader& chunk) { return chunk.NamesOffset + chunk.NamesSize - chunk.EntitiesOffset; }
+    inline uint64_t GetExtent(const BlockHeader& block) { return block.DataOffset + block.Count * block.DataSize - block.EntitiesOffset; }
+
+    // what a save copied out of the set, only the chunks that changed
+    struct IncrementalSaver::Capture
+    {
+        struct EntityChunk
+        {
+            uint64_t Chunk = 0;
+            std::vector<EntityRecord> Records;
+            std::vector<EntityId_t> Children;
+            std::vector<char> Names;
+        };
+
+        struct Block
+        {
+            size_t TableId = 0;
+            uint64_t Chunk = 0;
+            size_t TypeId = 0;
+            const char* TypeName = nullptr;
+            size_t DataSize = 0;
+            std::vector<EntityId_t> Entities;
+            std::vector<uint8_t> Active;
+            std::vector<uint8_t> Data;
+        };
+
+        uint64_t Stamp = 0;
+        bool Full = false;                  // nothing is kept from the file
+
+        // every changed chunk is listed, even ones that are now empty, so the old copies are dropped
+        std::vector<uint64_t> ChangedEntityChunks;
+        std::vector<std::pair<size_t, uint64_t>> ChangedTableChunks;
+
+        std::vector<EntityChunk> EntityChunks;
+        std::vector<Block> Blocks;
+    };
+
+    IncrementalSaver::IncrementalSaver(const char* fileName)
+        : FileName(fileName != nullptr ? fileName : "")
+    {
+    }
+
+    IncrementalSaver::~IncrementalSaver()
+    {
+        FinishSave();
+    }
+
+    std::unique_ptr<IncrementalSaver::Capture> IncrementalSaver::TakeCapture(EntitySet& entities)
+    {
+        PROFILE_SCOPE("SceneFile::Capture");
+
+        std::unique_ptr<Capture> capture = std::make_unique<Capture>();
+        capture->Stamp = entities.GetLastChunkStamp();
+        capture->Full = !HasFile;
+
+        // every chunk was stamped when something was put in it, so stamps after 0 are all of them
+        entities.DoForEachChangedChunk(capture->Full ? 0 : SavedStamp, [&capture](size_t tableId, uint64_t chunk)
+            {
+                if (tableId == EntityChunkTable)
+                    capture->ChangedEntityChunks.push_back(chunk);
+                else
+                    capture->ChangedTableChunks.emplace_back(tableId, chunk);
+            });
+
+        std::unordered_map<NameId_t, uint32_t> nameOffsets;
+        for (uint64_t chunk : capture->ChangedEntityChunks)
+        {
+            Capture::EntityChunk entityChunk;
+            entityChunk.Chunk = chunk;
+            entityChunk.Names.push_back(0);
+            nameOffsets.clear();
+
+            entities.DoForEachEntityRecordInRange(chunk * ChangeChunkSpan, (chunk + 1) * ChangeChunkSpan, [&](Entity& entity)
+                {
+                    EntityRecord record;
+                    record.Id = entity.Id;
+                    record.Parent = entity.Parent;
+                    record.FirstChild = entityChunk.Children.size();
+                    record.ChildCount = uint32_t(entity.Children.size());
+                    entityChunk.Children.insert(entityChunk.Children.end(), entity.Children.begin(), entity.Children.end());
+
+                    if (entity.NameId != EmptyName)
+                    {
+                        auto itr = nameOffsets.find(entity.NameId);
+                        if (itr == nameOffsets.end())
+                        {
+                            itr = nameOffsets.emplace(entity.NameId, uint32_t(entityChunk.Names.size())).first;
+                            const char* name = entities.GetNameTable().Get(entity.NameId);
+                            entityChunk.Names.insert(entityChunk.Names.end(), name, name + strlen(name) + 1);
+                        }
+                        record.Name = itr->second;
+                    }
+
+                    entityChunk.Records.push_back(record);
+                });
+
+            if (!entityChunk.Records.empty())
+                capture->EntityChunks.push_back(std::move(entityChunk));
+        }
+
+        // one block per concrete type in each chunk, a table can hold several types that share a base
+        for (const auto& tableChunk : capture->ChangedTableChunks)
+        {
+            size_t firstBlock = capture->Blocks.size();
+            entities.DoForEachComponentInRange(tableChunk.first, tableChunk.second * ChangeChunkSpan, (tableChunk.second + 1) * ChangeChunkSpan,
+                [&capture, &tableChunk, firstBlock](Component* component)
+                {
+                    size_t typeId = component->TypeId();
+
+                    Capture::Block* block = nullptr;
+                    for (size_t i = firstBlock; i < capture->Blocks.size() && block == nullptr; i++)
+                    {
+                        if (capture->Blocks[i].TypeId == typeId)
+                            block = &capture->Blocks[i];
+                    }
+
+                    if (block == nullptr)
+                    {
+                        capture->Blocks.emplace_back();
+                        block = &capture->Blocks.back();
+                        block->TableId = tableChunk.first;
+                        block->Chunk = tableChunk.second;
+                        block->TypeId = typeId;
+                        block->TypeName = component->ComponentName();
+                        block->DataSize = component->GetDataSize();
+                    }
+
+                    block->Entities.push_back(component->EntityId);
+                    block->Active.push_back(component->Active ? 1 : 0);
+
+                    if (block->DataSize > 0)
+                    {
+                        size_t offset = block->Data.size();
+                        block->Data.resize(offset + block->DataSize);
+                        component->SaveData(block->Data.data() + offset);
+                    }
+                });
+        }
+
+        return capture;
+    }
+
+    bool IncrementalSaver::Write(Capture& capture, Stats& stats)
+    {
+        PROFILE_SCOPE("SceneFile::Write");
+        auto start = std::chrono::high_resolution_clock::now();
+
+        // the directory after this save, what is kept from the file plus what was captured
+        std::map<uint64_t, EntityChunkHeader> entityChunks;
+        std::map<std::pair<size_t, uint64_t>, std::vector<BlockHeader>> blocks;
+        if (!capture.Full)
+        {
+            entityChunks = EntityChunks;
+            blocks = Blocks;
+
+            for (uint64_t chunk : capture.ChangedEntityChunks)
+                entityChunks.erase(chunk);
+            for (const auto& tableChunk : capture.ChangedTableChunks)
+                blocks.erase(tableChunk);
+        }
+
+        uint64_t keptBytes = sizeof(Header);
+        size_t keptChunks = entityChunks.size();
+        for (const auto& chunk : entityChunks)
+            keptBytes += GetExtent(chunk.second) + SectionAlignment;
+        for (const auto& tableChunk : blocks)
+        {
+            keptChunks += tableChunk.second.size();
+            for (const BlockHeader& block : tableChunk.second)
+                keptBytes += GetExtent(block) + SectionAlignment;
+        }
+
+        uint64_t newBytes = 0;
+        for (const Capture::EntityChunk& chunk : capture.EntityChunks)
+            newBytes += chunk.Records.size() * sizeof(EntityRecord) + chunk.Children.size() * sizeof(EntityId_t) + chunk.Names.size() + SectionAlignment * 3;
+        for (const Capture::Block& block : capture.Blocks)
+            newBytes += block.Entities.size() * sizeof(EntityId_t) + block.Active.size() + block.Data.size() + SectionAlignment * 3;
+
+        // appending keeps the old chunks where they are, rewriting drops the ones nothing points at any more
+        bool compact = capture.Full || !HasFile || double(keptBytes + newBytes) < double(FileBytes + newBytes) * (1.0 - MaxWaste);
+
+        // a rewrite goes to a new file that replaces the old one when it is done, copying the kept chunks across
+        std::string outputName = compact ? FileName + ".tmp" : FileName;
+        MappedFile oldFile;
+        if (compact && keptChunks > 0 && !oldFile.Open(FileName.c_str()))
+            return false;
+
+        FileWriter writer;
+        if (!writer.Open(outputName.c_str(), !compact, FileBytes))
+            return false;
+
+        if (compact)
+        {
+            Header placeholder;
+            writer.Write(&placeholder, sizeof(Header));
+
+            auto copySection = [&writer, &oldFile](uint64_t offset, uint64_t size)
+                {
+                    uint64_t newOffset = writer.Align();
+                    if (offset <= oldFile.Size && size <= oldFile.Size - offset)
+                        writer.Write(oldFile.Data + offset, size_t(size));
+                    else
+                        writer.Ok = false;
+                    return newOffset;
+                };
+
+            for (auto& chunk : entityChunks)
+            {
+                EntityChunkHeader& header = chunk.second;
+                uint64_t moved = copySection(header.EntitiesOffset, GetExtent(header)) - header.EntitiesOffset;
+                header.EntitiesOffset += moved;
+                header.ChildrenOffset += moved;
+                header.NamesOffset += moved;
+            }
+
+            for (auto& tableChunk : blocks)
+            {
+                for (BlockHeader& header : tableChunk.second)
+                {
+                    uint64_t moved = copySection(header.EntitiesOffset, GetExtent(header)) - header.EntitiesOffset;
+                    header.EntitiesOffset += moved;
+                    header.ActiveOffset += moved;
+                    header.DataOffset += moved;
+                }
+            }
+        }
+
+        uint64_t liveBytes = keptBytes;
+        for (const Capture::EntityChunk& chunk : capture.EntityChunks)
+        {
+            EntityChunkHeader header;
+            header.Chunk = chunk.Chunk;
+            header.Count = chunk.Records.size();
+            header.EntitiesOffset = writer.WriteArray(chunk.Records.data(), chunk.Records.size());
+            header.ChildCount = chunk.Children.size();
+            header.ChildrenOffset = writer.WriteArray(chunk.Children.data(), chunk.Children.size());
+            header.NamesSize = chunk.Names.size();
+            header.NamesOffset = writer.WriteArray(chunk.Names.data(), chunk.Names.size());
+
+            entityChunks[chunk.Chunk] = header;
+            liveBytes += GetExtent(header) + SectionAlignment;
+        }
+
+        for (const Capture::Block& block : capture.Blocks)
+        {
+            BlockHeader header;
+            strncpy(header.TypeName, block.TypeName, MaxTypeName - 1);
+            header.TypeKey = HashComponentName(block.TypeName);
+            header.Chunk = block.Chunk;
+            header.Count = block.Entities.size();
+            header.DataSize = uint32_t(block.DataSize);
+            header.EntitiesOffset = writer.WriteArray(block.Entities.data(), block.Entities.size());
+            header.ActiveOffset = writer.WriteArray(block.Active.data(), block.Active.size());
+            header.DataOffset = writer.WriteArray(block.Data.data(), block.Data.size());
+
+            blocks[std::make_pair(block.TableId, block.Chunk)].push_back(header);
+            liveBytes += GetExtent(header) + SectionAlignment;
+        }
+
+        std::vector<EntityChunkHeader> entityDirectory;
+        entityDirectory.reserve(entityChunks.size());
+        for (const auto& chunk : entityChunks)
+            entityDirectory.push_back(chunk.second);
+
+        std::vector<BlockHeader> blockDirectory;
+        for (const auto& tableChunk : blocks)
+            blockDirectory.insert(blockDirectory.end(), tableChunk.second.begin(), tableChunk.second.end());
+
+        Header header;
+        header.EntityChunkCount = entityDirectory.size();
+        header.EntityChunksOffset = writer.WriteArray(entityDirectory.data(), entityDirectory.size());
+        header.BlockCount = blockDirectory.size();
+        header.BlocksOffset = writer.WriteArray(blockDirectory.data(), blockDirectory.size());
+        header.LiveBytes = liveBytes + (entityDirectory.size() * sizeof(EntityChunkHeader)) + (blockDirectory.size() * sizeof(BlockHeader));
+
+        writer.WriteHeader(header);
+        uint64_t fileBytes = writer.Position;
+        uint64_t written = writer.Written;
+        if (!writer.Close())
+            return false;
+
+        oldFile.Close();
+        if (compact)
+        {
+#ifdef _WIN32
+            // rename won't replace a file on windows
+            remove(FileName.c_str());
+#endif
+            if (rename(outputName.c_str(), FileName.c_str()) != 0)
+                return false;
+        }
+
+        EntityChunks = std::move(entityChunks);
+        Blocks = std::move(blocks);
+        FileBytes = fileBytes;
+        HasFile = true;
+
+        stats.ChunksWritten = capture.EntityChunks.size() + capture.Blocks.size();
+        stats.ChunksKept = keptChunks;
+        stats.BytesWritten = size_t(written);
+        stats.FileBytes = size_t(fileBytes);
+        stats.LiveBytes = size_t(header.LiveBytes);
+        stats.Compacted = compact;
+        stats.WriteMs = Profiler::MillisecondsSince(start);
+        return true;
+    }
+
+    bool IncrementalSaver::Save(EntitySet& entities)
+    {
+        if (!BeginSave(entities))
+            return false;
+
+        return FinishSave();
+    }
+
+    bool IncrementalSaver::BeginSave(EntitySet& entities)
+    {
+        if (IsSaving())
+            return false;
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        RunningStats = Stats();
+        Running = TakeCapture(entities);
+        CapturedStamp = Running->Stamp;
+        RunningStats.CaptureMs = Profiler::MillisecondsSince(start);
+
+        Job = JobSystem::Submit([this]()
+            {
+                LastResult = Write(*Running, RunningStats);
+            });
+        return true;
+    }
+
+    void IncrementalSaver::Collect()
+    {
+        Job.get();
+
+        if (LastResult)
+            SavedStamp = Running->Stamp;
+        else
+            CapturedStamp = SavedStamp;
+
+        LastStats = RunningStats;
+        Running.reset();
+    }
+
+    bool IncrementalSaver::IsSaving()
+    {
+        if (!Job.valid())
+            return false;
+
+        if (Job.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            return true;
+
+        Collect();
+        return false;
+    }
+
+    bool IncrementalSaver::FinishSave()
+    {
+        if (Job.valid())
+            Collect();
+
+        return LastResult;
+    }
+
+    bool IncrementalSaver::Attach(EntitySet& entities)
+    {
+        FinishSave();
+
+        MappedFile file;
+        if (!file.Open(FileName.c_str()) || file.Size < sizeof(Header))
+            return false;
+
+        const Header& header = *reinterpret_cast<const Header*>(file.Data);
+        if (header.Magic != Magic || header.Version != Version || header.ChunkSpan != ChangeChunkSpan
+            || header.EntityChunksOffset > file.Size || header.EntityChunkCount > (file.Size - header.EntityChunksOffset) / sizeof(EntityChunkHeader)
+            || header.BlocksOffset > file.Size || header.BlockCount > (file.Size - header.BlocksOffset) / sizeof(BlockHeader))
+            return false;
+
+        EntityChunks.clear();
+        Blocks.clear();
+
+        const EntityChunkHeader* entityChunks = reinterpret_cast<const EntityChunkHeader*>(file.Data + header.EntityChunksOffset);
+        for (uint64_t i = 0; i < header.EntityChunkCount; i++)
+            EntityChunks[entityChunks[i].Chunk] = entityChunks[i];
+
+        // blocks are kept by table, types that are not registered keep their own
+        const BlockHeader* blocks = reinterpret_cast<const BlockHeader*>(file.Data + header.BlocksOffset);
+        for (uint64_t i = 0; i < header.BlockCount; i++)
+        {
+            const ComponentInfo* info = ComponentManager::FindComponentInfo(blocks[i].TypeKey);
+            size_t tableId = info != nullptr ? info->Id : size_t(blocks[i].TypeKey);
+            Blocks[std::make_pair(tableId, blocks[i].Chunk)].push_back(blocks[i]);
+        }
+
+        HasFile = true;
+        FileBytes = file.Size;
+        SavedStamp = entities.GetLastChunkStamp();
+        CapturedStamp = SavedStamp;
+        return true;
+    }
+
+    bool Save(EntitySet& entities, const char* fileName)
+    {
+        PROFILE_SCOPE("SceneFile::Save");
+
+        IncrementalSaver saver(fileName);
+        return saver.Save(entities);
+    }
+
+    // loading
+
+    inline bool InFile(const MappedFile& file, uint64_t offset, uint64_t count, size_t size)
+    {
+        return offset <= file.Size && count <= (file.Size - offset) / (size > 0 ? size : 1);
+    }
+
+    // map a scene file and check that its header and directories are in it
+    static const Header* OpenSceneFile(MappedFile& file, const char* fileName)
+    {
+        if (!file.Open(fileName) || file.Size < sizeof(Header))
+            return nullptr;
+
+        const Header* header = reinterpret_cast<const Header*>(file.Data);
+        if (header->Magic != Magic || header->Version != Version || header->ChunkSpan == 0)
+            return nullptr;
+
+        if (!InFile(file, header->EntityChunksOffset, header->EntityChunkCount, sizeof(EntityChunkHeader))
+            || !InFile(file, header->BlocksOffset, header->BlockCount, sizeof(BlockHeader)))
+            return nullptr;
+
+        return header;
+    }
+
+    static bool IsValidEntityChunk(const MappedFile& file, const EntityChunkHeader& chunk)
+    {
+        return InFile(file, chunk.EntitiesOffset, chunk.Count, sizeof(EntityRecord))
+            && InFile(file, chunk.ChildrenOffset, chunk.ChildCount, sizeof(EntityId_t))
+            && InFile(file, chunk.NamesOffset, chunk.NamesSize, 1);
+    }
+
+    // every name ends inside the chunk if the last byte is a terminator
+    static const char* GetChunkNames(const MappedFile& file, const EntityChunkHeader& chunk)
+    {
+        const char* names = reinterpret_cast<const char*>(file.Data + chunk.NamesOffset);
+        return chunk.NamesSize > 0 && names[chunk.NamesSize - 1] == 0 ? names : nullptr;
+    }
+
+    static const EntityChunkHeader* FindEntityChunk(const Header& header, const MappedFile& file, uint64_t number)
+    {
+        const EntityChunkHeader* entityChunks = reinterpret_cast<const EntityChunkHeader*>(file.Data + header.EntityChunksOffset);
+        const EntityChunkHeader* end = entityChunks + header.EntityChunkCount;
+
+        const EntityChunkHeader* chunk = std::lower_bound(entityChunks, end, number,
+            [](const EntityChunkHeader& entityChunk, uint64_t value) { return entityChunk.Chunk < value; });
+
+        return chunk != end && chunk->Chunk == number ? chunk : nullptr;
+    }
+
+    /// <summary>
+    /// Make the components of one block, without putting them in the set
+    /// Only reads the file, so blocks can be decoded on any thread
+    /// </summary>
+    /// <returns>False if the block can't be loaded, nothing is left in components</returns>
+    static bool DecodeBlock(const MappedFile& file, const BlockHeader& block, const EntityChunkHeader& chunk, EntitySet& entities, std::vector<Component*>& components)
+    {
+        components.clear();
+
+        // the name in the file isn't trusted to be terminated, the last byte of the zeroed copy always is
+        char typeName[MaxTypeName] = { 0 };
+        memcpy(typeName, block.TypeName, MaxTypeName - 1);
+
+        const ComponentInfo* info = ComponentManager::FindComponentInfo(block.TypeKey);
+        if (info == nullptr || strcmp(info->Name, typeName) != 0
+            || !InFile(file, block.EntitiesOffset, block.Count, sizeof(EntityId_t))
+            || !InFile(file, block.ActiveOffset, block.Count, 1)
+            || !InFile(file, block.DataOffset, block.Count, block.DataSize))
+            return false;
+
+        const EntityRecord* records = reinterpret_cast<const EntityRecord*>(file.Data + chunk.EntitiesOffset);
+        const EntityId_t* blockEntities = reinterpret_cast<const EntityId_t*>(file.Data + block.EntitiesOffset);
+        const uint8_t* active = file.Data + block.ActiveOffset;
+        const uint8_t* data = file.Data + block.DataOffset;
+
+        components.reserve(size_t(block.Count));
+
+        // both the block and the entity chunk are sorted by id, so one walk checks every owner exists
+        uint64_t record = 0;
+        for (uint64_t i = 0; i < block.Count; i++)
+        {
+            while (record < chunk.Count && records[record].Id < blockEntities[i])
+                record++;
+
+            if (record == chunk.Count || records[record].Id != blockEntities[i])
+                break;
+
+            Component* component = info->Factory(blockEntities[i], entities);
+
+            // the type changed since the file was written, its data can't be trusted
+            if (component->GetDataSize() != block.DataSize)
+            {
+                delete component;
+                break;
+            }
+
+            component->Active = active[i] != 0;
+            if (block.DataSize > 0)
+                component->LoadData(data + i * block.DataSize);
+
+            components.push_back(component);
+        }
+
+        if (components.size() == block.Count)
+            return true;
+
+        for (Component* component : components)
+            delete component;
+
+        components.clear();
+        return false;
+    }
+
+    bool Load(EntitySet& entities, const char* fileName, LoadStats* stats)
+    {
+        PROFILE_SCOPE("SceneFile::Load");
+
+        LoadStats localStats;
+        if (stats == nullptr)
+            stats = &localStats;
+        *stats = LoadStats();
+
+        if (entities.GetEntityCount() > 0)
+            return false;
+
+        MappedFile file;
+        const Header* header = OpenSceneFile(file, fileName);
+        if (header == nullptr)
+            return false;
+
+        const EntityChunkHeader* entityChunks = reinterpret_cast<const EntityChunkHeader*>(file.Data + header->EntityChunksOffset);
+
+        {
+            PROFILE_SCOPE("SceneFile::LoadEntities");
+            for (uint64_t c = 0; c < header->EntityChunkCount; c++)
+            {
+                const EntityChunkHeader& chunk = entityChunks[c];
+                if (!IsValidEntityChunk(file, chunk) || (c > 0 && chunk.Chunk <= entityChunks[c - 1].Chunk))
+                    return false;
+
+                const EntityRecord* records = reinterpret_cast<const EntityRecord*>(file.Data + chunk.EntitiesOffset);
+                const EntityId_t* children = reinterpret_cast<const EntityId_t*>(file.Data + chunk.ChildrenOffset);
+                const char* names = GetChunkNames(file, chunk);
+
+                for (uint64_t i = 0; i < chunk.Count; i++)
+                {
+                    const EntityRecord& record = records[i];
+                    if (record.FirstChild > chunk.ChildCount || record.ChildCount > chunk.ChildCount - record.FirstChild)
+                        return false;
+
+                    if (entities.LoadEntity(record.Id, record.Parent, children + record.FirstChild, record.ChildCount) == nullptr)
+                        return false;
+
+                    if (record.Name != 0 && names != nullptr && record.Name < chunk.NamesSize)
+                        entities.SetEntityName(record.Id, names + record.Name);
+                }
+                stats->Entities += size_t(chunk.Count);
+            }
+        }
+
+        const BlockHeader* blocks = reinterpret_cast<const BlockHeader*>(file.Data + header->BlocksOffset);
+        std::vector<Component*> components;
+
+        for (uint64_t b = 0; b < header->BlockCount; b++)
+        {
+            PROFILE_SCOPE("SceneFile::LoadBlock");
+
+            // the entities of a block are all in the entity chunk with the same number
+            const EntityChunkHeader* chunk = FindEntityChunk(*header, file, blocks[b].Chunk);
+            if (chunk == nullptr || !DecodeBlock(file, blocks[b], *chunk, entities, components))
+            {
+                stats->SkippedBlocks++;
+                continue;
+            }
+
+            if (components.empty())
+                continue;
+
+            entities.LoadComponents(components[0]->Id(), components.data(), components.size());
+            stats->Components += components.size();
+        }
+
+        return true;
+    }
+
+    // streaming
+
+    // the clock is only read every so many entities or components
+    static constexpr size_t StreamingCheckInterval = 256;
+
+    struct StreamingLoader::State
+    {
+        struct DecodedBlock
+        {
+            size_t TableId = 0;
+            std::vector<Component*> Components;
+        };
+
+        // the components of one entity chunk, made on a worker
+        struct DecodedChunk
+        {
+            std::future<void> Job;
+            std::vector<DecodedBlock> Blocks;
+            size_t SkippedBlocks = 0;
+            size_t SkippedComponents = 0;
+        };
+
+        EntitySet* Entities = nullptr;
+        MappedFile File;
+        const Header* FileHeader = nullptr;
+        const EntityChunkHeader* EntityChunks = nullptr;
+        const BlockHeader* Blocks = nullptr;
+        std::vector<std::vector<uint64_t>> ChunkBlocks;     // block indexes for each entity chunk
+
+        std::deque<std::unique_ptr<DecodedChunk>> Decoding; // the front one is the chunk being loaded
+        size_t NextDecode = 0;
+        std::atomic<bool> Cancelled = { false };
+
+        // filled in by the worker that opens the file
+        std::future<void> OpenJob;
+        bool Opened = false;
+        Progress Totals;
+        EntityId_t HighestId = InvalidEntityId;
+
+        // where the main thread is in the current chunk
+        size_t Current = 0;
+        uint64_t NextRecord = 0;
+        size_t NextBlock = 0;
+        size_t NextComponent = 0;
+        std::vector<EntityId_t> SkippedIds;                 // ids in the file that were already in use, sorted
+        bool CheckLinks = false;                            // the set had entities of its own when loading started
+
+        uint64_t LastStamp = 0;
+        std::chrono::high_resolution_clock::time_point Start;
+
+        bool Open(const std::string& fileName);
+
+        ~State()
+        {
+            // workers may still be opening the file or decoding into the chunks, wait for them before anything goes away
+            Cancelled = true;
+            if (OpenJob.valid())
+                OpenJob.wait();
+
+            for (auto& decoded : Decoding)
+            {
+                if (decoded->Job.valid())
+                    decoded->Job.wait();
+            }
+
+            for (size_t i = 0; i < Decoding.size(); i++)
+            {
+                for (size_t b = i == 0 ? NextBlock : 0; b < Decoding[i]->Blocks.size(); b++)
+                {
+                    std::vector<Component*>& components = Decoding[i]->Blocks[b].Components;
+                    for (size_t c = (i == 0 && b == NextBlock) ? NextComponent : 0; c < components.size(); c++)
+                        delete components[c];
+                }
+            }
+        }
+    };
+
+    StreamingLoader::StreamingLoader()
+    {
+    }
+
+    StreamingLoader::~StreamingLoader()
+    {
+        Cancel();
+    }
+
+    bool StreamingLoader::State::Open(const std::string& fileName)
+    {
+        const Header* header = OpenSceneFile(File, fileName.c_str());
+        if (header == nullptr)
+            return false;
+
+        FileHeader = header;
+        EntityChunks = reinterpret_cast<const EntityChunkHeader*>(File.Data + header->EntityChunksOffset);
+        Blocks = reinterpret_cast<const BlockHeader*>(File.Data + header->BlocksOffset);
+
+        Totals.TotalChunks = size_t(header->EntityChunkCount);
+        for (uint64_t c = 0; c < header->EntityChunkCount; c++)
+        {
+            const EntityChunkHeader& chunk = EntityChunks[c];
+            if (!IsValidEntityChunk(File, chunk) || (c > 0 && chunk.Chunk <= EntityChunks[c - 1].Chunk))
+                return false;
+
+            Totals.Total += size_t(chunk.Count);
+        }
+
+        // blocks are loaded right after the entities of their chunk
+        ChunkBlocks.resize(size_t(header->EntityChunkCount));
+        for (uint64_t b = 0; b < header->BlockCount; b++)
+        {
+            const EntityChunkHeader* chunk = FindEntityChunk(*header, File, Blocks[b].Chunk);
+            if (chunk == nullptr)
+            {
+                Totals.SkippedBlocks++;
+                continue;
+            }
+
+            ChunkBlocks[chunk - EntityChunks].push_back(b);
+            Totals.Total += size_t(Blocks[b].Count);
+        }
+
+        // the records are sorted so the last one is the highest
+        for (uint64_t c = header->EntityChunkCount; c > 0; c--)
+        {
+            const EntityChunkHeader& chunk = EntityChunks[c - 1];
+            if (chunk.Count == 0)
+                continue;
+
+            HighestId = reinterpret_cast<const EntityRecord*>(File.Data + chunk.EntitiesOffset)[chunk.Count - 1].Id;
+            break;
+        }
+
+        return true;
+    }
+
+    bool StreamingLoader::Begin(EntitySet& entities, const char* fileName)
+    {
+        if (Running != nullptr || fileName == nullptr)
+            return false;
+
+        std::unique_ptr<State> state = std::make_unique<State>();
+        state->Start = std::chrono::high_resolution_clock::now();
+        state->Entities = &entities;
+
+        // mapping the file reads all of it in, so that is done on a worker too
+        State* opening = state.get();
+        std::string name = fileName;
+        state->OpenJob = JobSystem::Submit([opening, name]()
+            {
+                PROFILE_SCOPE("SceneFile::OpenStreamed");
+                opening->Opened = opening->Open(name);
+            });
+
+        Running = std::move(state);
+        FileName = fileName;
+        CurrentProgress = Progress();
+        Edited = false;
+        LastResult = true;
+        return true;
+    }
+
+    void StreamingLoader::StartLoading()
+    {
+        State& state = *Running;
+        EntitySet& entities = *state.Entities;
+
+        // nothing else can be given an id from the file while it loads
+        if (state.HighestId != InvalidEntityId)
+        {
+            EntityId_t next = entities.ReserveEntityIds(0);
+            if (state.HighestId >= next)
+                entities.ReserveEntityIds(state.HighestId + 1 - next);
+        }
+
+        state.CheckLinks = entities.GetEntityCount() > 0;
+        state.LastStamp = entities.GetLastChunkStamp();
+        CurrentProgress.SkippedBlocks = state.Totals.SkippedBlocks;
+        CurrentProgress.TotalChunks = state.Totals.TotalChunks;
+        CurrentProgress.Total = state.Totals.Total;
+
+        QueueDecodes();
+    }
+
+    void StreamingLoader::QueueDecodes()
+    {
+        State& state = *Running;
+        while (state.NextDecode < state.ChunkBlocks.size() && state.Decoding.size() <= ChunksAhead)
+        {
+            state.Decoding.push_back(std::make_unique<State::DecodedChunk>());
+            State::DecodedChunk* decoded = state.Decoding.back().get();
+            size_t chunkIndex = state.NextDecode++;
+
+            State* running = &state;
+            decoded->Job = JobSystem::Submit([running, decoded, chunkIndex]()
+                {
+                    PROFILE_SCOPE("SceneFile::DecodeChunk");
+
+                    const EntityChunkHeader& chunk = running->EntityChunks[chunkIndex];
+                    for (uint64_t b : running->ChunkBlocks[chunkIndex])
+                    {
+                        if (running->Cancelled)
+                            return;
+
+                        State::DecodedBlock block;
+                        if (!DecodeBlock(running->File, running->Blocks[b], chunk, *running->Entities, block.Components))
+                        {
+                            decoded->SkippedBlocks++;
+                            decoded->SkippedComponents += size_t(running->Blocks[b].Count);
+                            continue;
+                        }
+
+                        if (block.Components.empty())
+                            continue;
+
+                        block.TableId = block.Components[0]->Id();
+                        decoded->Blocks.push_back(std::move(block));
+                    }
+                });
+        }
+    }
+
+    bool StreamingLoader::LoadEntityRecords(const std::function<bool(size_t)>& outOfTime)
+    {
+        State& state = *Running;
+        EntitySet& entities = *state.Entities;
+        const MappedFile& file = state.File;
+        const EntityChunkHeader& chunk = state.EntityChunks[state.Current];
+
+        const EntityRecord* records = reinterpret_cast<const EntityRecord*>(file.Data + chunk.EntitiesOffset);
+        const EntityId_t* children = reinterpret_cast<const EntityId_t*>(file.Data + chunk.ChildrenOffset);
+        const char* names = GetChunkNames(file, chunk);
+
+        std::vector<EntityId_t> keptChildren;
+        while (state.NextRecord < chunk.Count)
+        {
+            if (outOfTime(1))
+                return true;
+
+            const EntityRecord& record = records[state.NextRecord++];
+            if (record.FirstChild > chunk.ChildCount || record.ChildCount > chunk.ChildCount - record.FirstChild)
+                return false;
+
+            EntityId_t parent = record.Parent;
+            const EntityId_t* recordChildren = children + record.FirstChild;
+            size_t childCount = record.ChildCount;
+
+            // every id below this one that is in the set was loaded or was already there, anything above it was already
+            // there, so links to entities that were removed, moved or are not the ones in the file are dropped
+            if (Edited || state.CheckLinks)
+            {
+                auto isLoaded = [&state, &entities, &record](EntityId_t id)
+                    {
+                        return id < record.Id && entities.GetEntity(id) != nullptr && !std::binary_search(state.SkippedIds.begin(), state.SkippedIds.end(), id);
+                    };
+
+                if (parent != InvalidEntityId && (parent < record.Id ? !isLoaded(parent) : entities.GetEntity(parent) != nullptr))
+                    parent = InvalidEntityId;
+
+                keptChildren.clear();
+                for (size_t i = 0; i < childCount; i++)
+                {
+                    EntityId_t childId = recordChildren[i];
+                    if (childId < record.Id ? isLoaded(childId) && entities.GetEntity(childId)->Parent == record.Id : entities.GetEntity(childId) == nullptr)
+                        keptChildren.push_back(childId);
+                }
+
+                recordChildren = keptChildren.data();
+                childCount = keptChildren.size();
+            }
+
+            CurrentProgress.Processed++;
+            if (entities.LoadEntity(record.Id, parent, recordChildren, childCount) == nullptr)
+            {
+                // the entity that has the id doesn't know about children loaded before it, so they become roots
+                for (size_t i = 0; i < childCount; i++)
+                {
+                    Entity* child = recordChildren[i] < record.Id ? entities.GetEntity(recordChildren[i]) : nullptr;
+                    if (child != nullptr && child->Parent == record.Id)
+                        entities.ReparentEntity(child->Id, InvalidEntityId);
+                }
+
+                state.SkippedIds.push_back(record.Id);
+                CurrentProgress.SkippedEntities++;
+                continue;
+            }
+
+            if (record.Name != 0 && names != nullptr && record.Name < chunk.NamesSize)
+                entities.SetEntityName(record.Id, names + record.Name);
+
+            CurrentProgress.Entities++;
+        }
+
+        return true;
+    }
+
+    bool StreamingLoader::LoadComponents(const std::function<bool(size_t)>& outOfTime)
+    {
+        State& state = *Running;
+        EntitySet& entities = *state.Entities;
+        State::DecodedChunk& decoded = *state.Decoding.front();
+
+        // owners are only looked up when some may be missing
+        bool checkOwners = Edited || !state.SkippedIds.empty();
+
+        std::vector<Component*> batch;
+        while (state.NextBlock < decoded.Blocks.size())
+        {
+            State::DecodedBlock& block = decoded.Blocks[state.NextBlock];
+            while (state.NextComponent < block.Components.size())
+            {
+                if (outOfTime(StreamingCheckInterval))
+                    return true;
+
+                size_t first = state.NextComponent;
+                size_t last = std::min(block.Components.size(), first + StreamingCheckInterval);
+                state.NextComponent = last;
+
+                Component* const* components = block.Components.data() + first;
+                size_t count = last - first;
+                if (checkOwners)
+                {
+                    batch.clear();
+                    for (size_t i = first; i < last; i++)
+                    {
+                        Component* component = block.Components[i];
+                        if (std::binary_search(state.SkippedIds.begin(), state.SkippedIds.end(), component->EntityId)
+                            || (Edited && entities.GetEntity(component->EntityId) == nullptr))
+                            delete component;
+                        else
+                            batch.push_back(component);
+                    }
+
+                    components = batch.data();
+                    count = batch.size();
+                }
+
+                entities.LoadComponents(block.TableId, components, count);
+                CurrentProgress.Components += count;
+                CurrentProgress.Processed += last - first;
+            }
+
+            state.NextBlock++;
+            state.NextComponent = 0;
+        }
+
+        return true;
+    }
+
+    bool StreamingLoader::Update(double budgetMs)
+    {
+        if (Running == nullptr)
+            return false;
+
+        PROFILE_SCOPE("SceneFile::StreamingUpdate");
+        auto start = std::chrono::high_resolution_clock::now();
+
+        State& state = *Running;
+        if (state.OpenJob.valid())
+        {
+            // nothing goes in until the worker has mapped and checked the file
+            if (state.OpenJob.wait_for(std::chrono::duration<double, std::milli>(budgetMs)) != std::future_status::ready)
+            {
+                CurrentProgress.LastUpdateMs = Profiler::MillisecondsSince(start);
+                CurrentProgress.TotalMs = Profiler::MillisecondsSince(state.Start);
+                return true;
+            }
+
+            state.OpenJob.get();
+            if (!state.Opened)
+            {
+                Finish(false);
+                return false;
+            }
+
+            StartLoading();
+        }
+
+        if (state.Entities->GetLastChunkStamp() != state.LastStamp)
+            Edited = true;
+
+        // at least one batch goes in every update, so a tiny budget still gets there
+        size_t sinceCheck = 0;
+        bool loadedBatch = false;
+        std::function<bool(size_t)> outOfTime = [&sinceCheck, &loadedBatch, &start, budgetMs](size_t work)
+            {
+                sinceCheck += work;
+                if (sinceCheck < StreamingCheckInterval)
+                    return false;
+
+                sinceCheck = 0;
+                if (!loadedBatch)
+                {
+                    loadedBatch = true;
+                    return false;
+                }
+                return Profiler::MillisecondsSince(start) >= budgetMs;
+            };
+
+        bool ok = true;
+        while (ok && state.Current < state.ChunkBlocks.size())
+        {
+            const EntityChunkHeader& chunk = state.EntityChunks[state.Current];
+            if (state.NextRecord < chunk.Count)
+            {
+                ok = LoadEntityRecords(outOfTime);
+                if (!ok || state.NextRecord < chunk.Count)
+                    break;
+            }
+
+            // the components come from a worker, wait for them with whatever time is left
+            State::DecodedChunk& decoded = *state.Decoding.front();
+            if (decoded.Job.valid())
+            {
+                double remainingMs = std::max(budgetMs - Profiler::MillisecondsSince(start), 0.0);
+                if (decoded.Job.wait_for(std::chrono::duration<double, std::milli>(remainingMs)) != std::future_status::ready)
+                    break;
+
+                decoded.Job.get();
+                CurrentProgress.SkippedBlocks += decoded.SkippedBlocks;
+                CurrentProgress.Processed += decoded.SkippedComponents;
+            }
+
+            if (!LoadComponents(outOfTime) || state.NextBlock < decoded.Blocks.size())
+                break;
+
+            state.Decoding.pop_front();
+            state.Current++;
+            state.NextRecord = 0;
+            state.NextBlock = 0;
+            state.NextComponent = 0;
+            CurrentProgress.ChunksLoaded++;
+
+            QueueDecodes();
+        }
+
+        CurrentProgress.LastUpdateMs = Profiler::MillisecondsSince(start);
+        CurrentProgress.TotalMs = Profiler::MillisecondsSince(state.Start);
+
+        if (!ok)
+            Finish(false);
+        else if (state.Current == state.ChunkBlocks.size())
+            Finish(true);
+        else
+            state.LastStamp = state.Entities->GetLastChunkStamp();
+
+        return Running != nullptr;
+    }
+
+    void StreamingLoader::Finish(bool result)
+    {
+        LastResult = result;
+        Running.reset();
+    }
+
+    void StreamingLoader::Cancel()
+    {
+        if (Running != nullptr)
+            Finish(false);
+    }
+}
@@ -0,0 +1,278 @@
+/**********************************************************************************************
+*
+*   raylib_ECS_sample * a sample Entity Component System using raylib
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+#pragma once
+
+#include "entity_manager.h"
+
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+// binary scene files, split into chunks of ChangeChunkSpan entity ids so a save can rewrite only the chunks that changed
+// each entity chunk holds the entity table for its ids, their children and their names, and each component block
+// holds one type for one chunk: an entity column, an active column and the component data
+// a save appends the chunks it wrote and a new directory, then points the header at it, so the file also holds
+// chunks left over from earlier saves until it is compacted
+namespace SceneFile
+{
+    constexpr uint32_t Magic = 0x43534C52;      // "RLSC"
+    constexpr uint32_t Version = 4;
+    constexpr size_t SectionAlignment = 16;
+    constexpr size_t MaxTypeName = 64;
+
+    struct Header
+    {
+        uint32_t Magic = SceneFile::Magic;
+        uint32_t Version = SceneFile::Version;
+        uint64_t ChunkSpan = ChangeChunkSpan;
+        uint64_t EntityChunkCount = 0;
+        uint64_t EntityChunksOffset = 0;    // EntityChunkHeader[EntityChunkCount], sorted by chunk
+        uint64_t BlockCount = 0;
+        uint64_t BlocksOffset = 0;          // BlockHeader[BlockCount]
+        uint64_t LiveBytes = 0;             // used by what the header points at, the rest of the file is left over
+    };
+
+    struct EntityChunkHeader
+    {
+        uint64_t Chunk = 0;                 // entity id / ChunkSpan
+        uint64_t Count = 0;
+        uint64_t EntitiesOffset = 0;        // EntityRecord[Count], sorted by id
+        uint64_t ChildCount = 0;
+        uint64_t ChildrenOffset = 0;        // EntityId_t[ChildCount], indexed by EntityRecord::FirstChild
+        uint64_t NamesSize = 0;
+        uint64_t NamesOffset = 0;           // null terminated names, indexed by EntityRecord::Name
+    };
+
+    struct EntityRecord
+    {
+        EntityId_t Id = InvalidEntityId;
+        EntityId_t Parent = InvalidEntityId;
+        uint64_t FirstChild = 0;
+        uint32_t ChildCount = 0;
+        uint32_t Name = 0;                  // 0 is no name
+    };
+
+    struct BlockHeader
+    {
+        char TypeName[MaxTypeName] = { 0 };
+        ComponentKey_t TypeKey = 0;         // looked up first, the name is checked against it
+        uint64_t Chunk = 0;
+        uint64_t Count = 0;
+        uint64_t EntitiesOffset = 0;        // EntityId_t[Count], sorted
+        uint64_t ActiveOffset = 0;          // uint8_t[Count]
+        uint64_t DataOffset = 0;            // Count records of DataSize bytes each
+        uint32_t DataSize = 0;
+        uint32_t Reserved = 0;
+    };
+
+    struct LoadStats
+    {
+        size_t Entities = 0;
+        size_t Components = 0;
+        size_t SkippedBlocks = 0;       // types that are not registered or whose data size changed
+    };
+
+    // write a whole scene
+    bool Save(EntitySet& entities, const char* fileName);
+
+    /// <summary>
+    /// Load a scene into an empty entity set, entity ids are kept as they were saved
+    /// The file is memory mapped and component data is copied straight out of it
+    /// Components and their table entries come out of MemoryPool slabs instead of a heap allocation each,
+    /// which was most of the time a large load took
+    /// </summary>
+    bool Load(EntitySet& entities, const char* fileName, LoadStats* stats = nullptr);
+
+    /// <summary>
+    /// Saves one entity set to one file again and again, writing only the chunks stamped since the last save
+    /// The changed chunks are appended with a new directory and the header is pointed at it last, so a save that
+    /// fails part way leaves the previous one readable. Once too much of the file is left over it is rewritten.
+    /// A save can be split in two: the changed chunks are copied out on the calling thread and then encoded
+    /// and written on a worker, so autosaves don't hold up frames.
+    /// </summary>
+    class IncrementalSaver
+    {
+    public:
+        struct Stats
+        {
+            size_t ChunksWritten = 0;       // entity chunks and component blocks
+            size_t ChunksKept = 0;
+            size_t BytesWritten = 0;
+            size_t FileBytes = 0;
+            size_t LiveBytes = 0;
+            bool Compacted = false;
+
+            double CaptureMs = 0;           // on the thread that started the save
+            double WriteMs = 0;             // on the worker for background saves
+        };
+
+        IncrementalSaver(const char* fileName);
+        ~IncrementalSaver();
+
+        /// <summary>
+        /// Take over the chunks of the file, for a set that was just loaded from it
+        /// Without this the first save writes the whole file
+        /// </summary>
+        bool Attach(EntitySet& entities);
+
+        bool Save(EntitySet& entities);
+
+        /// <summary>
+        /// Copy out what changed and start writing it on a worker
+        /// The set can be changed as soon as this returns
+        /// </summary>
+        /// <returns>False if a save is still running</returns>
+        bool BeginSave(EntitySet& entities);
+
+        // true while a background save is running, a finished one is collected
+        bool IsSaving();
+
+        // wait for a background save, true if it worked
+        bool FinishSave();
+
+        // true if nothing changed since the last save (or the one running)
+        inline bool IsUpToDate(const EntitySet& entities) const { return entities.GetLastChunkStamp() == CapturedStamp; }
+
+        inline const std::string& GetFileName() const { return FileName; }
+        inline const Stats& GetStats() const { return LastStats; }
+        inline bool GetLastResult() const { return LastResult; }
+
+        // the file is rewritten once more than this share of it is left over from earlier saves
+        float MaxWaste = 0.5f;
+
+    private:
+        struct Capture;
+
+        std::unique_ptr<Capture> TakeCapture(EntitySet& entities);
+        bool Write(Capture& capture, Stats& stats);
+        void Collect();
+
+        std::string FileName;
+
+        // what the file holds now, only touched by the writer while a save is running
+        bool HasFile = false;
+        uint64_t FileBytes = 0;
+        std::map<uint64_t, EntityChunkHeader> EntityChunks;
+        std::map<std::pair<size_t, uint64_t>, std::vector<BlockHeader>> Blocks;   // by table and chunk
+
+        uint64_t SavedStamp = 0;            // the set as of this stamp is in the file
+        uint64_t CapturedStamp = 0;         // the stamp the running (or last) save took
+
+        std::unique_ptr<Capture> Running;
+        std::future<void> Job;
+        Stats RunningStats;
+
+        Stats LastStats;
+        bool LastResult = true;
+    };
+
+    /// <summary>
+    /// Loads a scene over a number of frames, so a big scene doesn't stop the frame it is loaded in
+    /// The file is mapped and checked on a worker, component blocks are decoded into new components on workers
+    /// a few chunks ahead, and the main thread puts entities and components into the set in batches until the
+    /// time it was given for the frame runs out.
+    /// Each run of ids is finished before the next one starts, so what is loaded so far can be shown and edited.
+    /// Ids that are already in use are skipped with their components, so the set can keep entities of its own.
+    /// </summary>
+    class StreamingLoader
+    {
+    public:
+        struct Progress
+        {
+            size_t Entities = 0;
+            size_t Components = 0;
+            size_t SkippedEntities = 0;     // ids that were already in use, or whose parent was removed while loading
+            size_t SkippedBlocks = 0;
+
+            size_t ChunksLoaded = 0;
+            size_t TotalChunks = 0;
+            size_t Processed = 0;           // entities and components, loaded or skipped
+            size_t Total = 0;
+
+            double LastUpdateMs = 0;        // main thread time in the last update
+            double TotalMs = 0;             // from Begin until the last update
+
+            inline float GetFraction() const { return Total > 0 ? float(double(Processed) / double(Total)) : 0.0f; }
+        };
+
+        StreamingLoader();
+        ~StreamingLoader();
+
+        /// <summary>
+        /// Start opening a scene file on a worker, ids up to the highest one in the file are reserved once it is open
+        /// </summary>
+        /// <returns>False if a load is already running, a file that can't be read ends the load in the first update</returns>
+        bool Begin(EntitySet& entities, const char* fileName);
+
+        /// <summary>
+        /// Put decoded entities and components into the set until the budget is spent, call once a frame
+        /// </summary>
+        /// <param name="budgetMs">Main thread time to spend, at least one batch is always loaded</param>
+        /// <returns>True while there is more to load</returns>
+        bool Update(double budgetMs);
+
+        // stop loading, what was already loaded stays in the set
+        void Cancel();
+
+        inline bool IsLoading() const { return Running != nullptr; }
+
+        // true if something other than the loader changed the set while it was loading
+        inline bool WasEdited() const { return Edited; }
+
+        // false if the last load was cancelled, couldn't read the file or found a damaged entity chunk
+        inline bool GetLastResult() const { return LastResult; }
+
+        inline const Progress& GetProgress() const { return CurrentProgress; }
+        inline const std::string& GetFileName() const { return FileName; }
+
+        // how many chunks are decoded ahead of the one being loaded
+        size_t ChunksAhead = 4;
+
+    private:
+        struct State;
+
+        void StartLoading();
+        void QueueDecodes();
+        bool LoadEntityRecords(const std::function<bool(size_t)>& outOfTime);
+        bool LoadComponents(const std::function<bool(size_t)>& outOfTime);
+        void Finish(bool result);
+
+        std::unique_ptr<State> Running;
+        std::string FileName;
+        Progress CurrentProgress;
+        bool Edited = false;
+        bool LastResult = true;
+    };
+}
\ No newline at end of file
@@ -39,6 +39,8 @@ public:
         :Entities(entities)
     {
     }
+    virtual ~System() = default;
+
     virtual void OnCreate() {}
     virtual size_t Id() { return 0; }
     virtual const char* SystemName() { return nullptr; }
@@ -28,74 +28,79 @@
 
 #include "systems/free_flight_controller.h"
 #include "components/flight_data_component.h"
+#include "platform_services.h"
+#include "profiler.h"
 
 #include "raylib.h"
 
 
 void FreeFlightController::Update(TransformComponent* toMove)
 {
+    PROFILE_SCOPE("FreeFlightController::Update");
+
     if (toMove == nullptr )
         return;
 
     FlightDataComponent* flightData = toMove->MustGetComponent<FlightDataComponent>();
+    InputSource& input = InputSource::Get();
 
     if (flightData != nullptr && (AllowMovement == nullptr || AllowMovement()))
     {
-        float speed = flightData->Speed * GetFrameTime();
+        float speed = flightData->Speed * TimeSource::Get().GetFrameTime();
 
-        if (IsKeyDown(KEY_LEFT_SHIFT))
+        if (input.IsKeyDown(KEY_LEFT_SHIFT))
             speed *= 5.0f;
 
-        if (IsKeyDown(KEY_E))
+        if (input.IsKeyDown(KEY_E))
             toMove->MoveUp(speed);
-        else if (IsKeyDown(KEY_Q))
+        else if (input.IsKeyDown(KEY_Q))
             toMove->MoveUp(-speed);
 
-        if (IsKeyDown(KEY_D))
+        if (input.IsKeyDown(KEY_D))
             toMove->MoveRight(speed);
-        else if (IsKeyDown(KEY_A))
+        else if (input.IsKeyDown(KEY_A))
             toMove->MoveLeft(speed);
 
-        if (IsKeyDown(KEY_W))
+        if (input.IsKeyDown(KEY_W))
             toMove->MoveForward(speed);
-        else if (IsKeyDown(KEY_S))
+        else if (input.IsKeyDown(KEY_S))
             toMove->MoveForward(-speed);
 
-        float rotSpeed = flightData->RotationSpeed * GetFrameTime();
+        float rotSpeed = flightData->RotationSpeed * TimeSource::Get().GetFrameTime();
 
         if (flightData->UseHeading)
         {
-            if (IsKeyDown(KEY_RIGHT))
+            if (input.IsKeyDown(KEY_RIGHT))
                 toMove->RotateHeading(rotSpeed);
-            else if (IsKeyDown(KEY_LEFT))
+            else if (input.IsKeyDown(KEY_LEFT))
                 toMove->RotateHeading(-rotSpeed);
         }
         else
         {
-            if (IsKeyDown(KEY_RIGHT))
+            if (input.IsKeyDown(KEY_RIGHT))
                 toMove->RotateYaw(-rotSpeed);
-            else if (IsKeyDown(KEY_LEFT))
+            else if (input.IsKeyDown(KEY_LEFT))
                 toMove->RotateYaw(rotSpeed);
         }
 
-        if (IsKeyDown(KEY_UP))
+        if (input.IsKeyDown(KEY_UP))
             toMove->RotatePitch(-rotSpeed);
-        else if (IsKeyDown(KEY_DOWN))
+        else if (input.IsKeyDown(KEY_DOWN))
             toMove->RotatePitch(rotSpeed);
 
-        if (!flightData->UseMouseButton || IsMouseButtonDown(1))
+        if (!flightData->UseMouseButton || input.IsMouseButtonDown(1))
         {
-            Vector2 delta = Vector2Subtract(GetMousePosition(), LastMousePos);
+            Vector2 delta = Vector2Subtract(input.GetMousePosition(), LastMousePos);
 
             toMove->RotateHeading(delta.x * rotSpeed * 0.2f);
             toMove->RotatePitch(delta.y * rotSpeed * 0.2f);
         }
 
-        if (IsKeyDown(KEY_DELETE))
+        if (input.IsKeyDown(KEY_DELETE))
             toMove->RotateRoll(-rotSpeed);
-        else if (IsKeyDown(KEY_PAGE_DOWN))
+        else if (input.IsKeyDown(KEY_PAGE_DOWN))
             toMove->RotateRoll(rotSpeed);
     }
 
-    LastMousePos = GetMousePosition();
+    LastMousePos = input.GetMousePosition();
 }
@@ -30,6 +30,7 @@
 
 #include "system_manager.h"
 #include "components/transform_component.h"
+#include "platform_services.h"
 
 #include <functional>
 
@@ -40,7 +41,7 @@ class FreeFlightController : public System
 public:
     DEFINE_SYSTEM(FreeFlightController);
 
-    inline void OnCreate() override { LastMousePos = GetMousePosition(); }
+    inline void OnCreate() override { LastMousePos = InputSource::Get().GetMousePosition(); }
 
     void Update(TransformComponent* transform);
 
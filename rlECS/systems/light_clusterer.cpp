@@ -0,0 +1,324 @@
+/**********************************************************************************************
+*
+*   raylib_ECS_sample * a sample Entity Component System using raylib
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+
+#include "systems/light_clusterer.h"
+#include "job_system.h"
+#include "profiler.h"
+
+#include "raymath.h"
+
+#include <algorithm>
+#include <math.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CLUSTER_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+void LightClusterer::Setup(const Camera3D& camera, float aspect, float nearPlane, float farPlane)
+{
+    View = MatrixLookAt(camera.position, camera.target, camera.up);
+
+    if (camera.fovy == FovY && aspect == Aspect && nearPlane == Near && farPlane == Far && !ClusterMinX.empty())
+        return;
+
+    FovY = camera.fovy;
+    Aspect = aspect;
+    Near = nearPlane;
+    Far = farPlane;
+    BuildClusterBounds();
+}
+
+void LightClusterer::BuildClusterBounds()
+{
+    float logRatio = logf(Far / Near);
+    SliceScale = Slices / logRatio;
+    SliceBias = -Slices * logf(Near) / logRatio;
+
+    ClusterMinX.resize(ClusterCount);
+    ClusterMinY.resize(ClusterCount);
+    ClusterMinZ.resize(ClusterCount);
+    ClusterMaxX.resize(ClusterCount);
+    ClusterMaxY.resize(ClusterCount);
+    ClusterMaxZ.resize(ClusterCount);
+
+    float tanY = tanf(FovY * 0.5f * DEG2RAD);
+    float tanX = tanY * Aspect;
+
+    for (int slice = 0; slice < Slices; slice++)
+    {
+        float nearDepth = Near * powf(Far / Near, slice / (float)Slices);
+        float farDepth = Near * powf(Far / Near, (slice + 1) / (float)Slices);
+
+        for (int y = 0; y < TilesY; y++)
+        {
+            // tile rows go up from the bottom of the screen, same as gl_FragCoord
+            float y0 = (-1.0f + 2.0f * y / TilesY) * tanY;
+            float y1 = (-1.0f + 2.0f * (y + 1) / TilesY) * tanY;
+
+            for (int x = 0; x < TilesX; x++)
+            {
+                float x0 = (-1.0f + 2.0f * x / TilesX) * tanX;
+                float x1 = (-1.0f + 2.0f * (x + 1) / TilesX) * tanX;
+
+                // the tile frustum widens with depth, so the bounds come from the corners at both ends
+                int cluster = slice * TileCount + y * TilesX + x;
+                ClusterMinX[cluster] = std::min(x0 * nearDepth, x0 * farDepth);
+                ClusterMaxX[cluster] = std::max(x1 * nearDepth, x1 * farDepth);
+                ClusterMinY[cluster] = std::min(y0 * nearDepth, y0 * farDepth);
+                ClusterMaxY[cluster] = std::max(y1 * nearDepth, y1 * farDepth);
+
+                // the camera looks down -Z
+                ClusterMinZ[cluster] = -farDepth;
+                ClusterMaxZ[cluster] = -nearDepth;
+            }
+        }
+    }
+}
+
+int LightClusterer::GetSlice(float depth) const
+{
+    int slice = (int)floorf(logf(depth) * SliceScale + SliceBias);
+    return std::min(std::max(slice, 0), Slices - 1);
+}
+
+void LightClusterer::Bin(const std::vector<RenderLight>& pointLights)
+{
+    PROFILE_SCOPE("LightClusterer::Bin");
+
+    BinStats = Stats();
+    BinStats.Lights = pointLights.size();
+
+    SliceBins.resize(Slices);
+    for (SliceData& slice : SliceBins)
+        slice.Lights.clear();
+
+    // move the lights into view space and drop each one into the depth slices it touches
+    size_t count = pointLights.size();
+    LightX.resize(count);
+    LightY.resize(count);
+    LightZ.resize(count);
+    LightRadius.resize(count);
+
+    float tanY = tanf(FovY * 0.5f * DEG2RAD);
+    float tanX = tanY * Aspect;
+    float scaleX = 1.0f / sqrtf(1 + tanX * tanX);
+    float scaleY = 1.0f / sqrtf(1 + tanY * tanY);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const RenderLight& light = pointLights[i];
+        Vector3 pos = Vector3Transform(light.Position, View);
+
+        LightX[i] = pos.x;
+        LightY[i] = pos.y;
+        LightZ[i] = pos.z;
+        LightRadius[i] = light.Range;
+
+        float depth = -pos.z;
+        if (light.Range <= 0 || depth + light.Range < Near || depth - light.Range > Far)
+            continue;
+
+        // outside one of the side planes
+        if ((fabsf(pos.x) - tanX * depth) * scaleX > light.Range || (fabsf(pos.y) - tanY * depth) * scaleY > light.Range)
+            continue;
+
+        int first = GetSlice(std::max(depth - light.Range, Near));
+        int last = GetSlice(std::min(depth + light.Range, Far));
+        for (int slice = first; slice <= last; slice++)
+            SliceBins[slice].Lights.push_back((uint32_t)i);
+    }
+
+    JobSystem::ParallelFor(Slices, [this](size_t slice) { BinSlice((int)slice); });
+
+    // pack the slices one after the other
+    uint32_t total = 0;
+    for (SliceData& slice : SliceBins)
+    {
+        slice.Base = total;
+        total += (uint32_t)slice.Indexes.size();
+        BinStats.Dropped += slice.Dropped;
+    }
+
+    LightIndexes.resize(total);
+    ClusterRanges.resize(ClusterCount * 2);
+
+    JobSystem::ParallelFor(Slices, [this](size_t sliceIndex)
+        {
+            const SliceData& slice = SliceBins[sliceIndex];
+            std::copy(slice.Indexes.begin(), slice.Indexes.end(), LightIndexes.begin() + slice.Base);
+
+            uint32_t* ranges = &ClusterRanges[sliceIndex * TileCount * 2];
+            for (int tile = 0; tile < TileCount; tile++)
+            {
+                ranges[tile * 2] = slice.Base + slice.TileOffsets[tile];
+                ranges[tile * 2 + 1] = slice.TileCounts[tile];
+            }
+        });
+
+    BinStats.Assignments = total;
+    for (int cluster = 0; cluster < ClusterCount; cluster++)
+    {
+        if (ClusterRanges[cluster * 2 + 1] > 0)
+            BinStats.UsedClusters++;
+    }
+}
+
+// returns a bit for each of the 4 spheres starting at index that touch the box
+static inline int TestSpheres(const float* x, const float* y, const float* z, const float* radiusSq, const float* boxMin, const float* boxMax)
+{
+    // squared distance from the center to the closest point on the box
+#ifdef CLUSTER_USE_SSE2
+    __m128 zero = _mm_setzero_ps();
+
+    __m128 cx = _mm_loadu_ps(x);
+    __m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(boxMin[0]), cx), _mm_sub_ps(cx, _mm_set1_ps(boxMax[0]))), zero);
+
+    __m128 cy = _mm_loadu_ps(y);
+    __m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(boxMin[1]), cy), _mm_sub_ps(cy, _mm_set1_ps(boxMax[1]))), zero);
+
+    __m128 cz = _mm_loadu_ps(z);
+    __m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(boxMin[2]), cz), _mm_sub_ps(cz, _mm_set1_ps(boxMax[2]))), zero);
+
+    __m128 distSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+    return _mm_movemask_ps(_mm_cmple_ps(distSq, _mm_loadu_ps(radiusSq)));
+#else
+    int mask = 0;
+    for (int lane = 0; lane < 4; lane++)
+    {
+        float dx = std::max(std::max(boxMin[0] - x[lane], x[lane] - boxMax[0]), 0.0f);
+        float dy = std::max(std::max(boxMin[1] - y[lane], y[lane] - boxMax[1]), 0.0f);
+        float dz = std::max(std::max(boxMin[2] - z[lane], z[lane] - boxMax[2]), 0.0f);
+        if (dx * dx + dy * dy + dz * dz <= radiusSq[lane])
+            mask |= 1 << lane;
+    }
+    return mask;
+#endif
+}
+
+static inline int PopLowestBit(int& mask)
+{
+    int lane = 0;
+    while ((mask & (1 << lane)) == 0)
+        lane++;
+
+    mask &= ~(1 << lane);
+    return lane;
+}
+
+void LightClusterer::SphereGroups::Clear()
+{
+    Lights.clear();
+    X.clear();
+    Y.clear();
+    Z.clear();
+    RadiusSq.clear();
+}
+
+void LightClusterer::SphereGroups::Add(uint32_t light, float x, float y, float z, float radiusSq)
+{
+    Lights.push_back(light);
+    X.push_back(x);
+    Y.push_back(y);
+    Z.push_back(z);
+    RadiusSq.push_back(radiusSq);
+}
+
+void LightClusterer::SphereGroups::Pad()
+{
+    // the padding is far away with no radius, so it never passes the test
+    while (Lights.size() % 4 != 0)
+        Add(0, 1e30f, 1e30f, 1e30f, -1.0f);
+}
+
+void LightClusterer::BinSlice(int sliceIndex)
+{
+    PROFILE_SCOPE("LightClusterer::BinSlice");
+
+    SliceData& slice = SliceBins[sliceIndex];
+    slice.Indexes.clear();
+    slice.Dropped = 0;
+
+    SphereGroups& spheres = slice.Spheres;
+    spheres.Clear();
+    for (uint32_t light : slice.Lights)
+        spheres.Add(light, LightX[light], LightY[light], LightZ[light], LightRadius[light] * LightRadius[light]);
+    spheres.Pad();
+
+    SphereGroups& row = slice.Row;
+    for (int y = 0; y < TilesY; y++)
+    {
+        // find the lights that touch this row of tiles first, so each tile only tests those
+        int rowStart = sliceIndex * TileCount + y * TilesX;
+        int rowEnd = rowStart + TilesX - 1;
+        float rowMin[3] = { ClusterMinX[rowStart], ClusterMinY[rowStart], ClusterMinZ[rowStart] };
+        float rowMax[3] = { ClusterMaxX[rowEnd], ClusterMaxY[rowStart], ClusterMaxZ[rowStart] };
+
+        row.Clear();
+        for (size_t group = 0; group < spheres.Lights.size(); group += 4)
+        {
+            int mask = TestSpheres(&spheres.X[group], &spheres.Y[group], &spheres.Z[group], &spheres.RadiusSq[group], rowMin, rowMax);
+            while (mask != 0)
+            {
+                size_t i = group + PopLowestBit(mask);
+                row.Add(spheres.Lights[i], spheres.X[i], spheres.Y[i], spheres.Z[i], spheres.RadiusSq[i]);
+            }
+        }
+        row.Pad();
+
+        for (int x = 0; x < TilesX; x++)
+        {
+            int tile = y * TilesX + x;
+            int cluster = sliceIndex * TileCount + tile;
+            float boxMin[3] = { ClusterMinX[cluster], ClusterMinY[cluster], ClusterMinZ[cluster] };
+            float boxMax[3] = { ClusterMaxX[cluster], ClusterMaxY[cluster], ClusterMaxZ[cluster] };
+
+            slice.TileOffsets[tile] = (uint32_t)slice.Indexes.size();
+
+            uint32_t tileCount = 0;
+            for (size_t group = 0; group < row.Lights.size(); group += 4)
+            {
+                int mask = TestSpheres(&row.X[group], &row.Y[group], &row.Z[group], &row.RadiusSq[group], boxMin, boxMax);
+                while (mask != 0)
+                {
+                    size_t i = group + PopLowestBit(mask);
+                    if (tileCount >= (uint32_t)MaxLightsPerCluster)
+                    {
+                        slice.Dropped++;
+                        continue;
+                    }
+
+                    slice.Indexes.push_back(row.Lights[i]);
+                    tileCount++;
+                }
+            }
+            slice.TileCounts[tile] = tileCount;
+        }
+    }
+}
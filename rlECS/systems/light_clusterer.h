@@ -0,0 +1,134 @@
+/**********************************************************************************************
+*
+*   raylib_ECS_sample * a sample Entity Component System using raylib
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+
+#pragma once
+
+#include "systems/render_snapshot.h"
+
+#include "raylib.h"
+
+#include <stdint.h>
+#include <vector>
+
+// bins point lights into a grid of view space clusters, screen tiles split into exponential depth slices
+// the shader looks up the cluster for a pixel and only walks the lights in it
+class LightClusterer
+{
+public:
+    static constexpr int TilesX = 16;
+    static constexpr int TilesY = 9;
+    static constexpr int Slices = 24;
+    static constexpr int TileCount = TilesX * TilesY;
+    static constexpr int ClusterCount = TileCount * Slices;
+
+    // lights past this in one cluster are dropped
+    int MaxLightsPerCluster = 256;
+
+    struct Stats
+    {
+        size_t Lights = 0;
+        size_t Assignments = 0;
+        size_t Dropped = 0;
+        size_t UsedClusters = 0;
+    };
+
+public:
+    // sets the view to bin against, must match the projection used to draw
+    void Setup(const Camera3D& camera, float aspect, float nearPlane, float farPlane);
+
+    // bins the lights, only position and range are used
+    void Bin(const std::vector<RenderLight>& pointLights);
+
+    // offset into the index list and light count for each cluster, x then y then slice
+    inline const std::vector<uint32_t>& GetClusterRanges() const { return ClusterRanges; }
+
+    // indexes into the light list passed to Bin
+    inline const std::vector<uint32_t>& GetLightIndexes() const { return LightIndexes; }
+
+    inline const Stats& GetStats() const { return BinStats; }
+
+    inline const Matrix& GetViewMatrix() const { return View; }
+
+    // slice = log(depth) * scale + bias
+    inline float GetSliceScale() const { return SliceScale; }
+    inline float GetSliceBias() const { return SliceBias; }
+
+private:
+    void BuildClusterBounds();
+    int GetSlice(float depth) const;
+    void BinSlice(int slice);
+
+    Matrix View = { 0 };
+
+    float FovY = 0;
+    float Aspect = 0;
+    float Near = 0;
+    float Far = 0;
+
+    float SliceScale = 0;
+    float SliceBias = 0;
+
+    // view space bounds of every cluster
+    std::vector<float> ClusterMinX, ClusterMinY, ClusterMinZ;
+    std::vector<float> ClusterMaxX, ClusterMaxY, ClusterMaxZ;
+
+    // view space spheres of the lights being binned
+    std::vector<float> LightX, LightY, LightZ, LightRadius;
+
+    // light spheres laid out in groups of 4 for the SIMD tests
+    struct SphereGroups
+    {
+        std::vector<uint32_t> Lights;
+        std::vector<float> X, Y, Z, RadiusSq;
+
+        void Clear();
+        void Add(uint32_t light, float x, float y, float z, float radiusSq);
+        void Pad();
+    };
+
+    struct SliceData
+    {
+        std::vector<uint32_t> Lights;
+
+        SphereGroups Spheres;
+        SphereGroups Row;
+
+        std::vector<uint32_t> Indexes;
+        uint32_t TileOffsets[TileCount] = { 0 };
+        uint32_t TileCounts[TileCount] = { 0 };
+        size_t Dropped = 0;
+        uint32_t Base = 0;
+    };
+    std::vector<SliceData> SliceBins;
+
+    std::vector<uint32_t> ClusterRanges;
+    std::vector<uint32_t> LightIndexes;
+
+    Stats BinStats;
+};
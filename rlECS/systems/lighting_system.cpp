@@ -31,73 +31,462 @@
 #include "components/light_component.h"
 #include "components/transform_component.h"
 
+#include "job_system.h"
+#include "profiler.h"
+#include "render_backend.h"
+
 #include "raylib.h"
+#include "raymath.h"
+#include "rlgl.h"
+
+#include <algorithm>
+#include <float.h>
+#include <stdio.h>
+#include <string.h>
 
 
-#define GLSL_VERSION            330
+#define SHADER_PATH             "resources/shaders/glsl330/"
 #define MAX_LIGHTS              4         // Max dynamic lights supported by shader
+#define DATA_TEXTURE_WIDTH      1024      // Width of the textures clustered lighting data is packed into
 
 Shader& LightingSystem::GetShader()
 {
-    return LightShader;
+    return UseClusteredLighting ? ClusteredShader : LightShader;
 }
 
 void LightingSystem::Setup()
 {
-    LightShader = LoadShader(TextFormat("resources/shaders/glsl%i/base_lighting.vs", GLSL_VERSION),
-        TextFormat("resources/shaders/glsl%i/lighting.fs", GLSL_VERSION));
+    PROFILE_SCOPE("LightingSystem::Setup");
+
+    RenderBackend& backend = RenderBackend::Get();
+
+    LightShader = backend.LoadShader(SHADER_PATH "base_lighting.vs",
+        SHADER_PATH "lighting.fs");
         
-    LightShader.locs[SHADER_LOC_VECTOR_VIEW] = GetShaderLocation(LightShader, "viewPos");
+    LightShader.locs[SHADER_LOC_VECTOR_VIEW] = backend.GetShaderLocation(LightShader, "viewPos");
 
     // Ambient light level (some basic lighting)
-    int ambientLoc = GetShaderLocation(LightShader, "ambient");
+    int ambientLoc = backend.GetShaderLocation(LightShader, "ambient");
         
     float color[4] = { 0.2f, 0.2f, 0.2f, 1.0f };
 
-    SetShaderValue(LightShader, ambientLoc, color, SHADER_UNIFORM_VEC4);
+    backend.SetShaderValue(LightShader, ambientLoc, color, SHADER_UNIFORM_VEC4);
 
-    // disable all lights
-    char enabledName[32] = "lights[x].enabled\0";
-    for (int i = 0; i < MAX_LIGHTS; i++)
+    // all the lights are one array of vec4s, so any run of them can go up in a single call
+    char elementName[32] = { 0 };
+    LightVectorLocs.resize(MAX_LIGHTS * PackedLight::VectorCount);
+    for (size_t i = 0; i < LightVectorLocs.size(); i++)
     {
-        enabledName[7] = '0' + i;
-
-        auto loc = GetShaderLocation(LightShader, enabledName);
-        int val = 0;
-        SetShaderValue(LightShader, loc, &val, SHADER_UNIFORM_INT);
+        snprintf(elementName, sizeof(elementName), "lights[%d]", (int)i);
+        LightVectorLocs[i] = backend.GetShaderLocation(LightShader, elementName);
     }
+
+    PackedLights.assign(MAX_LIGHTS, PackedLight());
+    UploadedLights.clear();
+    ViewPositionUploaded = false;
+
+    // the clustered shader reads the lights from data textures
+    ClusteredShader = backend.LoadShader(SHADER_PATH "base_lighting.vs",
+        SHADER_PATH "lighting_clustered.fs");
+
+    ClusteredShader.locs[SHADER_LOC_VECTOR_VIEW] = backend.GetShaderLocation(ClusteredShader, "viewPos");
+    backend.SetShaderValue(ClusteredShader, backend.GetShaderLocation(ClusteredShader, "ambient"), color, SHADER_UNIFORM_VEC4);
+
+    ClusterLocations.LightData = backend.GetShaderLocation(ClusteredShader, "lightData");
+    ClusterLocations.ClusterData = backend.GetShaderLocation(ClusteredShader, "clusterData");
+    ClusterLocations.LightIndexes = backend.GetShaderLocation(ClusteredShader, "lightIndexes");
+    ClusterLocations.DirectionalCount = backend.GetShaderLocation(ClusteredShader, "directionalCount");
+    ClusterLocations.ClusterCounts = backend.GetShaderLocation(ClusteredShader, "clusterCounts");
+    ClusterLocations.ClusterParams = backend.GetShaderLocation(ClusteredShader, "clusterParams");
+    ClusterLocations.ViewMatrix = backend.GetShaderLocation(ClusteredShader, "viewMatrix");
 }
 
 void LightingSystem::UpdateLights()
 {
-    Entities.DoForEachEntity<LightComponent>([this](LightComponent* light)
+    PROFILE_SCOPE("LightingSystem::UpdateLights");
+
+    ExtractLights(LightCache);
+    UploadLights(LightCache);
+}
+
+int LightingSystem::AllocateSlot(LightComponent* light)
+{
+    int slot = 0;
+    if (!FreeSlots.empty())
+    {
+        slot = FreeSlots.back();
+        FreeSlots.pop_back();
+    }
+    else
+    {
+        slot = (int)SlotOwners.size();
+        SlotOwners.push_back(nullptr);
+        SlotLastSeen.push_back(0);
+    }
+
+    SlotOwners[slot] = light;
+    return slot;
+}
+
+void LightingSystem::ReleaseUnusedSlots()
+{
+    // lights that were removed or turned off were not seen this pass, so their slots go back to the free list
+    for (int slot = 0; slot < (int)SlotOwners.size(); slot++)
+    {
+        if (SlotOwners[slot] == nullptr || SlotLastSeen[slot] == ExtractCount)
+            continue;
+
+        SlotOwners[slot] = nullptr;
+        FreeSlots.push_back(slot);
+    }
+}
+
+void LightingSystem::ExtractLights(std::vector<RenderLight>& lights)
+{
+    PROFILE_SCOPE("LightingSystem::ExtractLights");
+
+    ExtractCount++;
+
+    lights.clear();
+    Entities.DoForEachEntity<LightComponent>([this, &lights](LightComponent* light)
         {
             if (!light->LightEnabled || !light->Active)
                 return;
 
-            if (!light->IsSetup())
+            // a light that lost its slot while it was off gets a new one
+            int slot = light->GetLightIndex();
+            if (slot < 0 || slot >= (int)SlotOwners.size() || SlotOwners[slot] != light)
             {
-                int id = 0;
-                while (UsedLightIds.find(id) != UsedLightIds.end())
-                {
-                    id++;
-                    if (id > MAX_LIGHTS)
-                        return;
-                }
-                UsedLightIds.insert(id);
-                light->Setup(id, LightShader);
+                slot = AllocateSlot(light);
+                light->Setup(slot);
             }
-            else
+            SlotLastSeen[slot] = ExtractCount;
+
+            lights.emplace_back();
+            light->Extract(lights.back());
+        });
+
+    ReleaseUnusedSlots();
+    PROFILE_COUNTER("Active Lights", lights.size());
+}
+
+void LightingSystem::ComputeLightWeights(const std::vector<RenderLight>& lights, const Vector3& viewPosition)
+{
+    LightWeights.resize(lights.size());
+    for (size_t i = 0; i < lights.size(); i++)
+    {
+        const RenderLight& light = lights[i];
+
+        float intensity = (light.LightColor.r * 0.2126f + light.LightColor.g * 0.7152f + light.LightColor.b * 0.0722f) / 255.0f;
+
+        // lights that cover more of the screen are favored
+        float coverage = 1;
+        if (light.Type != (int)LightTypes::DIRECTIONAL && light.Range > 0)
+            coverage = light.Range / std::max(Vector3Distance(light.Position, viewPosition), light.Range);
+
+        LightWeights[i] = intensity * (0.5f + 0.5f * coverage);
+    }
+}
+
+float LightingSystem::GetLightImportance(const RenderLight& light, float weight, const Vector3& position) const
+{
+    // directional lights reach everything
+    if (light.Type == (int)LightTypes::DIRECTIONAL)
+        return 1e30f;
+
+    float distance = Vector3Distance(light.Position, position);
+    if (light.Range <= 0)
+        return weight / (1 + distance * distance);
+
+    // the forward shader has no range falloff, so a light past its range still lights the shape
+    // it ranks below every light in range, nearest first, and only fills slots those leave empty
+    if (distance >= light.Range)
+        return -distance;
+
+    float falloff = 1 - distance / light.Range;
+    return weight * falloff * falloff;
+}
+
+void LightingSystem::PickLights(const std::vector<RenderLight>& lights, const Vector3& position, RenderLightSet& set) const
+{
+    float scores[RenderLightSet::Count];
+    for (int i = 0; i < RenderLightSet::Count; i++)
+    {
+        scores[i] = -FLT_MAX;
+        set.Lights[i] = -1;
+    }
+
+    // keep the best few, sorted by score
+    for (size_t i = 0; i < lights.size(); i++)
+    {
+        float score = GetLightImportance(lights[i], LightWeights[i], position);
+        if (score <= scores[RenderLightSet::Count - 1])
+            continue;
+
+        int insert = RenderLightSet::Count - 1;
+        while (insert > 0 && scores[insert - 1] < score)
+        {
+            scores[insert] = scores[insert - 1];
+            set.Lights[insert] = set.Lights[insert - 1];
+            insert--;
+        }
+        scores[insert] = score;
+        set.Lights[insert] = (int)i;
+    }
+
+    // the same lights in any order are the same set
+    std::sort(set.Lights, set.Lights + RenderLightSet::Count);
+}
+
+void LightingSystem::AssignLights(RenderSnapshot& snapshot)
+{
+    PROFILE_SCOPE("LightingSystem::AssignLights");
+
+    snapshot.LightSets.clear();
+
+    // clustered lighting picks lights per pixel instead
+    if (UseClusteredLighting || snapshot.Shapes.empty())
+        return;
+
+    ComputeLightWeights(snapshot.Lights, snapshot.ViewCam.position);
+
+    std::vector<RenderShape>& shapes = snapshot.Shapes;
+    ShapeLightSets.resize(shapes.size());
+
+    const size_t chunkSize = 256;
+    JobSystem::ParallelFor((shapes.size() + chunkSize - 1) / chunkSize, [this, &snapshot, &shapes, chunkSize](size_t chunk)
+        {
+            size_t end = std::min(shapes.size(), (chunk + 1) * chunkSize);
+            for (size_t i = chunk * chunkSize; i < end; i++)
             {
-                light->Update(LightShader);
+                // rank against the shape's center, the transform is stored transposed for GL
+                Vector3 position = Vector3Transform(shapes[i].Origin, MatrixTranspose(shapes[i].Transform));
+                PickLights(snapshot.Lights, position, ShapeLightSets[i]);
             }
         });
+
+    // sort the shapes so ones with the same lights are drawn together, each run only needs one upload
+    ShapeOrder.resize(shapes.size());
+    for (size_t i = 0; i < ShapeOrder.size(); i++)
+        ShapeOrder[i] = (uint32_t)i;
+
+    std::stable_sort(ShapeOrder.begin(), ShapeOrder.end(), [this](uint32_t a, uint32_t b)
+        {
+            return std::lexicographical_compare(ShapeLightSets[a].Lights, ShapeLightSets[a].Lights + RenderLightSet::Count, ShapeLightSets[b].Lights, ShapeLightSets[b].Lights + RenderLightSet::Count);
+        });
+
+    SortedShapes.clear();
+    for (uint32_t index : ShapeOrder)
+    {
+        const RenderLightSet& set = ShapeLightSets[index];
+        if (snapshot.LightSets.empty() || !std::equal(set.Lights, set.Lights + RenderLightSet::Count, snapshot.LightSets.back().Lights))
+            snapshot.LightSets.push_back(set);
+
+        SortedShapes.push_back(shapes[index]);
+        SortedShapes.back().LightSet = (uint32_t)snapshot.LightSets.size() - 1;
+    }
+    shapes.swap(SortedShapes);
+}
+
+static void PackLight(const RenderLight& light, float* position, float* target, float* color)
+{
+    position[0] = light.Position.x;
+    position[1] = light.Position.y;
+    position[2] = light.Position.z;
+    position[3] = (float)light.Type;
+
+    target[0] = light.Target.x;
+    target[1] = light.Target.y;
+    target[2] = light.Target.z;
+    target[3] = 1;
+
+    color[0] = light.LightColor.r / 255.0f;
+    color[1] = light.LightColor.g / 255.0f;
+    color[2] = light.LightColor.b / 255.0f;
+    color[3] = light.LightColor.a / 255.0f;
+}
+
+void LightingSystem::UploadLightSet(const std::vector<RenderLight>& lights, const RenderLightSet& set)
+{
+    // slots without a light stay zeroed, which disables them
+    std::fill(PackedLights.begin(), PackedLights.end(), PackedLight());
+    for (int i = 0; i < RenderLightSet::Count && i < (int)PackedLights.size(); i++)
+    {
+        if (set.Lights[i] < 0 || set.Lights[i] >= (int)lights.size())
+            continue;
+
+        PackedLight& packed = PackedLights[i];
+        PackLight(lights[set.Lights[i]], packed.Position, packed.Target, packed.Color);
+    }
+
+    UploadPackedLights();
+}
+
+void LightingSystem::UploadLights(const std::vector<RenderLight>& lights)
+{
+    PROFILE_SCOPE("LightingSystem::UploadLights");
+
+    if (UseClusteredLighting)
+    {
+        UploadClusteredLights(lights);
+        return;
+    }
+
+    // without per shape light sets, use the lights that matter most around the camera
+    RenderLightSet set;
+    ComputeLightWeights(lights, ViewCam.position);
+    PickLights(lights, ViewCam.position, set);
+    UploadLightSet(lights, set);
+}
+
+void LightingSystem::UploadPackedLights()
+{
+    // only send the range of slots that changed since the last upload
+    int first = 0;
+    int last = (int)PackedLights.size() - 1;
+    if (UploadedLights.size() == PackedLights.size())
+    {
+        while (first <= last && memcmp(&PackedLights[first], &UploadedLights[first], sizeof(PackedLight)) == 0)
+            first++;
+
+        while (last >= first && memcmp(&PackedLights[last], &UploadedLights[last], sizeof(PackedLight)) == 0)
+            last--;
+    }
+
+    if (first > last)
+        return;
+
+    RenderBackend::Get().SetShaderValueV(LightShader, LightVectorLocs[first * PackedLight::VectorCount], PackedLights[first].Position, SHADER_UNIFORM_VEC4, (last - first + 1) * PackedLight::VectorCount);
+
+    UploadedLights = PackedLights;
+}
+
+void LightingSystem::SetViewPosition(const Vector3& position)
+{
+    if (ViewPositionUploaded && position.x == UploadedViewPosition.x && position.y == UploadedViewPosition.y && position.z == UploadedViewPosition.z)
+        return;
+
+    ViewPositionUploaded = true;
+    UploadedViewPosition = position;
+
+    float p[3] = { position.x,position.y,position.z };
+    RenderBackend::Get().SetShaderValue(LightShader, LightShader.locs[SHADER_LOC_VECTOR_VIEW], p, SHADER_UNIFORM_VEC3);
+    RenderBackend::Get().SetShaderValue(ClusteredShader, ClusteredShader.locs[SHADER_LOC_VECTOR_VIEW], p, SHADER_UNIFORM_VEC3);
+}
+
+void LightingSystem::SetView(const Camera3D& camera, int viewportWidth, int viewportHeight)
+{
+    ViewCam = camera;
+    ViewWidth = viewportWidth;
+    ViewHeight = viewportHeight;
+
+    SetViewPosition(camera.position);
 }
 
 void LightingSystem::Update(uint64_t cameraEntity)
 {
     auto* transform = Entities.MustGetComponent<TransformComponent>(cameraEntity);
-    Vector3 cameraPos = transform->GetWorldPosition();
-    float p[3] = { cameraPos.x,cameraPos.y,cameraPos.z };
-    SetShaderValue(LightShader, LightShader.locs[SHADER_LOC_VECTOR_VIEW], p, SHADER_UNIFORM_VEC3);
+
+    Camera3D camera = { 0 };
+    camera.position = transform->GetWorldPosition();
+    camera.target = Vector3Add(camera.position, transform->GetForwardVector());
+    camera.up = transform->GetUpVector();
+    camera.fovy = 45;
+
+    SetView(camera);
+}
+
+void LightingSystem::UploadDataTexture(DataTexture& texture, std::vector<float>& data, int width, int format)
+{
+    RenderBackend& backend = RenderBackend::Get();
+
+    // pad out to whole rows, the texture only grows so it isn't reallocated every time the count changes
+    int channels = format == PIXELFORMAT_UNCOMPRESSED_R32G32B32A32 ? 4 : 1;
+    int height = std::max(1, (int)((data.size() / channels + width - 1) / width));
+    data.resize((size_t)width * height * channels, 0.0f);
+
+    if (texture.Id != 0 && texture.Width == width && texture.Height >= height && texture.Format == format)
+    {
+        backend.UpdateDataTexture(texture.Id, data.data(), width, height, format);
+        return;
+    }
+
+    if (texture.Id != 0)
+        backend.UnloadDataTexture(texture.Id);
+
+    texture.Width = width;
+    texture.Height = height;
+    texture.Format = format;
+    texture.Id = backend.LoadDataTexture(data.data(), width, height, format);
+}
+
+void LightingSystem::UploadClusteredLights(const std::vector<RenderLight>& lights)
+{
+    PROFILE_SCOPE("LightingSystem::UploadClusteredLights");
+
+    int width = ViewWidth > 0 ? ViewWidth : RenderBackend::Get().GetScreenWidth();
+    int height = ViewHeight > 0 ? ViewHeight : RenderBackend::Get().GetScreenHeight();
+    float aspect = height > 0 ? width / (float)height : 1.0f;
+
+    Clusterer.Setup(ViewCam, aspect, RL_CULL_DISTANCE_NEAR, RL_CULL_DISTANCE_FAR);
+
+    // two texels per light, position and range then color
+    // directional lights light everything so they go first and are not binned, their first texel is the direction to the light
+    LightData.clear();
+    PointLights.clear();
+
+    int directionalCount = 0;
+    for (const RenderLight& light : lights)
+    {
+        if (light.Type != (int)LightTypes::DIRECTIONAL)
+        {
+            PointLights.push_back(light);
+            continue;
+        }
+
+        Vector3 direction = Vector3Normalize(Vector3Subtract(light.Position, light.Target));
+        LightData.insert(LightData.end(), { direction.x, direction.y, direction.z, 0.0f });
+        LightData.insert(LightData.end(), { light.LightColor.r / 255.0f, light.LightColor.g / 255.0f, light.LightColor.b / 255.0f, light.LightColor.a / 255.0f });
+        directionalCount++;
+    }
+
+    for (const RenderLight& light : PointLights)
+    {
+        LightData.insert(LightData.end(), { light.Position.x, light.Position.y, light.Position.z, light.Range });
+        LightData.insert(LightData.end(), { light.LightColor.r / 255.0f, light.LightColor.g / 255.0f, light.LightColor.b / 255.0f, light.LightColor.a / 255.0f });
+    }
+
+    Clusterer.Bin(PointLights);
+
+    // offset and count for every cluster, one row per depth slice
+    const std::vector<uint32_t>& ranges = Clusterer.GetClusterRanges();
+    ClusterData.resize((size_t)LightClusterer::ClusterCount * 4);
+    for (int cluster = 0; cluster < LightClusterer::ClusterCount; cluster++)
+    {
+        ClusterData[cluster * 4] = (float)ranges[cluster * 2];
+        ClusterData[cluster * 4 + 1] = (float)ranges[cluster * 2 + 1];
+        ClusterData[cluster * 4 + 2] = 0;
+        ClusterData[cluster * 4 + 3] = 0;
+    }
+
+    const std::vector<uint32_t>& indexes = Clusterer.GetLightIndexes();
+    IndexData.assign(indexes.begin(), indexes.end());
+
+    UploadDataTexture(LightTexture, LightData, DATA_TEXTURE_WIDTH, PIXELFORMAT_UNCOMPRESSED_R32G32B32A32);
+    UploadDataTexture(ClusterTexture, ClusterData, LightClusterer::TileCount, PIXELFORMAT_UNCOMPRESSED_R32G32B32A32);
+    UploadDataTexture(IndexTexture, IndexData, DATA_TEXTURE_WIDTH, PIXELFORMAT_UNCOMPRESSED_R32);
+
+    RenderBackend& backend = RenderBackend::Get();
+    backend.SetShaderTexture(ClusteredShader, ClusterLocations.LightData, LightTexture.Id, LightTexture.Width, LightTexture.Height);
+    backend.SetShaderTexture(ClusteredShader, ClusterLocations.ClusterData, ClusterTexture.Id, ClusterTexture.Width, ClusterTexture.Height);
+    backend.SetShaderTexture(ClusteredShader, ClusterLocations.LightIndexes, IndexTexture.Id, IndexTexture.Width, IndexTexture.Height);
+
+    int counts[3] = { LightClusterer::TilesX, LightClusterer::TilesY, LightClusterer::Slices };
+    float params[4] = { (float)width, (float)height, Clusterer.GetSliceScale(), Clusterer.GetSliceBias() };
+
+    backend.SetShaderValue(ClusteredShader, ClusterLocations.DirectionalCount, &directionalCount, SHADER_UNIFORM_INT);
+    backend.SetShaderValue(ClusteredShader, ClusterLocations.ClusterCounts, counts, SHADER_UNIFORM_IVEC3);
+    backend.SetShaderValue(ClusteredShader, ClusterLocations.ClusterParams, params, SHADER_UNIFORM_VEC4);
+
+    backend.SetShaderMatrix(ClusteredShader, ClusterLocations.ViewMatrix, Clusterer.GetViewMatrix());
 }
@@ -29,25 +29,129 @@
 #pragma once
 
 #include "system_manager.h"
+#include "systems/light_clusterer.h"
+#include "systems/render_snapshot.h"
 
 #include "stdint.h"
 #include "raylib.h"
 
-#include <set>
+#include <vector>
+
+class LightComponent;
 
 class LightingSystem : public System
 {
 public:
     DEFINE_SYSTEM(LightingSystem);
 
+    // bin any number of point lights into view clusters instead of using the fixed shader slots
+    bool UseClusteredLighting = false;
+
     Shader& GetShader();
 
     void Setup();
     void Update(uint64_t cameraEntity);
     void UpdateLights();
 
+    // copies the enabled lights out of the entities, new lights get a slot and removed or disabled ones give theirs back
+    void ExtractLights(std::vector<RenderLight>& lights);
+
+    // picks the most important lights for every shape in the snapshot and groups the shapes that share them
+    void AssignLights(RenderSnapshot& snapshot);
+
+    // sends one group's lights to the shader
+    void UploadLightSet(const std::vector<RenderLight>& lights, const RenderLightSet& set);
+
+    // sends extracted lights and the view position to the shader, does not touch any entities
+    void UploadLights(const std::vector<RenderLight>& lights);
+    void SetViewPosition(const Vector3& position);
+
+    // the view lights are clustered against, a size of 0 uses the screen size
+    void SetView(const Camera3D& camera, int viewportWidth = 0, int viewportHeight = 0);
+
+    inline const LightClusterer& GetClusterer() const { return Clusterer; }
+
+    inline size_t GetUsedSlotCount() const { return SlotOwners.size() - FreeSlots.size(); }
+
 private:
+    int AllocateSlot(LightComponent* light);
+    void ReleaseUnusedSlots();
+
+    void ComputeLightWeights(const std::vector<RenderLight>& lights, const Vector3& viewPosition);
+    float GetLightImportance(const RenderLight& light, float weight, const Vector3& position) const;
+    void PickLights(const std::vector<RenderLight>& lights, const Vector3& position, RenderLightSet& set) const;
+
+    void UploadPackedLights();
+
+    void UploadClusteredLights(const std::vector<RenderLight>& lights);
+
     Shader LightShader;
+    Shader ClusteredShader;
+
+    // one light laid out the way the shader's lights array expects it
+    struct PackedLight
+    {
+        static constexpr int VectorCount = 3;
+
+        float Position[4] = { 0 };  // w is the light type
+        float Target[4] = { 0 };    // w is 1 when the light is enabled
+        float Color[4] = { 0 };
+    };
+
+    std::vector<int> LightVectorLocs;
+    std::vector<PackedLight> PackedLights;
+    std::vector<PackedLight> UploadedLights;
+
+    Vector3 UploadedViewPosition = { 0, 0, 0 };
+    bool ViewPositionUploaded = false;
+
+    std::vector<RenderLight> LightCache;
+
+    // light slots, owners are only compared, never dereferenced, so removed lights are safe
+    std::vector<LightComponent*> SlotOwners;
+    std::vector<uint64_t> SlotLastSeen;
+    std::vector<int> FreeSlots;
+    uint64_t ExtractCount = 0;
+
+    // per light part of the importance that doesn't depend on what is lit
+    std::vector<float> LightWeights;
+
+    std::vector<RenderLightSet> ShapeLightSets;
+    std::vector<uint32_t> ShapeOrder;
+    std::vector<RenderShape> SortedShapes;
+
+    struct ClusteredLocations
+    {
+        int LightData = -1;
+        int ClusterData = -1;
+        int LightIndexes = -1;
+        int DirectionalCount = -1;
+        int ClusterCounts = -1;
+        int ClusterParams = -1;
+        int ViewMatrix = -1;
+    };
+    ClusteredLocations ClusterLocations;
+
+    struct DataTexture
+    {
+        unsigned int Id = 0;
+        int Width = 0;
+        int Height = 0;
+        int Format = 0;
+    };
+    void UploadDataTexture(DataTexture& texture, std::vector<float>& data, int width, int format);
+
+    LightClusterer Clusterer;
+    Camera3D ViewCam = { 0 };
+    int ViewWidth = 0;
+    int ViewHeight = 0;
+
+    std::vector<RenderLight> PointLights;
+    std::vector<float> LightData;
+    std::vector<float> ClusterData;
+    std::vector<float> IndexData;
 
-    std::set<int> UsedLightIds;
+    DataTexture LightTexture;
+    DataTexture ClusterTexture;
+    DataTexture IndexTexture;
 };
\ No newline at end of file
@@ -0,0 +1,419 @@
+/**********************************************************************************************
+*
+*   raylib_ECS_sample * a sample Entity Component System using raylib
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+
+#include "systems/occlusion_culler.h"
+#include "job_system.h"
+#include "profiler.h"
+
+#include "raymath.h"
+
+#include <algorithm>
+#include <math.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OCCLUSION_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+static Vector4 TransformToClip(const Matrix& mat, const Vector3& pos)
+{
+    return Vector4
+    {
+        mat.m0 * pos.x + mat.m4 * pos.y + mat.m8 * pos.z + mat.m12,
+        mat.m1 * pos.x + mat.m5 * pos.y + mat.m9 * pos.z + mat.m13,
+        mat.m2 * pos.x + mat.m6 * pos.y + mat.m10 * pos.z + mat.m14,
+        mat.m3 * pos.x + mat.m7 * pos.y + mat.m11 * pos.z + mat.m15
+    };
+}
+
+// signed distance to the near clip plane, positive is in front
+static inline float NearDistance(const Vector4& clip)
+{
+    return clip.z + clip.w;
+}
+
+static inline Vector4 LerpClip(const Vector4& a, const Vector4& b, float t)
+{
+    return Vector4{ a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t, a.w + (b.w - a.w) * t };
+}
+
+void OcclusionCuller::Begin(const Matrix& viewProjection)
+{
+    ViewProjection = viewProjection;
+    FrameStats = Stats();
+
+    if (Width < 4)
+        Width = 4;
+    if (Height < 1)
+        Height = 1;
+    if (BandHeight < 1)
+        BandHeight = 1;
+
+    // rows are padded out so the rasterizer can always write 4 pixels at a time
+    BufferWidth = (Width + 3) & ~3;
+
+    Triangles.clear();
+    DepthBuffer.assign(size_t(BufferWidth) * Height, 1.0f);
+    Levels.clear();
+}
+
+void OcclusionCuller::AddOccluderBox(const Matrix& model, const Vector3& min, const Vector3& max)
+{
+    Vector3 c[8] =
+    {
+        Vector3{ min.x, min.y, min.z }, Vector3{ max.x, min.y, min.z }, Vector3{ max.x, max.y, min.z }, Vector3{ min.x, max.y, min.z },
+        Vector3{ min.x, min.y, max.z }, Vector3{ max.x, min.y, max.z }, Vector3{ max.x, max.y, max.z }, Vector3{ min.x, max.y, max.z },
+    };
+
+    AddOccluderQuad(model, c[0], c[1], c[2], c[3]);
+    AddOccluderQuad(model, c[5], c[4], c[7], c[6]);
+    AddOccluderQuad(model, c[4], c[0], c[3], c[7]);
+    AddOccluderQuad(model, c[1], c[5], c[6], c[2]);
+    AddOccluderQuad(model, c[3], c[2], c[6], c[7]);
+    AddOccluderQuad(model, c[4], c[5], c[1], c[0]);
+}
+
+void OcclusionCuller::AddOccluderQuad(const Matrix& model, const Vector3& p0, const Vector3& p1, const Vector3& p2, const Vector3& p3)
+{
+    AddOccluderTriangle(model, p0, p1, p2);
+    AddOccluderTriangle(model, p0, p2, p3);
+}
+
+void OcclusionCuller::AddOccluderTriangle(const Matrix& model, const Vector3& p0, const Vector3& p1, const Vector3& p2)
+{
+    Matrix mvp = MatrixMultiply(model, ViewProjection);
+
+    Vector4 input[3] = { TransformToClip(mvp, p0), TransformToClip(mvp, p1), TransformToClip(mvp, p2) };
+
+    // clip against the near plane, one plane can only add one vertex
+    Vector4 clipped[4];
+    int count = 0;
+    for (int i = 0; i < 3; i++)
+    {
+        const Vector4& a = input[i];
+        const Vector4& b = input[(i + 1) % 3];
+        float da = NearDistance(a);
+        float db = NearDistance(b);
+
+        if (da >= 0)
+            clipped[count++] = a;
+
+        if ((da >= 0) != (db >= 0))
+            clipped[count++] = LerpClip(a, b, da / (da - db));
+    }
+
+    if (count < 3)
+        return;
+
+    SetupTriangle(clipped[0], clipped[1], clipped[2]);
+    if (count == 4)
+        SetupTriangle(clipped[0], clipped[2], clipped[3]);
+}
+
+void OcclusionCuller::SetupTriangle(const Vector4& c0, const Vector4& c1, const Vector4& c2)
+{
+    const Vector4* clip[3] = { &c0, &c1, &c2 };
+    float x[3], y[3], z[3];
+
+    for (int i = 0; i < 3; i++)
+    {
+        float invW = 1.0f / clip[i]->w;
+        x[i] = (clip[i]->x * invW * 0.5f + 0.5f) * Width;
+        y[i] = (0.5f - clip[i]->y * invW * 0.5f) * Height;
+        z[i] = clip[i]->z * invW * 0.5f + 0.5f;
+    }
+
+    float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+    if (fabsf(area) < 0.0001f)
+        return;
+
+    // occluders are double sided, flip so the inside is always positive
+    if (area < 0)
+    {
+        std::swap(x[1], x[2]);
+        std::swap(y[1], y[2]);
+        std::swap(z[1], z[2]);
+        area = -area;
+    }
+
+    ScreenTriangle tri;
+    tri.MinX = std::max(0, (int)floorf(std::min({ x[0], x[1], x[2] })));
+    tri.MaxX = std::min(Width - 1, (int)ceilf(std::max({ x[0], x[1], x[2] })));
+    tri.MinY = std::max(0, (int)floorf(std::min({ y[0], y[1], y[2] })));
+    tri.MaxY = std::min(Height - 1, (int)ceilf(std::max({ y[0], y[1], y[2] })));
+
+    if (tri.MinX > tri.MaxX || tri.MinY > tri.MaxY)
+        return;
+
+    for (int i = 0; i < 3; i++)
+    {
+        int next = (i + 1) % 3;
+        tri.EdgeA[i] = -(y[next] - y[i]);
+        tri.EdgeB[i] = x[next] - x[i];
+        tri.EdgeC[i] = (y[next] - y[i]) * x[i] - (x[next] - x[i]) * y[i];
+    }
+
+    tri.DepthA = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) / area;
+    tri.DepthB = ((z[2] - z[0]) * (x[1] - x[0]) - (z[1] - z[0]) * (x[2] - x[0])) / area;
+    tri.DepthC = z[0] - tri.DepthA * x[0] - tri.DepthB * y[0];
+
+    Triangles.push_back(tri);
+    FrameStats.OccluderTriangles++;
+}
+
+void OcclusionCuller::Rasterize()
+{
+    PROFILE_SCOPE("OcclusionCuller::Rasterize");
+
+    int bandCount = (Height + BandHeight - 1) / BandHeight;
+
+    if (!Triangles.empty())
+    {
+        JobSystem::ParallelFor(bandCount, [this](size_t band)
+            {
+                int start = int(band) * BandHeight;
+                RasterizeBand(start, std::min(Height, start + BandHeight));
+            });
+    }
+
+    BuildPyramid();
+}
+
+void OcclusionCuller::RasterizeBand(int startY, int endY)
+{
+    PROFILE_SCOPE("OcclusionCuller::RasterizeBand");
+
+    for (const ScreenTriangle& tri : Triangles)
+    {
+        if (tri.MaxY < startY || tri.MinY >= endY)
+            continue;
+
+        int minY = std::max(tri.MinY, startY);
+        int maxY = std::min(tri.MaxY, endY - 1);
+        int minX = tri.MinX & ~3;
+
+        for (int y = minY; y <= maxY; y++)
+        {
+            float* row = &DepthBuffer[size_t(y) * BufferWidth];
+            float py = y + 0.5f;
+
+            float rowEdge[3];
+            for (int e = 0; e < 3; e++)
+                rowEdge[e] = tri.EdgeB[e] * py + tri.EdgeC[e];
+
+            float rowDepth = tri.DepthB * py + tri.DepthC;
+
+#ifdef OCCLUSION_USE_SSE2
+            const __m128 pixelOffsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+            const __m128 zero = _mm_setzero_ps();
+
+            __m128 edgeA0 = _mm_set1_ps(tri.EdgeA[0]), edgeRow0 = _mm_set1_ps(rowEdge[0]);
+            __m128 edgeA1 = _mm_set1_ps(tri.EdgeA[1]), edgeRow1 = _mm_set1_ps(rowEdge[1]);
+            __m128 edgeA2 = _mm_set1_ps(tri.EdgeA[2]), edgeRow2 = _mm_set1_ps(rowEdge[2]);
+            __m128 depthA = _mm_set1_ps(tri.DepthA), depthRow = _mm_set1_ps(rowDepth);
+
+            for (int x = minX; x <= tri.MaxX; x += 4)
+            {
+                __m128 px = _mm_add_ps(_mm_set1_ps((float)x), pixelOffsets);
+
+                __m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA0, px), edgeRow0), zero);
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA1, px), edgeRow1), zero));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA2, px), edgeRow2), zero));
+
+                if (_mm_movemask_ps(inside) == 0)
+                    continue;
+
+                __m128 depth = _mm_add_ps(_mm_mul_ps(depthA, px), depthRow);
+                __m128 current = _mm_loadu_ps(row + x);
+                __m128 closest = _mm_min_ps(current, depth);
+
+                _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, closest), _mm_andnot_ps(inside, current)));
+            }
+#else
+            for (int x = minX; x <= tri.MaxX; x++)
+            {
+                float px = x + 0.5f;
+                if (tri.EdgeA[0] * px + rowEdge[0] < 0 || tri.EdgeA[1] * px + rowEdge[1] < 0 || tri.EdgeA[2] * px + rowEdge[2] < 0)
+                    continue;
+
+                float depth = tri.DepthA * px + rowDepth;
+                if (depth < row[x])
+                    row[x] = depth;
+            }
+#endif
+        }
+    }
+}
+
+void OcclusionCuller::BuildPyramid()
+{
+    PROFILE_SCOPE("OcclusionCuller::BuildPyramid");
+
+    DepthLevel base;
+    base.Width = Width;
+    base.Height = Height;
+    base.MinDepth.resize(size_t(Width) * Height);
+
+    for (int y = 0; y < Height; y++)
+        std::copy_n(&DepthBuffer[size_t(y) * BufferWidth], Width, &base.MinDepth[size_t(y) * Width]);
+
+    base.MaxDepth = base.MinDepth;
+    Levels.emplace_back(std::move(base));
+
+    while (Levels.back().Width > 1 || Levels.back().Height > 1)
+    {
+        const DepthLevel& source = Levels.back();
+
+        DepthLevel level;
+        level.Width = std::max(1, (source.Width + 1) / 2);
+        level.Height = std::max(1, (source.Height + 1) / 2);
+        level.MinDepth.resize(size_t(level.Width) * level.Height);
+        level.MaxDepth.resize(size_t(level.Width) * level.Height);
+
+        for (int y = 0; y < level.Height; y++)
+        {
+            int y0 = y * 2;
+            int y1 = std::min(y0 + 1, source.Height - 1);
+
+            for (int x = 0; x < level.Width; x++)
+            {
+                int x0 = x * 2;
+                int x1 = std::min(x0 + 1, source.Width - 1);
+
+                size_t s[4] = { size_t(y0) * source.Width + x0, size_t(y0) * source.Width + x1, size_t(y1) * source.Width + x0, size_t(y1) * source.Width + x1 };
+
+                size_t dest = size_t(y) * level.Width + x;
+                level.MinDepth[dest] = std::min({ source.MinDepth[s[0]], source.MinDepth[s[1]], source.MinDepth[s[2]], source.MinDepth[s[3]] });
+                level.MaxDepth[dest] = std::max({ source.MaxDepth[s[0]], source.MaxDepth[s[1]], source.MaxDepth[s[2]], source.MaxDepth[s[3]] });
+            }
+        }
+
+        Levels.emplace_back(std::move(level));
+    }
+}
+
+bool OcclusionCuller::IsVisible(const BoundingBox& worldBounds)
+{
+    FrameStats.Tested++;
+
+    const Vector3& bMin = worldBounds.min;
+    const Vector3& bMax = worldBounds.max;
+
+    float minX = 1e30f, minY = 1e30f, minZ = 1e30f;
+    float maxX = -1e30f, maxY = -1e30f;
+    int behind = 0;
+
+    for (int i = 0; i < 8; i++)
+    {
+        Vector3 corner = { (i & 1) ? bMax.x : bMin.x, (i & 2) ? bMax.y : bMin.y, (i & 4) ? bMax.z : bMin.z };
+        Vector4 clip = TransformToClip(ViewProjection, corner);
+
+        if (NearDistance(clip) < 0)
+        {
+            behind++;
+            continue;
+        }
+
+        float invW = 1.0f / clip.w;
+        minX = std::min(minX, clip.x * invW);
+        maxX = std::max(maxX, clip.x * invW);
+        minY = std::min(minY, clip.y * invW);
+        maxY = std::max(maxY, clip.y * invW);
+        minZ = std::min(minZ, clip.z * invW);
+    }
+
+    if (behind == 8)
+    {
+        FrameStats.FrustumCulled++;
+        return false;
+    }
+
+    // crosses the near plane, so the screen rect is unbounded
+    if (behind > 0)
+        return true;
+
+    if (maxX < -1 || minX > 1 || maxY < -1 || minY > 1 || minZ > 1)
+    {
+        FrameStats.FrustumCulled++;
+        return false;
+    }
+
+    if (Levels.empty())
+        return true;
+
+    float nearDepth = minZ * 0.5f + 0.5f;
+
+    int px0 = std::clamp((int)floorf((minX * 0.5f + 0.5f) * Width), 0, Width - 1);
+    int px1 = std::clamp((int)floorf((maxX * 0.5f + 0.5f) * Width), 0, Width - 1);
+    int py0 = std::clamp((int)floorf((0.5f - maxY * 0.5f) * Height), 0, Height - 1);
+    int py1 = std::clamp((int)floorf((0.5f - minY * 0.5f) * Height), 0, Height - 1);
+
+    // start at the level where the rect covers about 2x2 texels and refine down
+    int size = std::max(px1 - px0 + 1, py1 - py0 + 1);
+    int level = 0;
+    while ((size >> level) > 2 && level < GetLevelCount() - 1)
+        level++;
+
+    for (; level >= 0; level--)
+    {
+        const DepthLevel& depth = Levels[level];
+
+        int lx0 = px0 >> level, lx1 = px1 >> level;
+        int ly0 = py0 >> level, ly1 = py1 >> level;
+
+        // not worth scanning this many texels, assume visible
+        if ((lx1 - lx0 + 1) * (ly1 - ly0 + 1) > 64)
+            break;
+
+        float regionMin = 1;
+        float regionMax = 0;
+        for (int y = ly0; y <= ly1; y++)
+        {
+            for (int x = lx0; x <= lx1; x++)
+            {
+                size_t index = size_t(y) * depth.Width + x;
+                regionMin = std::min(regionMin, depth.MinDepth[index]);
+                regionMax = std::max(regionMax, depth.MaxDepth[index]);
+            }
+        }
+
+        // the nearest point is behind the farthest occluder in the region
+        if (nearDepth > regionMax)
+        {
+            FrameStats.OcclusionCulled++;
+            return false;
+        }
+
+        // the nearest point is in front of every occluder in the region
+        if (nearDepth <= regionMin)
+            return true;
+    }
+
+    return true;
+}
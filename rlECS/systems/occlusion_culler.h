@@ -0,0 +1,125 @@
+/**********************************************************************************************
+*
+*   raylib_ECS_sample * a sample Entity Component System using raylib
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+
+#pragma once
+
+#include "raylib.h"
+
+#include <stdint.h>
+#include <vector>
+
+// CPU only occlusion culling
+// a small set of occluder shapes are rasterized into a low resolution depth buffer,
+// a min/max depth pyramid is built from it, and screen space bounds of drawables are tested against that
+class OcclusionCuller
+{
+public:
+    int Width = 256;
+    int Height = 128;
+
+    // rows of the depth buffer rasterized by each job
+    int BandHeight = 16;
+
+    struct Stats
+    {
+        size_t OccluderTriangles = 0;
+        size_t Tested = 0;
+        size_t FrustumCulled = 0;
+        size_t OcclusionCulled = 0;
+    };
+
+public:
+    // start a new frame, clears all occluders and the depth buffer
+    void Begin(const Matrix& viewProjection);
+
+    // add a box in local space, transformed by a model matrix
+    void AddOccluderBox(const Matrix& model, const Vector3& min, const Vector3& max);
+
+    // add a quad in local space, corners are in winding order
+    void AddOccluderQuad(const Matrix& model, const Vector3& p0, const Vector3& p1, const Vector3& p2, const Vector3& p3);
+
+    void AddOccluderTriangle(const Matrix& model, const Vector3& p0, const Vector3& p1, const Vector3& p2);
+
+    // rasterize all the occluders and build the depth pyramid
+    void Rasterize();
+
+    // returns false if the world space box is outside the view or fully behind the occluders
+    bool IsVisible(const BoundingBox& worldBounds);
+
+    inline const Stats& GetStats() const { return FrameStats; }
+
+    inline int GetLevelCount() const { return (int)Levels.size(); }
+    inline int GetLevelWidth(int level) const { return Levels[level].Width; }
+    inline int GetLevelHeight(int level) const { return Levels[level].Height; }
+
+    // depth values are 0 at the near plane and 1 at the far plane
+    inline const std::vector<float>& GetMinDepth(int level) const { return Levels[level].MinDepth; }
+    inline const std::vector<float>& GetMaxDepth(int level) const { return Levels[level].MaxDepth; }
+
+private:
+    struct ScreenTriangle
+    {
+        // edge functions, e = A*x + B*y + C, inside when all are >= 0
+        float EdgeA[3];
+        float EdgeB[3];
+        float EdgeC[3];
+
+        // depth plane, z = A*x + B*y + C
+        float DepthA;
+        float DepthB;
+        float DepthC;
+
+        int MinX;
+        int MinY;
+        int MaxX;
+        int MaxY;
+    };
+
+    struct DepthLevel
+    {
+        int Width = 0;
+        int Height = 0;
+        std::vector<float> MinDepth;
+        std::vector<float> MaxDepth;
+    };
+
+    Matrix ViewProjection = { 0 };
+    int BufferWidth = 0;
+
+    std::vector<ScreenTriangle> Triangles;
+    std::vector<float> DepthBuffer;
+    std::vector<DepthLevel> Levels;
+
+    Stats FrameStats;
+
+private:
+    void SetupTriangle(const Vector4& c0, const Vector4& c1, const Vector4& c2);
+    void RasterizeBand(int startY, int endY);
+    void BuildPyramid();
+};
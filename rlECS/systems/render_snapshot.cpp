@@ -0,0 +1,79 @@
+/**********************************************************************************************
+*
+*   raylib_ECS_sample * a sample Entity Component System using raylib
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+
+#include "systems/render_snapshot.h"
+#include "render_backend.h"
+
+#include "raylib.h"
+
+#include <algorithm>
+
+RenderSnapshot& RenderSnapshotBuffer::BeginWrite()
+{
+    RenderSnapshot& snapshot = Snapshots[1 - PublishedIndex.load()];
+    snapshot.Clear();
+    snapshot.FrameId = NextFrameId++;
+    return snapshot;
+}
+
+void RenderSnapshotBuffer::Publish()
+{
+    PublishedIndex = 1 - PublishedIndex.load();
+}
+
+void DrawRenderShape(const RenderShape& shape)
+{
+    RenderBackend& backend = RenderBackend::Get();
+
+    backend.PushMatrix();
+    backend.MultMatrix(shape.Transform);
+
+    switch (shape.Shape)
+    {
+    case DrawShape::Box:
+        backend.DrawCube(shape.Origin, shape.Size.x, shape.Size.y, shape.Size.z, shape.Tint);
+        break;
+    case DrawShape::Sphere:
+        backend.DrawSphere(shape.Origin, std::max(std::max(shape.Size.x, shape.Size.y), shape.Size.z), shape.Tint);
+        break;
+    case DrawShape::Cylinder:
+        backend.DrawCylinder(shape.Origin, shape.Size.x, shape.Size.y, shape.Size.z, 32, shape.Tint);
+        break;
+    case DrawShape::Plane:
+        backend.SetBackfaceCulling(false);
+        backend.DrawPlane(shape.Origin, Vector2{ shape.Size.x, shape.Size.y }, shape.Tint);
+        backend.Flush();
+        backend.SetBackfaceCulling(true);
+        break;
+    default:
+        break;
+    }
+
+    backend.PopMatrix();
+}
@@ -0,0 +1,124 @@
+/**********************************************************************************************
+*
+*   raylib_ECS_sample * a sample Entity Component System using raylib
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+
+#pragma once
+
+#include "raylib.h"
+
+#include <atomic>
+#include <stdint.h>
+#include <vector>
+
+class DrawableComponent;
+
+enum class DrawShape
+{
+    Box,
+    Sphere,
+    Cylinder,
+    Plane
+};
+
+// everything needed to draw one shape, copied out of the components so it can be drawn while they change
+struct RenderShape
+{
+    Matrix Transform = { 0 };      // stored transposed, ready for rlMultMatrixf
+    Vector3 Origin = { 0, 0, 0 };
+    Vector3 Size = { 1, 1, 1 };
+    Color Tint = WHITE;
+    DrawShape Shape = DrawShape::Box;
+
+    // index into the snapshot's light sets
+    uint32_t LightSet = 0;
+};
+
+struct RenderLight
+{
+    int Slot = -1;      // stable id from the lighting system's slot allocator
+    int Type = 0;
+    Vector3 Position = { 0, 0, 0 };
+    Vector3 Target = { 0, 0, 0 };
+    float Range = 0;
+    Color LightColor = WHITE;
+};
+
+// the lights a group of shapes is drawn with, as indexes into the snapshot's lights, -1 is unused
+struct RenderLightSet
+{
+    static constexpr int Count = 4;
+    int Lights[Count] = { -1, -1, -1, -1 };
+};
+
+// a copy of the render state for one frame, built on the main thread and drawn without touching any entities
+struct RenderSnapshot
+{
+    uint64_t FrameId = 0;
+
+    Camera3D ViewCam = { 0 };
+    Matrix ViewProjection = { 0 };
+
+    std::vector<RenderShape> Shapes;
+    std::vector<RenderLight> Lights;
+    std::vector<RenderLightSet> LightSets;
+
+    // drawables that can't copy themselves out, these are drawn from the live components
+    std::vector<DrawableComponent*> LiveDrawables;
+
+    // where the editor draws selection gizmos, stored transposed like the shapes
+    std::vector<Matrix> Gizmos;
+
+    inline void Clear()
+    {
+        Shapes.clear();
+        Lights.clear();
+        LightSets.clear();
+        LiveDrawables.clear();
+        Gizmos.clear();
+    }
+};
+
+// two snapshots, one being filled in while the other is drawn
+class RenderSnapshotBuffer
+{
+public:
+    // clears and returns the snapshot that is not published
+    RenderSnapshot& BeginWrite();
+
+    // makes the last written snapshot the one that gets drawn
+    void Publish();
+
+    inline const RenderSnapshot& GetPublished() const { return Snapshots[PublishedIndex.load()]; }
+
+private:
+    RenderSnapshot Snapshots[2];
+    std::atomic<int> PublishedIndex = { 0 };
+    uint64_t NextFrameId = 1;
+};
+
+void DrawRenderShape(const RenderShape& shape);
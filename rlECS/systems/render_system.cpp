@@ -33,10 +33,15 @@
 #include "systems/render_system.h"
 #include "systems/lighting_system.h"
 
+#include "profiler.h"
+#include "render_backend.h"
+
 #include "raylib.h"
+#include "raymath.h"
+#include "rlgl.h"
 
 
-void RenderSystem::Begin(uint64_t cameraEntityId)
+void RenderSystem::SetupView(uint64_t cameraEntityId, int viewportWidth, int viewportHeight)
 {
     CameraComponent* camera = Entities.MustGetComponent<CameraComponent>(cameraEntityId);
     ViewCam.fovy = 45;
@@ -49,20 +54,117 @@ void RenderSystem::Begin(uint64_t cameraEntityId)
     ViewCam.target = Vector3Add(cameraTransform->GetPosition(), cameraTransform->GetForwardVector());
     ViewCam.up = cameraTransform->GetUpVector();
 
-    BeginMode3D(ViewCam);
+    if (viewportWidth <= 0 || viewportHeight <= 0)
+    {
+        viewportWidth = RenderBackend::Get().GetScreenWidth();
+        viewportHeight = RenderBackend::Get().GetScreenHeight();
+    }
+
+    // same projection that BeginMode3D will use
+    float aspect = viewportHeight > 0 ? viewportWidth / (float)viewportHeight : 1.0f;
+    Matrix projection = MatrixPerspective(ViewCam.fovy * DEG2RAD, aspect, RL_CULL_DISTANCE_NEAR, RL_CULL_DISTANCE_FAR);
+    ViewProjection = MatrixMultiply(MatrixLookAt(ViewCam.position, ViewCam.target, ViewCam.up), projection);
 }
 
-void RenderSystem::Draw()
+void RenderSystem::Begin(uint64_t cameraEntityId, int viewportWidth, int viewportHeight)
 {
-    // TODO, get the visible set
-    Entities.DoForEachEntity<DrawableComponent>([](DrawableComponent* drawable)
+    SetupView(cameraEntityId, viewportWidth, viewportHeight);
+    RenderBackend::Get().BeginMode3D(ViewCam);
+}
+
+void RenderSystem::GetVisibleSet(std::vector<DrawableComponent*>& visible)
+{
+    visible.clear();
+
+    if (!UseOcclusionCulling)
+    {
+        Entities.DoForEachEntity<DrawableComponent>([&visible](DrawableComponent* drawable)
+            {
+                if (drawable->Active)
+                    visible.push_back(drawable);
+            });
+        return;
+    }
+
+    Culler.Begin(ViewProjection);
+
+    // occluders go in first and are always drawn
+    Entities.DoForEachEntity<DrawableComponent>([this, &visible](DrawableComponent* drawable)
         {
-            if (drawable->Active)
-                drawable->Draw();
+            if (!drawable->Active || !drawable->IsOccluder())
+                return;
+
+            drawable->AddOccluder(Culler);
+            visible.push_back(drawable);
+        });
+
+    Culler.Rasterize();
+
+    BoundingBox bounds = { 0 };
+    Entities.DoForEachEntity<DrawableComponent>([this, &visible, &bounds](DrawableComponent* drawable)
+        {
+            if (!drawable->Active || drawable->IsOccluder())
+                return;
+
+            if (!drawable->GetWorldBounds(bounds) || Culler.IsVisible(bounds))
+                visible.push_back(drawable);
         });
 }
 
+void RenderSystem::Draw()
+{
+    PROFILE_SCOPE("RenderSystem::Draw");
+
+    GetVisibleSet(VisibleSet);
+
+    for (DrawableComponent* drawable : VisibleSet)
+        drawable->Draw();
+}
+
 void RenderSystem::End()
 {
-    EndMode3D();
+    RenderBackend::Get().EndMode3D();
+}
+
+void RenderSystem::Extract(uint64_t cameraEntityId, RenderSnapshot& snapshot, int viewportWidth, int viewportHeight)
+{
+    PROFILE_SCOPE("RenderSystem::Extract");
+
+    SetupView(cameraEntityId, viewportWidth, viewportHeight);
+    snapshot.ViewCam = ViewCam;
+    snapshot.ViewProjection = ViewProjection;
+
+    GetVisibleSet(VisibleSet);
+    for (DrawableComponent* drawable : VisibleSet)
+    {
+        if (!drawable->Extract(snapshot))
+            snapshot.LiveDrawables.push_back(drawable);
+    }
+    PROFILE_COUNTER("Visible Shapes", snapshot.Shapes.size());
+}
+
+void RenderSystem::Begin(const RenderSnapshot& snapshot)
+{
+    RenderBackend::Get().BeginMode3D(snapshot.ViewCam);
+}
+
+void RenderSystem::Draw(const RenderSnapshot& snapshot, std::function<void(const RenderLightSet&)> bindLights)
+{
+    PROFILE_SCOPE("RenderSystem::Draw");
+
+    uint32_t boundLightSet = UINT32_MAX;
+    for (const RenderShape& shape : snapshot.Shapes)
+    {
+        if (bindLights && shape.LightSet < snapshot.LightSets.size() && shape.LightSet != boundLightSet)
+        {
+            // light uniforms apply to the whole batch, so the shapes before have to go out first
+            RenderBackend::Get().Flush();
+            bindLights(snapshot.LightSets[shape.LightSet]);
+            boundLightSet = shape.LightSet;
+        }
+        DrawRenderShape(shape);
+    }
+
+    for (DrawableComponent* drawable : snapshot.LiveDrawables)
+        drawable->Draw();
 }
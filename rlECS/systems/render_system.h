@@ -30,19 +30,49 @@
 
 #include "entity_manager.h"
 #include "system_manager.h"
+#include "systems/occlusion_culler.h"
+#include "systems/render_snapshot.h"
 
 #include "raylib.h"
 
+#include <functional>
+#include <vector>
+
+class DrawableComponent;
+
 // an example system that renders all drawables
 class RenderSystem : public System
 {
 public:
     DEFINE_SYSTEM(RenderSystem);
 
-    void Begin(uint64_t cameraEntityId);
+    // test drawables against occluder shapes before drawing them
+    bool UseOcclusionCulling = false;
+
+    // computes the view for a camera without touching the GPU, a size of 0 uses the screen size
+    void SetupView(uint64_t cameraEntityId, int viewportWidth = 0, int viewportHeight = 0);
+
+    void Begin(uint64_t cameraEntityId, int viewportWidth = 0, int viewportHeight = 0);
     void Draw();
     void End();
 
+    // copies the visible drawables for a camera into a snapshot, so they can be drawn while the entities update
+    void Extract(uint64_t cameraEntityId, RenderSnapshot& snapshot, int viewportWidth = 0, int viewportHeight = 0);
+
+    void Begin(const RenderSnapshot& snapshot);
+    // bindLights is called before each group of shapes that share the same lights
+    void Draw(const RenderSnapshot& snapshot, std::function<void(const RenderLightSet&)> bindLights = nullptr);
+
+    // collects the drawables that pass culling for the current view
+    void GetVisibleSet(std::vector<DrawableComponent*>& visible);
+
+    inline OcclusionCuller& GetOcclusionCuller() { return Culler; }
+    inline const Matrix& GetViewProjection() const { return ViewProjection; }
+
 private:
     Camera3D ViewCam = { 0 };
+    Matrix ViewProjection = { 0 };
+
+    OcclusionCuller Culler;
+    std::vector<DrawableComponent*> VisibleSet;
 };
\ No newline at end of file
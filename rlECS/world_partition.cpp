@@ -0,0 +1,487 @@
+/**********************************************************************************************
+*
+*   raylib_ECS_sample * a sample Entity Component System using raylib
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+
+#include "world_partition.h"
+#include "profiler.h"
+#include "components/camera_component.h"
+#include "components/transform_component.h"
+#include "components/world_cell_component.h"
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+
+namespace WorldPartition
+{
+    // what an entity and a component take on top of their data, for the map nodes and lists they are kept in
+    static constexpr size_t EntityOverhead = sizeof(Entity) + 64;
+    static constexpr size_t ComponentOverhead = sizeof(Component) + 64;
+
+    WorldCell GetCell(const Vector3& position, float cellSize)
+    {
+        return WorldCell{ int32_t(floorf(position.x / cellSize)), int32_t(floorf(position.z / cellSize)) };
+    }
+
+    std::string GetCellFileName(const std::string& baseName, const WorldCell& cell)
+    {
+        return baseName + "_" + std::to_string(cell.X) + "_" + std::to_string(cell.Z) + ".rlsc";
+    }
+
+    std::string GetIndexFileName(const std::string& baseName)
+    {
+        return baseName + ".rlwp";
+    }
+
+    // building
+
+    Builder::Builder(const char* baseName, float cellSize) : BaseName(baseName), CellSize(cellSize)
+    {
+    }
+
+    bool Builder::AddWorld(EntitySet& world)
+    {
+        PROFILE_SCOPE("WorldPartition::AddWorld");
+
+        std::map<WorldCell, std::vector<EntityId_t>> cellRoots;
+        world.DoForEachRootEntity([this, &world, &cellRoots](EntityId_t root)
+            {
+                TransformComponent* transform = world.GetComponent<TransformComponent>(root);
+                Vector3 position = transform != nullptr ? transform->GetWorldPosition() : Vector3{ 0, 0, 0 };
+                cellRoots[GetCell(position, CellSize)].push_back(root);
+            });
+
+        bool ok = true;
+        std::vector<EntityId_t> ids;
+        std::vector<uint8_t> data;
+        for (auto& cellRoot : cellRoots)
+        {
+            // the whole hierarchy under each root, in id order so it goes into the cell's set the way a load would
+            ids.clear();
+            std::vector<EntityId_t> open = cellRoot.second;
+            while (!open.empty())
+            {
+                EntityId_t id = open.back();
+                open.pop_back();
+                ids.push_back(id);
+
+                Entity* entity = world.GetEntity(id);
+                open.insert(open.end(), entity->Children.begin(), entity->Children.end());
+            }
+            std::sort(ids.begin(), ids.end());
+
+            EntitySet cellEntities;
+            for (EntityId_t id : ids)
+            {
+                Entity* entity = world.GetEntity(id);
+                cellEntities.LoadEntity(id, entity->Parent, entity->Children.data(), entity->Children.size());
+
+                const char* name = world.GetEntityName(id);
+                if (name != nullptr && name[0] != 0)
+                    cellEntities.SetEntityName(id, name);
+
+                world.DoForEachComponentInEntity(id, [&cellEntities, &data, id](Component* component)
+                    {
+                        const ComponentInfo* info = ComponentManager::FindComponentInfo(component->ComponentName());
+                        if (info == nullptr)
+                            return;
+
+                        Component* copy = info->Factory(id, cellEntities);
+                        data.resize(component->GetDataSize());
+                        if (!data.empty())
+                        {
+                            component->SaveData(data.data());
+                            copy->LoadData(data.data());
+                        }
+                        copy->Active = component->Active;
+                        cellEntities.StoreComponent(copy->Id(), copy);
+                    });
+            }
+
+            ok = AddCell(cellRoot.first, cellEntities) && ok;
+        }
+
+        return ok;
+    }
+
+    bool Builder::AddCell(const WorldCell& cell, EntitySet& cellEntities)
+    {
+        std::vector<EntityId_t> roots;
+        cellEntities.DoForEachRootEntity([&roots](EntityId_t root) { roots.push_back(root); });
+        for (EntityId_t root : roots)
+        {
+            WorldCellComponent* tag = cellEntities.GetComponent<WorldCellComponent>(root);
+            if (tag == nullptr)
+                tag = cellEntities.AddComponent<WorldCellComponent>(root);
+
+            tag->CellX = cell.X;
+            tag->CellZ = cell.Z;
+        }
+
+        CellRecord record;
+        record.X = cell.X;
+        record.Z = cell.Z;
+        cellEntities.DoForEachEntityRecord([this, &cellEntities, &record](Entity& entity)
+            {
+                record.Entities++;
+                record.EstimatedBytes += EntityOverhead + entity.Children.capacity() * sizeof(EntityId_t);
+                HighestId = std::max(HighestId, entity.Id);
+
+                cellEntities.DoForEachComponentInEntity(entity.Id, [&record](Component* component)
+                    {
+                        record.Components++;
+                        record.EstimatedBytes += ComponentOverhead + component->GetDataSize();
+                    });
+            });
+
+        if (!SceneFile::Save(cellEntities, GetCellFileName(BaseName, cell).c_str()))
+        {
+            Failed = true;
+            return false;
+        }
+
+        Cells[cell] = record;
+        return true;
+    }
+
+    bool Builder::Finish()
+    {
+        FILE* fp = fopen(GetIndexFileName(BaseName).c_str(), "wb");
+        if (fp == nullptr)
+            return false;
+
+        IndexHeader header;
+        header.CellSize = CellSize;
+        header.CellCount = uint32_t(Cells.size());
+        header.HighestId = HighestId;
+
+        bool ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+        for (auto itr = Cells.begin(); ok && itr != Cells.end(); ++itr)
+            ok = fwrite(&itr->second, sizeof(CellRecord), 1, fp) == 1;
+
+        ok = fclose(fp) == 0 && ok;
+        return ok && !Failed;
+    }
+
+    // streaming
+
+    Streamer::Streamer(EntitySet& entities) : Entities(entities)
+    {
+    }
+
+    Streamer::~Streamer()
+    {
+        // loads still running are cancelled by their loaders, what is in the set stays there
+    }
+
+    bool Streamer::Open(const char* baseName)
+    {
+        if (IsOpen())
+            Close();
+
+        FILE* fp = fopen(GetIndexFileName(baseName).c_str(), "rb");
+        if (fp == nullptr)
+            return false;
+
+        IndexHeader header;
+        bool ok = fread(&header, sizeof(header), 1, fp) == 1 && header.Magic == Magic && header.Version == Version && header.CellSize > 0;
+
+        std::vector<CellRecord> records(ok ? header.CellCount : 0);
+        if (ok && !records.empty())
+            ok = fread(records.data(), sizeof(CellRecord), records.size(), fp) == records.size();
+        fclose(fp);
+
+        if (!ok)
+            return false;
+
+        // runtime entities get ids past the world's, so loading a cell never finds its ids taken
+        EntityId_t next = Entities.ReserveEntityIds(0);
+        if (header.HighestId >= next)
+            Entities.ReserveEntityIds(header.HighestId + 1 - next);
+
+        BaseName = baseName;
+        CellSize = header.CellSize;
+        for (const CellRecord& record : records)
+            Cells[WorldCell{ record.X, record.Z }].Record = record;
+
+        CurrentStats = Stats();
+        return true;
+    }
+
+    void Streamer::Close()
+    {
+        for (Cell* cell : Resident)
+        {
+            if (cell->Loader != nullptr)
+            {
+                while (cell->Loader->Update(1000))
+                    continue;
+                cell->Loader.reset();
+            }
+
+            StartUnload(*cell);
+            for (EntityId_t root : cell->Roots)
+                Entities.RemoveEntity(root, true);
+        }
+
+        Resident.clear();
+        Cells.clear();
+        BaseName.clear();
+        CellSize = 0;
+        UpdateStats();
+    }
+
+    bool Streamer::IsCellLoaded(const WorldCell& cell) const
+    {
+        auto itr = Cells.find(cell);
+        return itr != Cells.end() && itr->second.State == CellState::Loaded;
+    }
+
+    // to the nearest point of the cell on the ground plane
+    float Streamer::GetDistance(const Cell& cell, const Vector3& position) const
+    {
+        float minX = cell.Record.X * CellSize;
+        float minZ = cell.Record.Z * CellSize;
+        float dx = std::max(std::max(minX - position.x, position.x - (minX + CellSize)), 0.0f);
+        float dz = std::max(std::max(minZ - position.z, position.z - (minZ + CellSize)), 0.0f);
+        return sqrtf(dx * dx + dz * dz);
+    }
+
+    void Streamer::StartLoad(Cell& cell)
+    {
+        cell.Loader = std::make_unique<SceneFile::StreamingLoader>();
+        cell.Loader->Begin(Entities, GetCellFileName(BaseName, WorldCell{ cell.Record.X, cell.Record.Z }).c_str());
+        cell.State = CellState::Loading;
+        Resident.push_back(&cell);
+    }
+
+    void Streamer::StartUnload(Cell& cell)
+    {
+        // a cell is only unloaded once it is all in, so every root it loaded has its tag
+        cell.Roots.clear();
+        Entities.DoForEachEntity<WorldCellComponent>([&cell](WorldCellComponent* tag)
+            {
+                if (tag->CellX == cell.Record.X && tag->CellZ == cell.Record.Z)
+                    cell.Roots.push_back(tag->EntityId);
+            });
+
+        cell.State = CellState::Unloading;
+    }
+
+    void Streamer::MakeRoom(size_t bytes, const Vector3& position)
+    {
+        // only loaded cells outside the load radius can go early, the furthest first
+        std::vector<Cell*> candidates;
+        size_t used = 0;
+        for (Cell* cell : Resident)
+        {
+            if (cell->State != CellState::Unloading)
+                used += size_t(cell->Record.EstimatedBytes);
+
+            if (cell->State == CellState::Loaded && GetDistance(*cell, position) > LoadRadius)
+                candidates.push_back(cell);
+        }
+
+        std::sort(candidates.begin(), candidates.end(), [](const Cell* a, const Cell* b) { return a->Distance > b->Distance; });
+        for (Cell* cell : candidates)
+        {
+            if (used + bytes <= MemoryBudgetBytes)
+                break;
+
+            StartUnload(*cell);
+            used -= size_t(cell->Record.EstimatedBytes);
+        }
+    }
+
+    void Streamer::Update(double budgetMs)
+    {
+        EntityId_t camera = CameraEntity;
+        if (camera == InvalidEntityId)
+        {
+            Entities.DoForEachEntity<CameraComponent>([&camera](CameraComponent* component)
+                {
+                    if (camera == InvalidEntityId && component->Active)
+                        camera = component->EntityId;
+                });
+        }
+
+        TransformComponent* transform = camera != InvalidEntityId ? Entities.GetComponent<TransformComponent>(camera) : nullptr;
+        Update(transform != nullptr ? transform->GetWorldPosition() : LastViewPosition, budgetMs);
+    }
+
+    void Streamer::Update(const Vector3& viewPosition, double budgetMs)
+    {
+        if (!IsOpen())
+            return;
+
+        PROFILE_SCOPE("WorldPartition::Update");
+        auto start = std::chrono::high_resolution_clock::now();
+        LastViewPosition = viewPosition;
+
+        // cells that were left behind, a cell that is still loading is unloaded once it is in
+        for (Cell* cell : Resident)
+        {
+            cell->Distance = GetDistance(*cell, viewPosition);
+            if (cell->State == CellState::Loaded && cell->Distance > UnloadRadius)
+                StartUnload(*cell);
+        }
+
+        // cells to load, nearest first
+        std::vector<Cell*> wanted;
+        WorldCell first = GetCell(Vector3{ viewPosition.x - LoadRadius, 0, viewPosition.z - LoadRadius }, CellSize);
+        WorldCell last = GetCell(Vector3{ viewPosition.x + LoadRadius, 0, viewPosition.z + LoadRadius }, CellSize);
+        for (int32_t x = first.X; x <= last.X; x++)
+        {
+            for (int32_t z = first.Z; z <= last.Z; z++)
+            {
+                auto itr = Cells.find(WorldCell{ x, z });
+                if (itr == Cells.end() || itr->second.State != CellState::Unloaded)
+                    continue;
+
+                Cell& cell = itr->second;
+                cell.Distance = GetDistance(cell, viewPosition);
+                if (cell.Distance <= LoadRadius)
+                    wanted.push_back(&cell);
+            }
+        }
+        std::sort(wanted.begin(), wanted.end(), [](const Cell* a, const Cell* b) { return a->Distance < b->Distance; });
+
+        size_t loading = 0;
+        size_t used = 0;
+        for (Cell* cell : Resident)
+        {
+            used += size_t(cell->Record.EstimatedBytes);
+            if (cell->State == CellState::Loading)
+                loading++;
+        }
+
+        size_t started = 0;
+        for (Cell* cell : wanted)
+        {
+            if (loading >= MaxConcurrentLoads)
+                break;
+
+            // room is made by unloading cells further out, the memory only comes back once they are gone
+            if (used + cell->Record.EstimatedBytes > MemoryBudgetBytes)
+            {
+                MakeRoom(size_t(cell->Record.EstimatedBytes), viewPosition);
+                continue;
+            }
+
+            StartLoad(*cell);
+            used += size_t(cell->Record.EstimatedBytes);
+            loading++;
+            started++;
+        }
+        CurrentStats.WantedCells = wanted.size() - started;
+
+        // unloading goes first since it gives memory back, a root is taken out in every update
+        bool outOfTime = false;
+        for (Cell* cell : Resident)
+        {
+            if (cell->State != CellState::Unloading)
+                continue;
+
+            while (!cell->Roots.empty() && !outOfTime)
+            {
+                Entities.RemoveEntity(cell->Roots.back(), true);
+                cell->Roots.pop_back();
+                outOfTime = Profiler::MillisecondsSince(start) >= budgetMs;
+            }
+
+            if (cell->Roots.empty())
+            {
+                cell->State = cell->LoadFailed ? CellState::Failed : CellState::Unloaded;
+                if (cell->LoadFailed)
+                    CurrentStats.FailedCells++;
+                else
+                    CurrentStats.CellsUnloaded++;
+            }
+        }
+
+        // then the nearest loads get what time is left, the nearest one always gets a batch in
+        std::vector<Cell*> loads;
+        for (Cell* cell : Resident)
+        {
+            if (cell->State == CellState::Loading)
+                loads.push_back(cell);
+        }
+        std::sort(loads.begin(), loads.end(), [](const Cell* a, const Cell* b) { return a->Distance < b->Distance; });
+
+        for (size_t i = 0; i < loads.size(); i++)
+        {
+            double remainingMs = budgetMs - Profiler::MillisecondsSince(start);
+            if (i > 0 && remainingMs <= 0)
+                break;
+
+            Cell& cell = *loads[i];
+            if (cell.Loader->Update(std::max(remainingMs, 0.0)))
+                continue;
+
+            // a file that couldn't be read all the way is taken out again and not tried again
+            cell.LoadFailed = !cell.Loader->GetLastResult();
+            cell.Loader.reset();
+            cell.State = CellState::Loaded;
+            if (!cell.LoadFailed)
+                CurrentStats.CellsLoaded++;
+
+            if (cell.LoadFailed || cell.Distance > UnloadRadius)
+                StartUnload(cell);
+        }
+
+        Resident.erase(std::remove_if(Resident.begin(), Resident.end(), [](const Cell* cell)
+            {
+                return cell->State == CellState::Unloaded || cell->State == CellState::Failed;
+            }), Resident.end());
+
+        UpdateStats();
+        CurrentStats.LastUpdateMs = Profiler::MillisecondsSince(start);
+    }
+
+    void Streamer::UpdateStats()
+    {
+        CurrentStats.LoadedCells = 0;
+        CurrentStats.LoadingCells = 0;
+        CurrentStats.UnloadingCells = 0;
+        CurrentStats.EstimatedBytes = 0;
+
+        for (Cell* cell : Resident)
+        {
+            CurrentStats.EstimatedBytes += size_t(cell->Record.EstimatedBytes);
+            if (cell->State == CellState::Loaded)
+                CurrentStats.LoadedCells++;
+            else if (cell->State == CellState::Loading)
+                CurrentStats.LoadingCells++;
+            else if (cell->State == CellState::Unloading)
+                CurrentStats.UnloadingCells++;
+        }
+
+        CurrentStats.PeakEstimatedBytes = std::max(CurrentStats.PeakEstimatedBytes, CurrentStats.EstimatedBytes);
+    }
+}
@@ -0,0 +1,222 @@
+/**********************************************************************************************
+*
+*   raylib_ECS_sample * a sample Entity Component System using raylib
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+
+#pragma once
+
+#include "entity_manager.h"
+#include "scene_file.h"
+
+#include "raylib.h"
+
+#include <map>
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// open worlds split into square cells on the ground plane, each saved as its own scene file so it can be loaded and
+// unloaded on its own, with an index file that lists the cells
+// a hierarchy stays whole in the cell its root is in, so no parent / child link crosses cells, and entity ids are
+// kept as they were in the world, so references between entities work again once both of them are loaded
+namespace WorldPartition
+{
+    constexpr uint32_t Magic = 0x50574C52;      // "RLWP"
+    constexpr uint32_t Version = 1;
+
+    struct WorldCell
+    {
+        int32_t X = 0;
+        int32_t Z = 0;
+
+        inline bool operator == (const WorldCell& other) const { return X == other.X && Z == other.Z; }
+        inline bool operator < (const WorldCell& other) const { return X < other.X || (X == other.X && Z < other.Z); }
+    };
+
+    struct IndexHeader
+    {
+        uint32_t Magic = WorldPartition::Magic;
+        uint32_t Version = WorldPartition::Version;
+        float CellSize = 0;
+        uint32_t CellCount = 0;             // CellRecord[CellCount] follow the header
+        uint64_t HighestId = 0;             // ids above this are free for entities made at runtime
+    };
+
+    struct CellRecord
+    {
+        int32_t X = 0;
+        int32_t Z = 0;
+        uint64_t Entities = 0;
+        uint64_t Components = 0;
+        uint64_t EstimatedBytes = 0;        // roughly what the cell takes once it is loaded
+    };
+
+    // the cell a point on the ground plane is in
+    WorldCell GetCell(const Vector3& position, float cellSize);
+
+    // the scene file of one cell, "<base>_<x>_<z>.rlsc", the index is "<base>.rlwp"
+    std::string GetCellFileName(const std::string& baseName, const WorldCell& cell);
+    std::string GetIndexFileName(const std::string& baseName);
+
+    /// <summary>
+    /// Writes a world out as cells. A whole world can be split by where the root of each hierarchy is,
+    /// or a world too big to hold at once can be made and added a cell at a time.
+    /// </summary>
+    class Builder
+    {
+    public:
+        Builder(const char* baseName, float cellSize);
+
+        /// <summary>
+        /// Split a world by the world position of each root, roots without a transform go in the cell at the origin
+        /// </summary>
+        /// <returns>False if a cell file couldn't be written</returns>
+        bool AddWorld(EntitySet& world);
+
+        /// <summary>
+        /// Write one cell from a set that holds only that cell, its roots are tagged with a WorldCellComponent
+        /// Ids must not be used again in another cell, give each cell's set ids past the last one with ReserveEntityIds
+        /// </summary>
+        bool AddCell(const WorldCell& cell, EntitySet& cellEntities);
+
+        /// <summary>
+        /// Write the index, call once every cell was added
+        /// </summary>
+        bool Finish();
+
+        inline size_t GetCellCount() const { return Cells.size(); }
+
+    private:
+        std::string BaseName;
+        float CellSize = 0;
+        std::map<WorldCell, CellRecord> Cells;
+        EntityId_t HighestId = 0;
+        bool Failed = false;
+    };
+
+    /// <summary>
+    /// Loads the cells around a camera into an entity set and unloads the ones it left behind.
+    /// The nearest cells are loaded first, a few at a time, and a cell is only unloaded once it is further away than
+    /// it was when it was loaded, so cells on the edge don't go in and out as the camera moves back and forth.
+    /// Cells are opened and decoded on workers by SceneFile::StreamingLoader, and the main thread puts them in and
+    /// takes them out within the time it is given for the frame.
+    /// </summary>
+    class Streamer
+    {
+    public:
+        struct Stats
+        {
+            size_t LoadedCells = 0;
+            size_t LoadingCells = 0;
+            size_t UnloadingCells = 0;
+            size_t WantedCells = 0;         // in the load radius but waiting for a load slot or memory
+            size_t FailedCells = 0;         // files that couldn't be read, they are not tried again
+
+            size_t CellsLoaded = 0;         // since the world was opened
+            size_t CellsUnloaded = 0;
+
+            size_t EstimatedBytes = 0;      // cells that are loaded, loading or not yet unloaded
+            size_t PeakEstimatedBytes = 0;
+
+            double LastUpdateMs = 0;
+        };
+
+        Streamer(EntitySet& entities);
+        ~Streamer();
+
+        /// <summary>
+        /// Read the index of a world, ids up to the highest one in it are reserved so nothing made at runtime takes them
+        /// </summary>
+        bool Open(const char* baseName);
+
+        /// <summary>
+        /// Take every cell out of the set, loads that are under way are finished first so nothing is left behind
+        /// </summary>
+        void Close();
+
+        inline bool IsOpen() const { return !Cells.empty(); }
+
+        /// <summary>
+        /// Stream around the camera, CameraEntity if it is set or else the first active CameraComponent
+        /// </summary>
+        void Update(double budgetMs);
+
+        /// <summary>
+        /// Stream around a point, call once a frame
+        /// </summary>
+        /// <param name="budgetMs">Main thread time to spend loading and unloading, a loading cell always gets one batch</param>
+        void Update(const Vector3& viewPosition, double budgetMs);
+
+        bool IsCellLoaded(const WorldCell& cell) const;
+        inline const Stats& GetStats() const { return CurrentStats; }
+        inline float GetCellSize() const { return CellSize; }
+
+        EntityId_t CameraEntity = InvalidEntityId;
+
+        float LoadRadius = 100;             // cells closer than this are loaded
+        float UnloadRadius = 150;           // and unloaded once they are further than this
+        size_t MaxConcurrentLoads = 2;
+        size_t MemoryBudgetBytes = size_t(256) * 1024 * 1024;
+
+    private:
+        enum class CellState
+        {
+            Unloaded,
+            Loading,
+            Loaded,
+            Unloading,
+            Failed,
+        };
+
+        struct Cell
+        {
+            CellRecord Record;
+            CellState State = CellState::Unloaded;
+            float Distance = 0;
+            std::unique_ptr<SceneFile::StreamingLoader> Loader;
+            std::vector<EntityId_t> Roots;  // left to remove while unloading
+            bool LoadFailed = false;
+        };
+
+        float GetDistance(const Cell& cell, const Vector3& position) const;
+        void StartLoad(Cell& cell);
+        void StartUnload(Cell& cell);
+        void MakeRoom(size_t bytes, const Vector3& position);
+        void UpdateStats();
+
+        EntitySet& Entities;
+        std::string BaseName;
+        float CellSize = 0;
+        std::map<WorldCell, Cell> Cells;
+        std::vector<Cell*> Resident;        // every cell that isn't unloaded
+        Vector3 LastViewPosition = { 0, 0, 0 };
+
+        Stats CurrentStats;
+    };
+}
@@ -0,0 +1,261 @@
+/**********************************************************************************************
+*
+*   raylib_ECS_sample * a sample Entity Component System using raylib
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+#include "world_snapshot.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <string.h>
+
+template<class T>
+static size_t GetCapacityBytes(const std::vector<T>& values)
+{
+    return values.capacity() * sizeof(T);
+}
+
+size_t WorldSnapshot::GetMemoryUsed() const
+{
+    size_t bytes = GetCapacityBytes(Entities) + GetCapacityBytes(Children) + GetCapacityBytes(NameText) + GetCapacityBytes(Blocks);
+    for (const TypeBlock& block : Blocks)
+        bytes += GetCapacityBytes(block.Components) + GetCapacityBytes(block.EntityIds) + GetCapacityBytes(block.Active) + GetCapacityBytes(block.Data);
+
+    return bytes;
+}
+
+void WorldSnapshot::Clear()
+{
+    Entities = std::vector<EntityRecord>();
+    Children = std::vector<EntityId_t>();
+    NameText = std::vector<char>();
+    Blocks = std::vector<TypeBlock>();
+    ExcludedEntities.clear();
+
+    Valid = false;
+    LastStats.MemoryBytes = 0;
+}
+
+void WorldSnapshot::Capture(EntitySet& entities)
+{
+    PROFILE_SCOPE("WorldSnapshot::Capture");
+    auto start = std::chrono::high_resolution_clock::now();
+
+    // the buffers are kept between captures, so playing again doesn't have to grow them
+    Entities.clear();
+    Children.clear();
+    NameText.assign(1, 0);
+    for (TypeBlock& block : Blocks)
+    {
+        block.Components.clear();
+        block.EntityIds.clear();
+        block.Active.clear();
+        block.Data.clear();
+    }
+
+    ExcludedEntities.clear();
+    for (size_t componentId : ExcludedComponents)
+        entities.DoForEachEntity(componentId, [this](Component* component) { ExcludedEntities.insert(component->EntityId); });
+
+    auto isExcluded = [this](EntityId_t id) { return !ExcludedEntities.empty() && ExcludedEntities.find(id) != ExcludedEntities.end(); };
+
+    // each distinct name is copied once, name ids are small so they index a flat list
+    const NameTable& names = entities.GetNameTable();
+    std::vector<uint32_t> nameOffsets;
+
+    Entities.reserve(entities.GetEntityCount());
+    entities.DoForEachEntityRecord([&](Entity& entity)
+        {
+            if (isExcluded(entity.Id))
+                return;
+
+            EntityRecord record;
+            record.Source = &entity;
+            record.Id = entity.Id;
+            record.Parent = entity.Parent;
+            record.FirstChild = uint32_t(Children.size());
+            record.ChildCount = uint32_t(entity.Children.size());
+            Children.insert(Children.end(), entity.Children.begin(), entity.Children.end());
+
+            if (entity.NameId != EmptyName)
+            {
+                if (entity.NameId >= nameOffsets.size())
+                    nameOffsets.resize(entity.NameId + 1, 0);
+
+                uint32_t& offset = nameOffsets[entity.NameId];
+                if (offset == 0)
+                {
+                    const char* text = names.Get(entity.NameId);
+                    offset = uint32_t(NameText.size());
+                    NameText.insert(NameText.end(), text, text + strlen(text) + 1);
+                }
+                record.Name = offset;
+            }
+
+            Entities.push_back(record);
+        });
+
+    size_t componentCount = 0;
+    TypeBlock* block = nullptr;
+    for (const auto& info : ComponentManager::GetComponentList())
+    {
+        entities.DoForEachEntity(info.first, [&](Component* component)
+            {
+                if (isExcluded(component->EntityId))
+                    return;
+
+                // tables are nearly always one type, so the block only changes when the type does
+                size_t typeId = component->TypeId();
+                if (block == nullptr || block->TypeId != typeId)
+                {
+                    auto itr = std::find_if(Blocks.begin(), Blocks.end(), [typeId](const TypeBlock& existing) { return existing.TypeId == typeId; });
+                    if (itr == Blocks.end())
+                    {
+                        Blocks.emplace_back();
+                        itr = Blocks.end() - 1;
+                        itr->TypeId = typeId;
+                        itr->Key = HashComponentName(component->ComponentName());
+                        itr->DataSize = component->GetDataSize();
+                    }
+                    block = &(*itr);
+                }
+
+                block->Components.push_back(component);
+                block->EntityIds.push_back(component->EntityId);
+                block->Active.push_back(component->Active ? 1 : 0);
+
+                if (block->DataSize > 0)
+                {
+                    size_t offset = block->Data.size();
+                    block->Data.resize(offset + block->DataSize);
+                    component->SaveData(block->Data.data() + offset);
+                }
+
+                componentCount++;
+            });
+    }
+
+    HierarchyGeneration = entities.GetHierarchyGeneration();
+    ComponentGeneration = entities.GetComponentGeneration();
+    Valid = true;
+
+    LastStats.Entities = Entities.size();
+    LastStats.Components = componentCount;
+    LastStats.CaptureMs = Profiler::MillisecondsSince(start);
+    LastStats.MemoryBytes = GetMemoryUsed();
+    LastStats.PeakMemoryBytes = std::max(LastStats.PeakMemoryBytes, LastStats.MemoryBytes + GetCapacityBytes(nameOffsets));
+}
+
+bool WorldSnapshot::Restore(EntitySet& entities)
+{
+    if (!Valid)
+        return false;
+
+    PROFILE_SCOPE("WorldSnapshot::Restore");
+    auto start = std::chrono::high_resolution_clock::now();
+
+    LastStats.RebuiltOnRestore = entities.GetHierarchyGeneration() != HierarchyGeneration || entities.GetComponentGeneration() != ComponentGeneration;
+    if (LastStats.RebuiltOnRestore)
+    {
+        Rebuild(entities);
+    }
+    else
+    {
+        // every captured entity and component is still alive, so the data goes straight back in place
+        for (TypeBlock& block : Blocks)
+        {
+            const uint8_t* data = block.Data.data();
+            for (size_t i = 0; i < block.Components.size(); i++)
+            {
+                Component* component = block.Components[i];
+                component->Active = block.Active[i] != 0;
+                if (block.DataSize > 0)
+                    component->LoadData(data + i * block.DataSize);
+            }
+        }
+
+        const NameTable& names = entities.GetNameTable();
+        for (const EntityRecord& record : Entities)
+        {
+            const char* name = NameText.data() + record.Name;
+            if (record.Source != nullptr && strcmp(names.Get(record.Source->NameId), name) != 0)
+                entities.SetEntityName(record.Id, name);
+        }
+
+        entities.MarkChanged();
+    }
+
+    LastStats.RestoreMs = Profiler::MillisecondsSince(start);
+    return true;
+}
+
+void WorldSnapshot::Rebuild(EntitySet& entities)
+{
+    PROFILE_SCOPE("WorldSnapshot::Rebuild");
+
+    entities.RemoveEntities([this](EntityId_t id) { return ExcludedEntities.find(id) == ExcludedEntities.end(); });
+
+    for (EntityRecord& record : Entities)
+    {
+        record.Source = entities.LoadEntity(record.Id, record.Parent, Children.data() + record.FirstChild, record.ChildCount);
+        if (record.Source != nullptr && record.Name != 0)
+            entities.SetEntityName(record.Id, NameText.data() + record.Name);
+    }
+
+    std::vector<Component*> created;
+    for (TypeBlock& block : Blocks)
+    {
+        const ComponentInfo* info = ComponentManager::FindComponentInfo(block.Key);
+        if (info == nullptr || block.EntityIds.empty())
+        {
+            block.Components.clear();
+            continue;
+        }
+
+        created.clear();
+        created.reserve(block.EntityIds.size());
+        for (size_t i = 0; i < block.EntityIds.size(); i++)
+        {
+            Component* component = info->Factory(block.EntityIds[i], entities);
+            component->Active = block.Active[i] != 0;
+            if (block.DataSize > 0)
+                component->LoadData(block.Data.data() + i * block.DataSize);
+
+            created.push_back(component);
+        }
+
+        entities.LoadComponents(created[0]->Id(), created.data(), created.size());
+
+        // the new components are what a later restore copies into
+        block.Components.swap(created);
+    }
+
+    HierarchyGeneration = entities.GetHierarchyGeneration();
+    ComponentGeneration = entities.GetComponentGeneration();
+
+    LastStats.PeakMemoryBytes = std::max(LastStats.PeakMemoryBytes, GetMemoryUsed() + GetCapacityBytes(created));
+}
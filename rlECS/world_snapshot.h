@@ -0,0 +1,110 @@
+/**********************************************************************************************
+*
+*   raylib_ECS_sample * a sample Entity Component System using raylib
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+#pragma once
+
+#include "entity_manager.h"
+
+#include <set>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+/// <summary>
+/// An in memory copy of an entity set that can be put back, used to undo everything a play session did
+/// Component data is copied as packed field records, grouped by type
+/// If no entities or components were added or removed since the capture, restoring copies the records
+/// straight back into the live components; otherwise the captured entities are rebuilt
+/// </summary>
+class WorldSnapshot
+{
+public:
+    struct Stats
+    {
+        size_t Entities = 0;
+        size_t Components = 0;
+
+        double CaptureMs = 0;
+        double RestoreMs = 0;
+        bool RebuiltOnRestore = false;
+
+        size_t MemoryBytes = 0;         // held by the snapshot now
+        size_t PeakMemoryBytes = 0;     // the most held at once, including scratch space used by restores
+    };
+
+    // entities with this component are left out of the capture and untouched by restores (editor cameras and the like)
+    template<class T>
+    inline void ExcludeEntitiesWith() { ExcludedComponents.insert(T::GetComponentId()); }
+
+    void Capture(EntitySet& entities);
+    bool Restore(EntitySet& entities);
+    void Clear();
+
+    inline bool IsValid() const { return Valid; }
+    inline const Stats& GetStats() const { return LastStats; }
+
+private:
+    struct EntityRecord
+    {
+        Entity* Source = nullptr;       // only valid while the hierarchy generation matches
+        EntityId_t Id = InvalidEntityId;
+        EntityId_t Parent = InvalidEntityId;
+        uint32_t FirstChild = 0;
+        uint32_t ChildCount = 0;
+        uint32_t Name = 0;              // offset into NameText, 0 is no name
+    };
+
+    struct TypeBlock
+    {
+        size_t TypeId = 0;
+        ComponentKey_t Key = 0;
+        size_t DataSize = 0;
+
+        std::vector<Component*> Components;   // only valid while the component generation matches
+        std::vector<EntityId_t> EntityIds;
+        std::vector<uint8_t> Active;
+        std::vector<uint8_t> Data;
+    };
+
+    void Rebuild(EntitySet& entities);
+    size_t GetMemoryUsed() const;
+
+    std::set<size_t> ExcludedComponents;
+    std::set<EntityId_t> ExcludedEntities;
+
+    std::vector<EntityRecord> Entities;
+    std::vector<EntityId_t> Children;
+    std::vector<char> NameText;
+    std::vector<TypeBlock> Blocks;
+
+    uint64_t HierarchyGeneration = 0;
+    uint64_t ComponentGeneration = 0;
+    bool Valid = false;
+
+    Stats LastStats;
+};